@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "ht_table.h"
+
+/*
+ * Μέτρηση των αναζητήσεων id που δεν υπάρχουν σε αρχείο σωρού και σε
+ * αρχείο κατακερματισμού, χωρίς και με φίλτρα Bloom. Τα αρχεία έχουν τα
+ * ζυγά id σε τυχαία σειρά, οπότε οι αναζητήσεις των μονών id δεν
+ * απορρίπτονται από τον χάρτη ζωνών του σωρού. Μετράει τον μέσο χρόνο και
+ * τα block που διαβάστηκαν ανά αναζήτηση, και το ποσοστό των αναζητήσεων
+ * που το φίλτρο δεν απέρριψε (λάθος θετικά).
+ *
+ * Χρήση: ./build/bloom_bench [records] [fp_rate]
+ */
+
+#define BENCH_HP "bloom_bench.hp"
+#define BENCH_HT "bloom_bench.ht"
+#define BENCH_MISSES 1000
+#define BENCH_FILTERED_MISSES 100000
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+typedef struct {
+    double seconds;
+    long long blocks;
+    int probes;
+    int passed;
+} Result;
+
+static void report(const char * label, const Result * r, int bloom) {
+    printf("%-10s misses %6d %10.3f us %8.2f blocks", label, r->probes,
+            r->seconds * 1e6 / r->probes, (double) r->blocks / r->probes);
+    if (bloom) {
+        printf("  false positives %.4f", (double) r->passed / r->probes);
+    }
+    printf(" \n");
+}
+
+static void unlink_heap(void) {
+    unlink(BENCH_HP);
+    unlink(BENCH_HP ".zone");
+    unlink(BENCH_HP ".bloom");
+}
+
+static Result bench_hp(const Record * records, int total, int bloom, double fp_rate) {
+    Result r = {0};
+
+    unlink_heap();
+    if (bloom) {
+        HP_CreateFileBloom(BENCH_HP, HP_LAYOUT_ROW, total, fp_rate);
+    } else {
+        HP_CreateFile(BENCH_HP);
+    }
+    HP_info* info = HP_OpenFile(BENCH_HP);
+    HP_BulkInsert(info, records, total);
+
+    r.probes = bloom ? BENCH_FILTERED_MISSES : BENCH_MISSES;
+    double start = now();
+    for (int k = 0; k < r.probes; k++) {
+        int blocks = HP_GetAllEntries(info, 2 * (int) ((long long) k * total / r.probes) + 1);
+        r.blocks += blocks;
+        r.passed += blocks > 1;
+    }
+    r.seconds = now() - start;
+
+    HP_CloseFile(info);
+    unlink_heap();
+    return r;
+}
+
+static Result bench_ht(const Record * records, int total, int bloom, double fp_rate) {
+    Result r = {0};
+    int buckets = 10;
+
+    unlink(BENCH_HT);
+    unlink(BENCH_HT ".bloom");
+    if (bloom) {
+        HT_CreateFileBloom(BENCH_HT, buckets, HT_LAYOUT_ROW, total, fp_rate);
+    } else {
+        HT_CreateFile(BENCH_HT, buckets);
+    }
+    HT_info* info = HT_OpenFile(BENCH_HT);
+    for (int k = 0; k < total; k++) {
+        HT_InsertEntry(info, records[k]);
+    }
+
+    r.probes = bloom ? BENCH_FILTERED_MISSES : BENCH_MISSES;
+    double start = now();
+    for (int k = 0; k < r.probes; k++) {
+        int blocks = HT_GetAllEntries(info, 2 * (int) ((long long) k * total / r.probes) + 1);
+        r.blocks += blocks;
+        r.passed += blocks > 1;
+    }
+    r.seconds = now() - start;
+
+    HT_CloseFile(info);
+    unlink(BENCH_HT);
+    unlink(BENCH_HT ".bloom");
+    return r;
+}
+
+int main(int argc, char ** argv) {
+    int total = argc > 1 ? atoi(argv[1]) : 100000;
+    double fp_rate = argc > 2 ? atof(argv[2]) : 0.01;
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = 2 * k;
+    }
+    for (int k = total - 1; k > 0; k--) {
+        int j = rand() % (k + 1);
+        int id = records[k].id;
+        records[k].id = records[j].id;
+        records[j].id = id;
+    }
+
+    BF_Init(LRU);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    Result hp = bench_hp(records, total, 0, fp_rate);
+    Result hp_bloom = bench_hp(records, total, 1, fp_rate);
+    Result ht = bench_ht(records, total, 0, fp_rate);
+    Result ht_bloom = bench_ht(records, total, 1, fp_rate);
+    fclose(stdout);
+    stdout = out;
+
+    printf("%d records, fp rate %g \n", total, fp_rate);
+    report("HP", &hp, 0);
+    report("HP bloom", &hp_bloom, 1);
+    report("HT", &ht, 0);
+    report("HT bloom", &ht_bloom, 1);
+
+    BF_Close();
+    free(records);
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "bf.h"
+#include "ht_table.h"
+#include "bpt_index.h"
+
+/*
+ * Σύγκριση του B+ δέντρου με το αρχείο κατακερματισμού στο id, με τα id σε
+ * τυχαία σειρά εισαγωγής. Μετράει τον χρόνο φόρτωσης (εισαγωγή μία μία και,
+ * για το δέντρο, BPT_BulkLoad από ταξινομημένη είσοδο), το μέγεθος του
+ * αρχείου, και για αναζητήσεις ισότητας και διαστήματος τον μέσο χρόνο και
+ * τα block που διαβάστηκαν. Το αρχείο κατακερματισμού έχει τους
+ * περισσότερους κάδους που χωράει η επικεφαλίδα του και δεν κάνει σαρώσεις
+ * διαστήματος.
+ *
+ * Πριν από τις μετρήσεις ελέγχει το δέντρο με πολλά ίσα id, συγκρίνοντας
+ * κάθε αναζήτηση ισότητας και την πλήρη σάρωση με την απλή καταμέτρηση των
+ * id που εισήχθησαν.
+ *
+ * Χρήση: ./build/bpt_bench [records] [block_size]
+ * Χωρίς ορίσματα τρέχει για 1M και 10M εγγραφές.
+ */
+
+#define BENCH_HT "bpt_bench.ht"
+#define BENCH_BPT "bpt_bench.bpt"
+#define BENCH_LOOKUPS 1000
+#define BENCH_RANGE 1000
+#define CHECK_IDS 100
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int compare_ids(const void * a, const void * b) {
+    int x = ((const Record *) a)->id, y = ((const Record *) b)->id;
+    return (x > y) - (x < y);
+}
+
+static long long file_blocks(const char * filename, int block_size) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? st.st_size / block_size : -1;
+}
+
+typedef struct {
+    double load;
+    double point;
+    double range;
+    long long blocks;
+    long long point_blocks;
+    long long range_blocks;
+    long long matches;
+} Result;
+
+static void report(const char * label, int total, const Result * r) {
+    printf("%-8s %9d records load %8.2f s %8lld blocks  id = v %8.3f ms %6.1f blocks",
+            label, total, r->load, r->blocks,
+            r->point * 1e3 / BENCH_LOOKUPS, (double) r->point_blocks / BENCH_LOOKUPS);
+    if (r->matches > 0) {
+        printf("  id range %8.3f ms %6.1f blocks", r->range * 1e3 / BENCH_LOOKUPS,
+                (double) r->range_blocks / BENCH_LOOKUPS);
+    }
+    printf(" \n");
+}
+
+/* Οι αναζητήσεις μοιράζονται σε όλη την σειρά εισαγωγής. */
+static int probe(const Record * records, int total, int k) {
+    return records[(long long) k * total / BENCH_LOOKUPS].id;
+}
+
+static Result bench_ht(const Record * records, int total, int block_size) {
+    Result r = {0};
+    int buckets = (block_size - sizeof (HT_info) - sizeof (int)) / sizeof (int);
+
+    unlink(BENCH_HT);
+    double start = now();
+    HT_CreateFile(BENCH_HT, buckets);
+    HT_info* info = HT_OpenFile(BENCH_HT);
+    for (int k = 0; k < total; k++) {
+        HT_InsertEntry(info, records[k]);
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        r.point_blocks += HT_GetAllEntries(info, probe(records, total, k));
+    }
+    r.point = now() - start;
+
+    HT_CloseFile(info);
+    r.blocks = file_blocks(BENCH_HT, block_size);
+    unlink(BENCH_HT);
+    return r;
+}
+
+static Result bench_bpt(const Record * records, int total, int block_size, int bulk) {
+    Result r = {0};
+
+    unlink(BENCH_BPT);
+    double start = now();
+    BPT_CreateFile(BENCH_BPT);
+    BPT_info* info = BPT_OpenFile(BENCH_BPT);
+    if (bulk) {
+        Record * sorted = malloc(sizeof (Record) * total);
+        memcpy(sorted, records, sizeof (Record) * total);
+        qsort(sorted, total, sizeof (Record), compare_ids);
+        BPT_BulkLoad(info, sorted, total);
+        free(sorted);
+    } else {
+        for (int k = 0; k < total; k++) {
+            BPT_InsertEntry(info, records[k]);
+        }
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        r.point_blocks += BPT_GetAllEntries(info, probe(records, total, k));
+    }
+    r.point = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        BPT_Scan * scan = BPT_ScanOpenRange(info, probe(records, total, k), probe(records, total, k) + BENCH_RANGE);
+        while (BPT_ScanNext(scan) != NULL) {
+            r.matches++;
+        }
+        r.range_blocks += BPT_ScanClose(scan);
+    }
+    r.range = now() - start;
+
+    BPT_CloseFile(info);
+    r.blocks = file_blocks(BENCH_BPT, block_size);
+    unlink(BENCH_BPT);
+    return r;
+}
+
+/* Εισάγει τα ids ένα ένα και συγκρίνει το δέντρο με το πλήθος κάθε id.
+ * Επιστρέφει το πλήθος των λαθών. */
+static int check_ids(const char * label, const int * ids, int total) {
+    int expected[CHECK_IDS] = {0};
+    int errors = 0;
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    unlink(BENCH_BPT);
+    BPT_CreateFile(BENCH_BPT);
+    BPT_info* info = BPT_OpenFile(BENCH_BPT);
+    for (int k = 0; k < total; k++) {
+        Record record = randomRecord();
+        record.id = ids[k];
+        BPT_InsertEntry(info, record);
+        expected[ids[k]]++;
+    }
+
+    for (int id = 0; id < CHECK_IDS; id++) {
+        int found = 0;
+        BPT_Scan * scan = BPT_ScanOpenRange(info, id, id);
+        const Record * record;
+        while ((record = BPT_ScanNext(scan)) != NULL) {
+            found += record->id == id ? 1 : CHECK_IDS * total;
+        }
+        BPT_ScanClose(scan);
+        if (found != expected[id]) {
+            errors++;
+        }
+    }
+
+    int found = 0, previous = -1;
+    BPT_Scan * scan = BPT_ScanOpenRange(info, 0, CHECK_IDS - 1);
+    const Record * record;
+    while ((record = BPT_ScanNext(scan)) != NULL) {
+        if (record->id < previous) {
+            errors++;
+        }
+        previous = record->id;
+        found++;
+    }
+    BPT_ScanClose(scan);
+    if (found != total) {
+        errors++;
+    }
+
+    BPT_CloseFile(info);
+    unlink(BENCH_BPT);
+    fclose(stdout);
+    stdout = out;
+    printf("check %-12s %6d records %s \n", label, total, errors ? "FAILED" : "ok");
+    return errors;
+}
+
+/* Σενάρια με πολλά ίσα id, όπου ένα φύλλο χωρίζεται με πρώτο id ίσο με
+ * κλειδί που υπάρχει ήδη στον πατέρα. */
+static int check(void) {
+    const int total = 60 * CHECK_IDS;
+    int * ids = malloc(sizeof (int) * total);
+    int errors = 0;
+    int n = 0;
+
+    for (int k = 0; k < 54; k++) {
+        ids[n++] = 5;
+    }
+    for (int k = 0; k < 27; k++) {
+        ids[n++] = k % 5;
+    }
+    ids[n++] = 6;
+    errors += check_ids("split", ids, n);
+
+    n = 0;
+    for (int id = CHECK_IDS - 1; id >= 0; id--) {
+        for (int k = 0; k < 60; k++) {
+            ids[n++] = id;
+        }
+    }
+    errors += check_ids("descending", ids, n);
+
+    srand(12569874);
+    for (n = 0; n < total; n++) {
+        ids[n] = rand() % CHECK_IDS;
+    }
+    errors += check_ids("random", ids, n);
+
+    free(ids);
+    return errors;
+}
+
+static void bench(int total, int block_size) {
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+    for (int k = total - 1; k > 0; k--) {
+        int j = rand() % (k + 1);
+        int id = records[k].id;
+        records[k].id = records[j].id;
+        records[j].id = id;
+    }
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    Result ht = bench_ht(records, total, block_size);
+    Result insert = bench_bpt(records, total, block_size, 0);
+    Result bulk = bench_bpt(records, total, block_size, 1);
+    fclose(stdout);
+    stdout = out;
+
+    report("HT", total, &ht);
+    report("BPT", total, &insert);
+    report("BPT bulk", total, &bulk);
+    free(records);
+}
+
+int main(int argc, char ** argv) {
+    int block_size = argc > 2 ? atoi(argv[2]) : 4096;
+
+    BF_InitEx(LRU, block_size, 1024, BF_DEFAULT);
+
+    if (check() != 0) {
+        BF_Close();
+        return 1;
+    }
+
+    if (argc > 1) {
+        bench(atoi(argv[1]), block_size);
+    } else {
+        bench(1000000, block_size);
+        bench(10000000, block_size);
+    }
+
+    BF_Close();
+    return 0;
+}
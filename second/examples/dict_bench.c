@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "ht_table.h"
+#include "sht_table.h"
+
+/*
+ * Σύγκριση εγγραφών με τα name, surname και city ως χαρακτήρες (ROW) και
+ * ως κωδικούς λεξικού (DICT). Στο αρχείο σωρού μετράει τα block και τον
+ * χρόνο μιας σάρωσης ισότητας στο surname με την HP_ScanOpenEquals, για
+ * μια τιμή που υπάρχει και μία που δεν υπάρχει. Στο αρχείο
+ * κατακερματισμού με δευτερεύον ευρετήριο στο surname μετράει τον χρόνο
+ * της SHT_SecondaryGetAllEntries.
+ *
+ * Χρήση: ./build/dict_bench [hp_records] [ht_records]
+ */
+
+#define BENCH_HP "dict_bench.hp"
+#define BENCH_HT "dict_bench.ht"
+#define BENCH_SHT "dict_bench.sht"
+#define BENCH_BLOCK_SIZE 4096
+#define BENCH_BUCKETS 100
+#define BENCH_SCANS 10
+#define BENCH_VALUE "Svingos"
+#define BENCH_MISSING "Papadopoulos"
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+typedef struct {
+    double load;
+    double scan;
+    double missing;
+    long long blocks;
+    long long scan_blocks;
+    long long missing_blocks;
+    long long matches;
+} Result;
+
+static long long fileBlocks(const char * fileName) {
+    struct stat st;
+    if (stat(fileName, &st) != 0) {
+        return 0;
+    }
+    return st.st_size / BENCH_BLOCK_SIZE;
+}
+
+static void unlink_heap(void) {
+    unlink(BENCH_HP);
+    unlink(BENCH_HP ".zone");
+    unlink(BENCH_HP ".dict");
+}
+
+static void unlink_hash(void) {
+    unlink(BENCH_HT);
+    unlink(BENCH_HT ".dict");
+    unlink(BENCH_SHT);
+}
+
+static Result bench_hp(const Record * records, int total, int layout) {
+    Result r = {0};
+
+    unlink_heap();
+    double start = now();
+    HP_CreateFileEx(BENCH_HP, layout);
+    HP_info* info = HP_OpenFile(BENCH_HP);
+    HP_BulkInsert(info, records, total);
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_SCANS; k++) {
+        HP_Scan * scan = HP_ScanOpenEquals(info, SURNAME, BENCH_VALUE);
+        while (HP_ScanNext(scan) != NULL) {
+            r.matches++;
+        }
+        r.scan_blocks += HP_ScanClose(scan);
+    }
+    r.scan = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_SCANS; k++) {
+        HP_Scan * scan = HP_ScanOpenEquals(info, SURNAME, BENCH_MISSING);
+        while (HP_ScanNext(scan) != NULL) {
+            r.matches++;
+        }
+        r.missing_blocks += HP_ScanClose(scan);
+    }
+    r.missing = now() - start;
+
+    HP_CloseFile(info);
+    r.blocks = fileBlocks(BENCH_HP);
+    unlink_heap();
+    return r;
+}
+
+static Result bench_sht(const Record * records, int total, int layout) {
+    Result r = {0};
+
+    unlink_hash();
+    double start = now();
+    HT_CreateFileEx(BENCH_HT, BENCH_BUCKETS, layout);
+    SHT_CreateSecondaryIndex(BENCH_SHT, "surname", BENCH_BUCKETS, BENCH_HT);
+    HT_info* info = HT_OpenFile(BENCH_HT);
+    SHT_info* index_info = SHT_OpenSecondaryIndex(BENCH_SHT);
+    for (int k = 0; k < total; k++) {
+        int block_id = HT_InsertEntry(info, records[k]);
+        SHT_SecondaryInsertEntry(index_info, records[k], block_id);
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_SCANS; k++) {
+        r.scan_blocks += SHT_SecondaryGetAllEntries(info, index_info, BENCH_VALUE);
+    }
+    r.scan = now() - start;
+
+    SHT_CloseSecondaryIndex(index_info);
+    HT_CloseFile(info);
+    r.blocks = fileBlocks(BENCH_HT);
+    unlink_hash();
+    return r;
+}
+
+static void report_hp(const char * label, const Result * r) {
+    printf("%-8s %8lld blocks  load %6.2f s  surname = v %8.3f ms %8.1f blocks  missing value %8.3f ms %8.1f blocks  (matches %lld) \n",
+            label, r->blocks, r->load, r->scan * 1e3 / BENCH_SCANS, (double) r->scan_blocks / BENCH_SCANS,
+            r->missing * 1e3 / BENCH_SCANS, (double) r->missing_blocks / BENCH_SCANS, r->matches / BENCH_SCANS);
+}
+
+static void report_sht(const char * label, const Result * r) {
+    printf("%-8s %8lld blocks  load %6.2f s  SHT surname = v %8.3f ms %8.1f index blocks \n",
+            label, r->blocks, r->load, r->scan * 1e3 / BENCH_SCANS, (double) r->scan_blocks / BENCH_SCANS);
+}
+
+int main(int argc, char ** argv) {
+    int hp_total = argc > 1 ? atoi(argv[1]) : 1000000;
+    int ht_total = argc > 2 ? atoi(argv[2]) : 100000;
+    int total = hp_total > ht_total ? hp_total : ht_total;
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+
+    BF_InitEx(LRU, BENCH_BLOCK_SIZE, 1024, BF_DEFAULT);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    Result hp_row = bench_hp(records, hp_total, HP_LAYOUT_ROW);
+    Result hp_dict = bench_hp(records, hp_total, HP_LAYOUT_DICT);
+    Result ht_row = bench_sht(records, ht_total, HT_LAYOUT_ROW);
+    Result ht_dict = bench_sht(records, ht_total, HT_LAYOUT_DICT);
+    fclose(stdout);
+    stdout = out;
+
+    printf("HP %d records \n", hp_total);
+    report_hp("row", &hp_row);
+    report_hp("dict", &hp_dict);
+    printf("HT + SHT %d records \n", ht_total);
+    report_sht("row", &ht_row);
+    report_sht("dict", &ht_dict);
+
+    BF_Close();
+    free(records);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bf.h"
+
+/*
+ * Σύγκριση κανονικής I/O και BF_DIRECT_IO πάνω σε αρχείο μεγαλύτερο από
+ * την μνήμη του μηχανήματος. Για κάθε τρόπο μετράει τυχαίες αναγνώσεις
+ * block για ορισμένο χρόνο και μια σειριακή σάρωση με την BF_GetBlocks, και
+ * τυπώνει το RSS της διεργασίας και πόσο μεγάλωσε η cache του λειτουργικού.
+ *
+ * Χρήση: ./build/direct_bench [MB] [seconds] [pool_MB]
+ */
+
+#define BENCH_FILE "direct_bench.db"
+#define BENCH_BLOCK 4096
+#define BENCH_BATCH 64
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static long meminfo_kb(const char * path, const char * field) {
+    char line[256];
+    long value = -1;
+    FILE * f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof (line), f) != NULL) {
+        if (strncmp(line, field, strlen(field)) == 0) {
+            value = atol(line + strlen(field));
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+static void drop_cache(const char * filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void create_file(const char * filename, long long bytes) {
+    if (access(filename, F_OK) == 0) {
+        return;
+    }
+
+    size_t chunk = 1 << 20;
+    char * buffer = malloc(chunk);
+    int fd = open(filename, O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+    for (long long written = 0; written < bytes; written += chunk) {
+        for (size_t k = 0; k < chunk; k += BENCH_BLOCK) {
+            long long block = (written + k) / BENCH_BLOCK;
+            memcpy(buffer + k, &block, sizeof (block));
+        }
+        if (write(fd, buffer, chunk) != (ssize_t) chunk) {
+            perror("write");
+            exit(1);
+        }
+    }
+
+    fsync(fd);
+    close(fd);
+    free(buffer);
+}
+
+static void run(const char * label, int flags, double seconds, int frames) {
+    BF_BlockHandle handles[BENCH_BATCH];
+    BF_Block *blocks[BENCH_BATCH];
+    int block_nums[BENCH_BATCH];
+    int fd, count;
+
+    for (int k = 0; k < BENCH_BATCH; k++) {
+        BF_Block_InitInPlace(&handles[k], &blocks[k]);
+    }
+
+    drop_cache(BENCH_FILE);
+    long cached = meminfo_kb("/proc/meminfo", "Cached:");
+
+    BF_InitEx(LRU, BENCH_BLOCK, frames, flags);
+    BF_OpenFile(BENCH_FILE, &fd);
+    BF_GetBlockCounter(fd, &count);
+
+    unsigned int seed = 12569874;
+    long reads = 0;
+    double start = now();
+    while (now() - start < seconds) {
+        for (int k = 0; k < 1000; k++) {
+            BF_GetBlock(fd, rand_r(&seed) % count, blocks[0]);
+            BF_UnpinBlock(blocks[0]);
+        }
+        reads += 1000;
+    }
+    double random_time = now() - start;
+
+    long scanned = 0;
+    start = now();
+    for (int first = 0; first < count && now() - start < seconds; first += BENCH_BATCH) {
+        int n = count - first < BENCH_BATCH ? count - first : BENCH_BATCH;
+        for (int k = 0; k < n; k++) {
+            block_nums[k] = first + k;
+        }
+        BF_GetBlocks(fd, block_nums, n, blocks);
+        for (int k = 0; k < n; k++) {
+            BF_UnpinBlock(blocks[k]);
+        }
+        scanned += n;
+    }
+    double scan_time = now() - start;
+
+    long rss = meminfo_kb("/proc/self/status", "VmRSS:");
+    long cache_growth = meminfo_kb("/proc/meminfo", "Cached:") - cached;
+
+    printf("%-9s random %9.0f reads/s  scan %8.1f MB/s  RSS %7ld MB  page cache +%7ld MB \n",
+            label, reads / random_time, scanned * (double) BENCH_BLOCK / (1 << 20) / scan_time,
+            rss / 1024, cache_growth / 1024);
+
+    BF_CloseFile(fd);
+    BF_Close();
+}
+
+int main(int argc, char ** argv) {
+    long long megabytes = argc > 1 ? atoll(argv[1]) : 8192;
+    double seconds = argc > 2 ? atof(argv[2]) : 20;
+    int pool_mb = argc > 3 ? atoi(argv[3]) : 512;
+    int frames = (int) (((long long) pool_mb << 20) / BENCH_BLOCK);
+
+    create_file(BENCH_FILE, megabytes << 20);
+
+    run("buffered", BF_DEFAULT, seconds, frames);
+    run("O_DIRECT", BF_DIRECT_IO, seconds, frames);
+
+    return 0;
+}
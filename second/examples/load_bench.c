@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+
+/*
+ * Σύγκριση της φόρτωσης ενός αρχείου σωρού με την HP_InsertEntry (μία
+ * εγγραφή την φορά) και με την HP_BulkInsert. Ο χρόνος περιλαμβάνει το
+ * κλείσιμο του αρχείου και το fdatasync του. Στο τέλος ελέγχεται ότι τα δύο
+ * αρχεία είναι ίδια.
+ *
+ * Χρήση: ./build/load_bench [MB] [records_per_call]
+ */
+
+#define BENCH_ROWS "load_bench_rows.db"
+#define BENCH_BULK "load_bench_bulk.db"
+#define BENCH_CHUNK 65536
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void sync_file(const char * filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        close(fd);
+    }
+}
+
+static void fill(Record * records, long long first, int n) {
+    for (int k = 0; k < n; k++) {
+        records[k] = randomRecord();
+        records[k].id = (int) (first + k);
+    }
+}
+
+static void load(const char * filename, long long total, int per_call, const char * label) {
+    Record * records = malloc(sizeof (Record) * BENCH_CHUNK);
+    double seconds = 0;
+
+    srand(12569874);
+    unlink(filename);
+    BF_Init(LRU);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+
+    HP_CreateFile((char *) filename);
+    HP_info* info = HP_OpenFile((char *) filename);
+    for (long long first = 0; first < total; first += BENCH_CHUNK) {
+        int n = total - first < BENCH_CHUNK ? (int) (total - first) : BENCH_CHUNK;
+        fill(records, first, n);
+
+        double start = now();
+        if (per_call == 0) {
+            for (int k = 0; k < n; k++) {
+                HP_InsertEntry(info, records[k]);
+            }
+        } else {
+            for (int k = 0; k < n; k += per_call) {
+                HP_BulkInsert(info, records + k, n - k < per_call ? n - k : per_call);
+            }
+        }
+        seconds += now() - start;
+    }
+
+    double start = now();
+    HP_CloseFile(info);
+    BF_Close();
+    sync_file(filename);
+    seconds += now() - start;
+
+    fclose(stdout);
+    stdout = out;
+
+    double mb = (double) total * sizeof (Record) / (1 << 20);
+    printf("%-22s %10lld records %8.2f s %12.0f records/s %8.1f MB/s \n",
+            label, total, seconds, total / seconds, mb / seconds);
+    free(records);
+}
+
+static int same_files(const char * a, const char * b) {
+    FILE * fa = fopen(a, "rb");
+    FILE * fb = fopen(b, "rb");
+    char ba[1 << 16], bb[1 << 16];
+    int same = fa != NULL && fb != NULL;
+    while (same) {
+        size_t na = fread(ba, 1, sizeof (ba), fa);
+        size_t nb = fread(bb, 1, sizeof (bb), fb);
+        same = na == nb && memcmp(ba, bb, na) == 0;
+        if (na == 0) {
+            break;
+        }
+    }
+    if (fa != NULL) {
+        fclose(fa);
+    }
+    if (fb != NULL) {
+        fclose(fb);
+    }
+    return same;
+}
+
+int main(int argc, char ** argv) {
+    long long megabytes = argc > 1 ? atoll(argv[1]) : 256;
+    int per_call = argc > 2 ? atoi(argv[2]) : 4096;
+    long long total = (megabytes << 20) / sizeof (Record);
+    char label[64];
+
+    load(BENCH_ROWS, total, 0, "HP_InsertEntry");
+    snprintf(label, sizeof (label), "HP_BulkInsert x%d", per_call);
+    load(BENCH_BULK, total, per_call, label);
+
+    printf("files %s \n", same_files(BENCH_ROWS, BENCH_BULK) ? "identical" : "DIFFER");
+
+    unlink(BENCH_ROWS);
+    unlink(BENCH_BULK);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "ht_table.h"
+
+/*
+ * Μέτρηση του κόστους αναζήτησης στον πίνακα σελίδων του επιπέδου BF, όταν
+ * όλα τα block βρίσκονται ήδη στην ενδιάμεση μνήμη (hits), και της
+ * HT_GetAllEntries πάνω σε αρχείο που χωράει ολόκληρο στην μνήμη. Κάθε
+ * μέτρηση γίνεται με την ενδιάμεση μνήμη (pool) και με mmap.
+ *
+ * Χρήση: ./build/lookup_bench [block_count] [lookups]
+ */
+
+#define BENCH_FILE "lookup_bench.db"
+#define BENCH_HT "lookup_bench.ht"
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static const char * mode_name(BF_FileMode mode) {
+    return mode == BF_FILE_MMAP ? "mmap" : "pool";
+}
+
+static void bench_get_block(int blocks, long lookups, BF_FileMode mode) {
+    BF_BlockHandle handle;
+    BF_Block *block;
+    int fd;
+
+    BF_Block_InitInPlace(&handle, &block);
+    BF_InitEx(LRU, BF_BLOCK_SIZE, blocks, BF_DEFAULT);
+
+    unlink(BENCH_FILE);
+    BF_CreateFile(BENCH_FILE);
+    BF_OpenFileEx(BENCH_FILE, &fd, mode);
+    for (int i = 0; i < blocks; i++) {
+        BF_AllocateBlock(fd, block);
+        BF_UnpinBlock(block);
+    }
+
+    int * order = malloc(sizeof (int) * lookups);
+    unsigned int seed = 12569874;
+    for (long k = 0; k < lookups; k++) {
+        order[k] = rand_r(&seed) % blocks;
+    }
+
+    double start = now();
+    for (long k = 0; k < lookups; k++) {
+        BF_GetBlock(fd, order[k], block);
+        BF_UnpinBlock(block);
+    }
+    double seconds = now() - start;
+
+    BF_Stats stats;
+    BF_GetStats(fd, &stats);
+    printf("BF_GetBlock %-5s %8d blocks %10ld lookups %8.1f ns/lookup (hits %llu) \n",
+            mode_name(mode), blocks, lookups, seconds * 1e9 / lookups, stats.hits);
+
+    free(order);
+    BF_CloseFile(fd);
+    BF_Close();
+    unlink(BENCH_FILE);
+}
+
+static void bench_ht(int records, int lookups, BF_FileMode mode) {
+    BF_InitEx(LRU, BF_BLOCK_SIZE, records, BF_DEFAULT);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+
+    unlink(BENCH_HT);
+    HT_CreateFile(BENCH_HT, 10);
+    HT_info* info = HT_OpenFileEx(BENCH_HT, mode);
+    for (int id = 0; id < records; id++) {
+        Record record = randomRecord();
+        record.id = id;
+        HT_InsertEntry(info, record);
+    }
+    for (int id = 0; id < records; id++) {
+        HT_GetAllEntries(info, id);
+    }
+
+    double start = now();
+    for (int k = 0; k < lookups; k++) {
+        HT_GetAllEntries(info, rand() % records);
+    }
+    double seconds = now() - start;
+
+    fclose(stdout);
+    stdout = out;
+
+    printf("HT_GetAllEntries %-5s %8d records %9d lookups %8.1f us/lookup \n",
+            mode_name(mode), records, lookups, seconds * 1e6 / lookups);
+
+    HT_CloseFile(info);
+    BF_Close();
+    unlink(BENCH_HT);
+}
+
+int main(int argc, char ** argv) {
+    int blocks = argc > 1 ? atoi(argv[1]) : 65536;
+    long lookups = argc > 2 ? atol(argv[2]) : 20000000;
+
+    srand(12569874);
+
+    for (BF_FileMode mode = BF_FILE_POOL; mode <= BF_FILE_MMAP; mode++) {
+        bench_get_block(1024, lookups, mode);
+        bench_get_block(blocks, lookups, mode);
+        bench_ht(10000, 2000, mode);
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+
+/*
+ * Μέτρηση της HP_ScanParallel για διάφορα πλήθη νημάτων πάνω σε αρχείο
+ * σωρού που βρίσκεται ολόκληρο στην ενδιάμεση μνήμη, ώστε να μετράει η
+ * επεξεργασία των εγγραφών και όχι ο δίσκος. Η σάρωση ψάχνει εγγραφές με
+ * συγκεκριμένη πόλη και η callback τις μετράει με ατομικό μετρητή. Κάθε
+ * γραμμή ελέγχει ότι βρέθηκαν όσες και με ένα νήμα.
+ *
+ * Χρήση: ./build/parallel_bench [records] [max_threads]
+ */
+
+#define BENCH_FILE "parallel_bench.db"
+#define BENCH_BLOCK_SIZE 4096
+#define BENCH_REPEAT 5
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int in_city(const Record *record, void *arg) {
+    return strcmp(record->city, (const char *) arg) == 0;
+}
+
+static int count_match(const Record *record, void *arg) {
+    atomic_fetch_add_explicit((atomic_llong *) arg, 1, memory_order_relaxed);
+    return 0;
+}
+
+int main(int argc, char ** argv) {
+    int total = argc > 1 ? atoi(argv[1]) : 2000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 2 * (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+
+    int frames = (int) ((long long) total * sizeof (Record) / (BENCH_BLOCK_SIZE - 64)) + 64 * max_threads + 1024;
+    BF_InitEx(LRU, BENCH_BLOCK_SIZE, frames, BF_CONCURRENT);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    unlink(BENCH_FILE);
+    HP_CreateFile(BENCH_FILE);
+    HP_info* info = HP_OpenFile(BENCH_FILE);
+    HP_BulkInsert(info, records, total);
+    fclose(stdout);
+    stdout = out;
+
+    const char * city = records[0].city;
+    atomic_llong expected = 0;
+    int blocks = HP_ScanEach(info, in_city, (void *) city, count_match, &expected);
+    printf("%d records, %d blocks, %lld in %s, %ld cpus \n",
+            total, blocks, (long long) expected, city, sysconf(_SC_NPROCESSORS_ONLN));
+
+    double single = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double best = 0;
+        atomic_llong matches = 0;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            atomic_store(&matches, 0);
+            double start = now();
+            blocks = HP_ScanParallel(info, in_city, (void *) city, count_match, &matches, threads);
+            double seconds = now() - start;
+            if (r == 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+        if (threads == 1) {
+            single = best;
+        }
+        printf("threads %3d %8.2f ms %8.1f Mrecords/s %8.1f MB/s speedup %5.2f  blocks %d  %s \n",
+                threads, best * 1e3, total / best / 1e6, (double) blocks * BENCH_BLOCK_SIZE / best / (1 << 20),
+                single / best, blocks, atomic_load(&matches) == expected ? "OK" : "WRONG");
+    }
+
+    HP_CloseFile(info);
+    BF_Close();
+    unlink(BENCH_FILE);
+    unlink(BENCH_FILE ".zone");
+    free(records);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+
+/*
+ * Σύγκριση της σάρωσης αρχείου σωρού με την μορφή γραμμών και την μορφή
+ * PAX, όταν όλα τα block βρίσκονται στην ενδιάμεση μνήμη. Μετράει
+ * αναζητήσεις ισότητας και διαστήματος στο id με την HP_ScanOpenRange και
+ * μια σάρωση με κατηγόρημα στο όνομα της πόλης, και ελέγχει ότι οι δύο
+ * μορφές δίνουν τα ίδια αποτελέσματα. Με τα id σε αύξουσα σειρά οι
+ * αναζητήσεις στο id περιορίζονται από τον χάρτη ζωνών, ενώ με
+ * ανακατεμένα id διαβάζεται όλο το αρχείο.
+ *
+ * Χρήση: ./build/pax_bench [records] [block_size]
+ */
+
+#define BENCH_ROW "pax_bench_row.db"
+#define BENCH_PAX "pax_bench_pax.db"
+#define BENCH_LOOKUPS 200
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int in_city(const Record *record, void *arg) {
+    return strcmp(record->city, (const char *) arg) == 0;
+}
+
+static long long count_range(HP_info* info, int low, int high, long long *checksum) {
+    long long matches = 0;
+    HP_Scan * scan = HP_ScanOpenRange(info, low, high);
+    const Record * record;
+    while ((record = HP_ScanNext(scan)) != NULL) {
+        matches++;
+        *checksum += record->id + record->name[0];
+    }
+    HP_ScanClose(scan);
+    return matches;
+}
+
+static void bench(const char * filename, int layout, const Record * records, int total, const char * order) {
+    char zone[64];
+    snprintf(zone, sizeof (zone), "%s.zone", filename);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+
+    unlink(filename);
+    HP_CreateFileEx((char *) filename, layout);
+    HP_info* info = HP_OpenFile((char *) filename);
+    HP_BulkInsert(info, records, total);
+
+    long long checksum = 0, matches = 0;
+    count_range(info, 0, total, &checksum);
+
+    double start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        int id = (int) ((long long) k * total / BENCH_LOOKUPS);
+        matches += count_range(info, id, id, &checksum);
+    }
+    double point = (now() - start) / BENCH_LOOKUPS;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS / 10; k++) {
+        int low = (int) ((long long) k * total / (BENCH_LOOKUPS / 10));
+        matches += count_range(info, low, low + total / 100, &checksum);
+    }
+    double range = (now() - start) / (BENCH_LOOKUPS / 10);
+
+    long long city = 0;
+    start = now();
+    HP_Scan * scan = HP_ScanOpen(info, in_city, (void *) records[0].city);
+    while (HP_ScanNext(scan) != NULL) {
+        city++;
+    }
+    int blocks = HP_ScanClose(scan);
+    double predicate = now() - start;
+
+    HP_CloseFile(info);
+    fclose(stdout);
+    stdout = out;
+
+    printf("%-8s %-4s %6d blocks  id = v %8.2f ms %6.2f ns/record  id range 1%% %8.2f ms  city scan %8.2f ms  (matches %lld city %lld checksum %lld) \n",
+            order, layout == HP_LAYOUT_PAX ? "PAX" : "row", blocks, point * 1e3, point * 1e9 / total,
+            range * 1e3, predicate * 1e3, matches, city, checksum);
+    unlink(filename);
+    unlink(zone);
+}
+
+int main(int argc, char ** argv) {
+    int total = argc > 1 ? atoi(argv[1]) : 1000000;
+    int block_size = argc > 2 ? atoi(argv[2]) : 4096;
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+
+    int frames = (int) ((long long) total * sizeof (Record) / (block_size - 64)) * 2 + 64;
+    BF_InitEx(LRU, block_size, frames, BF_DEFAULT);
+    bench(BENCH_ROW, HP_LAYOUT_ROW, records, total, "ordered");
+    bench(BENCH_PAX, HP_LAYOUT_PAX, records, total, "ordered");
+
+    for (int k = total - 1; k > 0; k--) {
+        int j = rand() % (k + 1);
+        int id = records[k].id;
+        records[k].id = records[j].id;
+        records[j].id = id;
+    }
+    bench(BENCH_ROW, HP_LAYOUT_ROW, records, total, "shuffled");
+    bench(BENCH_PAX, HP_LAYOUT_PAX, records, total, "shuffled");
+    BF_Close();
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+
+/*
+ * Μέτρηση της πλήρους σάρωσης ενός αρχείου σωρού με και χωρίς σειριακή
+ * προανάγνωση. Το αρχείο δημιουργείται μία φορά (μέγεθος σε MB από το
+ * πρώτο όρισμα) και πριν από κάθε σάρωση αφαιρείται από την cache του
+ * λειτουργικού, ώστε να διαβάζεται από τον δίσκο.
+ *
+ * Χρήση: ./build/scan_bench [MB] [block_size]
+ */
+
+#define BENCH_FILE "scan_bench.db"
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void drop_cache(char * filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void create_heap(char * filename, long long bytes, int block_size) {
+    if (access(filename, F_OK) == 0) {
+        return;
+    }
+
+    BF_InitEx(LRU, block_size, BF_BUFFER_SIZE, BF_DEFAULT);
+    HP_CreateFile(filename);
+    HP_info* info = HP_OpenFile(filename);
+    long long records = bytes / sizeof (Record);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    for (long long id = 0; id < records; id++) {
+        Record record = randomRecord();
+        record.id = (int) id;
+        HP_InsertEntry(info, record);
+    }
+    fclose(stdout);
+    stdout = out;
+
+    HP_CloseFile(info);
+    BF_Close();
+}
+
+static int count_all(const Record *record, void *arg) {
+    (void) record;
+    ++*(long long *) arg;
+    return 0;
+}
+
+static void scan_heap(char * filename, int block_size, int flags, char * label) {
+    BF_InitEx(LRU, block_size, BF_BUFFER_SIZE, flags);
+    HP_info* info = HP_OpenFile(filename);
+
+    drop_cache(filename);
+
+    long long records = 0;
+    double start = now();
+    int blocks = HP_ScanEach(info, NULL, NULL, count_all, &records);
+    double seconds = now() - start;
+    double mb = (double) blocks * block_size / (1 << 20);
+
+    printf("%-14s %10d blocks %10.0f MB %8.2f s %10.1f MB/s \n", label, blocks, mb, seconds, mb / seconds);
+
+    HP_CloseFile(info);
+    BF_Close();
+}
+
+int main(int argc, char ** argv) {
+    long long megabytes = argc > 1 ? atoll(argv[1]) : 2048;
+    int block_size = argc > 2 ? atoi(argv[2]) : 4096;
+
+    srand(12569874);
+
+    create_heap(BENCH_FILE, megabytes << 20, block_size);
+
+    for (int run = 0; run < 2; run++) {
+        scan_heap(BENCH_FILE, block_size, BF_DEFAULT, "readahead off");
+        scan_heap(BENCH_FILE, block_size, BF_READAHEAD, "readahead on");
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bf.h"
+#include "sf_file.h"
+
+#define RECORDS_NUM 1000 // you can change it if you want
+#define DELTA_BLOCKS 4
+#define FILE_NAME "data.sf"
+
+int main() {
+  BF_Init(LRU);
+
+  SF_CreateFile(FILE_NAME, DELTA_BLOCKS);
+  SF_info* info = SF_OpenFile(FILE_NAME);
+
+  Record record;
+  srand(12569874);
+  printf("Insert Entries\n");
+  for (int id = 0; id < RECORDS_NUM; ++id) {
+    record = randomRecord();
+    record.id = rand() % RECORDS_NUM;
+    SF_InsertEntry(info, record);
+  }
+
+  printf("RUN PrintAllEntries\n");
+  int id = rand() % RECORDS_NUM;
+  printf("\nSearching for: %d\n",id);
+  int blocks = SF_GetAllEntries(info, id);
+  printf("Blocks read: %d\n", blocks);
+
+  printf("\nRange %d - %d\n", id, id + 10);
+  SF_Scan* scan = SF_ScanOpenRange(info, id, id + 10);
+  const Record* found;
+  while ((found = SF_ScanNext(scan)) != NULL) {
+    printRecord(*found);
+  }
+  printf("Blocks read: %d\n", SF_ScanClose(scan));
+
+  SF_CloseFile(info);
+  BF_Close();
+}
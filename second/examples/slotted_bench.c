@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "ht_table.h"
+
+/*
+ * Σύγκριση της πυκνότητας των μορφών block: εγγραφές σταθερού μήκους
+ * (ROW, PAX) και εγγραφές μεταβλητού μήκους με κατάλογο θέσεων (SLOTTED),
+ * σε αρχείο σωρού και σε αρχείο κατακερματισμού. Μετράει τα block του
+ * αρχείου, τις εγγραφές ανά block, τα block ανά εκατομμύριο εγγραφές και
+ * τους χρόνους φόρτωσης και πλήρους σάρωσης.
+ *
+ * Χρήση: ./build/slotted_bench [records] [block_size]
+ */
+
+#define BENCH_HP "slotted_bench.hp"
+#define BENCH_HT "slotted_bench.ht"
+#define BENCH_BUCKETS 100
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+typedef struct {
+    double load;
+    double scan;
+    long long blocks;
+    long long scanned;
+} Result;
+
+static long long fileBlocks(const char * fileName, int block_size) {
+    struct stat st;
+    if (stat(fileName, &st) != 0) {
+        return 0;
+    }
+    return st.st_size / block_size;
+}
+
+static void report(const char * label, const Result * r, int total) {
+    printf("%-10s %8lld blocks %8.1f records/block %9.0f blocks/1M  load %7.2f s  scan %7.3f s  (records %lld) \n",
+            label, r->blocks, (double) total / r->blocks, r->blocks * 1e6 / total,
+            r->load, r->scan, r->scanned);
+}
+
+static Result bench_hp(const Record * records, int total, int layout, int block_size) {
+    Result r = {0};
+
+    unlink(BENCH_HP);
+    unlink(BENCH_HP ".zone");
+    double start = now();
+    HP_CreateFileEx(BENCH_HP, layout);
+    HP_info* info = HP_OpenFile(BENCH_HP);
+    HP_BulkInsert(info, records, total);
+    r.load = now() - start;
+
+    start = now();
+    HP_Scan * scan = HP_ScanOpen(info, NULL, NULL);
+    while (HP_ScanNext(scan) != NULL) {
+        r.scanned++;
+    }
+    HP_ScanClose(scan);
+    r.scan = now() - start;
+
+    HP_CloseFile(info);
+    r.blocks = fileBlocks(BENCH_HP, block_size);
+    unlink(BENCH_HP);
+    unlink(BENCH_HP ".zone");
+    return r;
+}
+
+static Result bench_ht(const Record * records, int total, int layout, int block_size) {
+    Result r = {0};
+
+    unlink(BENCH_HT);
+    double start = now();
+    HT_CreateFileEx(BENCH_HT, BENCH_BUCKETS, layout);
+    HT_info* info = HT_OpenFile(BENCH_HT);
+    for (int k = 0; k < total; k++) {
+        HT_InsertEntry(info, records[k]);
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < total; k += total / 100 + 1) {
+        HT_GetAllEntries(info, records[k].id);
+        r.scanned++;
+    }
+    r.scan = now() - start;
+
+    HT_CloseFile(info);
+    r.blocks = fileBlocks(BENCH_HT, block_size);
+    unlink(BENCH_HT);
+    return r;
+}
+
+int main(int argc, char ** argv) {
+    int total = argc > 1 ? atoi(argv[1]) : 1000000;
+    int block_size = argc > 2 ? atoi(argv[2]) : 4096;
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+
+    BF_InitEx(LRU, block_size, 1024, BF_DEFAULT);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    Result hp_row = bench_hp(records, total, HP_LAYOUT_ROW, block_size);
+    Result hp_pax = bench_hp(records, total, HP_LAYOUT_PAX, block_size);
+    Result hp_slotted = bench_hp(records, total, HP_LAYOUT_SLOTTED, block_size);
+    Result ht_row = bench_ht(records, total, HT_LAYOUT_ROW, block_size);
+    Result ht_slotted = bench_ht(records, total, HT_LAYOUT_SLOTTED, block_size);
+    fclose(stdout);
+    stdout = out;
+
+    printf("%d records, block size %d (HT scan: %lld id = v lookups) \n", total, block_size, ht_row.scanned);
+    report("HP row", &hp_row, total);
+    report("HP pax", &hp_pax, total);
+    report("HP slotted", &hp_slotted, total);
+    report("HT row", &ht_row, total);
+    report("HT slotted", &ht_slotted, total);
+
+    BF_Close();
+    free(records);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "hp_sort.h"
+
+/*
+ * Μέτρηση της HP_Sort σε αρχείο σωρού με τυχαία id, για κάθε πεδίο
+ * ταξινόμησης και διάφορα μεγέθη μνήμης. Κάθε ταξινομημένο αρχείο
+ * διαβάζεται ξανά και ελέγχεται ότι έχει όλες τις εγγραφές με την σωστή
+ * σειρά.
+ *
+ * Χρήση: ./build/sort_bench [MB] [block_size]
+ */
+
+#define BENCH_INPUT "sort_bench_in.db"
+#define BENCH_OUTPUT "sort_bench_out.db"
+
+static const char * KEY_NAMES[] = {"id", "name", "surname", "city"};
+
+typedef struct {
+    Record_Attribute key;
+    Record previous;
+    long long records;
+    long long disorder;
+} Check;
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int compare(const Record * a, const Record * b, Record_Attribute key) {
+    int c = 0;
+    if (key == NAME) {
+        c = strcmp(a->name, b->name);
+    } else if (key == SURNAME) {
+        c = strcmp(a->surname, b->surname);
+    } else if (key == CITY) {
+        c = strcmp(a->city, b->city);
+    }
+    return c != 0 ? c : (a->id > b->id) - (a->id < b->id);
+}
+
+static int check_order(const Record *record, void *arg) {
+    Check * check = arg;
+    if (check->records > 0 && compare(&check->previous, record, check->key) > 0) {
+        check->disorder++;
+    }
+    check->previous = *record;
+    check->records++;
+    return 0;
+}
+
+static void unlink_heap(const char * filename) {
+    char zone[64];
+    snprintf(zone, sizeof (zone), "%s.zone", filename);
+    unlink(filename);
+    unlink(zone);
+}
+
+int main(int argc, char ** argv) {
+    long long megabytes = argc > 1 ? atoll(argv[1]) : 64;
+    int block_size = argc > 2 ? atoi(argv[2]) : 4096;
+    long long total = (megabytes << 20) / sizeof (Record);
+    size_t budgets[] = {1 << 20, 8 << 20, 64 << 20};
+
+    BF_InitEx(LRU, block_size, 1024, BF_READAHEAD);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+
+    srand(12569874);
+    unlink_heap(BENCH_INPUT);
+    HP_CreateFile(BENCH_INPUT);
+    HP_info* info = HP_OpenFile(BENCH_INPUT);
+    Record * records = malloc(sizeof (Record) * 65536);
+    for (long long first = 0; first < total; first += 65536) {
+        int n = total - first < 65536 ? (int) (total - first) : 65536;
+        for (int k = 0; k < n; k++) {
+            records[k] = randomRecord();
+            records[k].id = rand();
+        }
+        HP_BulkInsert(info, records, n);
+    }
+    HP_CloseFile(info);
+    free(records);
+
+    fclose(stdout);
+    stdout = out;
+
+    for (int b = 0; b < (int) (sizeof (budgets) / sizeof (budgets[0])); b++) {
+        for (Record_Attribute key = ID; key <= CITY; key++) {
+            HP_SortStats stats;
+            Check check = {key};
+
+            stdout = fopen("/dev/null", "w");
+            unlink_heap(BENCH_OUTPUT);
+            double start = now();
+            int result = HP_Sort(BENCH_INPUT, BENCH_OUTPUT, key, budgets[b], &stats);
+            double seconds = now() - start;
+
+            info = HP_OpenFile(BENCH_OUTPUT);
+            HP_ScanEach(info, NULL, NULL, check_order, &check);
+            HP_CloseFile(info);
+            fclose(stdout);
+            stdout = out;
+
+            printf("%4lld MB by %-8s memory %3zu MB %8.2f s %8.1f MB/s  runs %4d passes %d fan-in %3d  %s \n",
+                    megabytes, KEY_NAMES[key], budgets[b] >> 20, seconds, megabytes / seconds,
+                    stats.runs, stats.passes, stats.fan_in,
+                    result == 0 && check.records == total && check.disorder == 0 ? "OK" : "WRONG");
+        }
+    }
+
+    unlink_heap(BENCH_INPUT);
+    unlink_heap(BENCH_OUTPUT);
+    BF_Close();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "sf_file.h"
+
+/*
+ * Σύγκριση των αναζητήσεων στο id σε αρχείο σωρού και σε ταξινομημένο
+ * αρχείο, με τα id σε τυχαία σειρά εισαγωγής (οπότε ο χάρτης ζωνών του
+ * σωρού δεν βοηθάει). Μετράει τον χρόνο φόρτωσης, και για αναζητήσεις
+ * ισότητας και διαστήματος τον μέσο χρόνο και τα block που διαβάστηκαν.
+ *
+ * Χρήση: ./build/sorted_bench [records] [delta_blocks]
+ */
+
+#define BENCH_HP "sorted_bench.hp"
+#define BENCH_SF "sorted_bench.sf"
+#define BENCH_LOOKUPS 200
+#define BENCH_RANGE 1000
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+typedef struct {
+    double load;
+    double point;
+    double range;
+    long long point_blocks;
+    long long range_blocks;
+    long long matches;
+} Result;
+
+static void report(const char * label, const Result * r) {
+    printf("%-4s load %8.2f s  id = v %9.3f ms %8.1f blocks  id range %9.3f ms %8.1f blocks  (matches %lld) \n",
+            label, r->load, r->point * 1e3 / BENCH_LOOKUPS, (double) r->point_blocks / BENCH_LOOKUPS,
+            r->range * 1e3 / BENCH_LOOKUPS, (double) r->range_blocks / BENCH_LOOKUPS, r->matches);
+}
+
+static Result bench_hp(const Record * records, int total) {
+    Result r = {0};
+
+    unlink(BENCH_HP);
+    double start = now();
+    HP_CreateFile(BENCH_HP);
+    HP_info* info = HP_OpenFile(BENCH_HP);
+    for (int k = 0; k < total; k++) {
+        HP_InsertEntry(info, records[k]);
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        r.point_blocks += HP_GetAllEntries(info, records[k].id);
+    }
+    r.point = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        HP_Scan * scan = HP_ScanOpenRange(info, records[k].id, records[k].id + BENCH_RANGE);
+        while (HP_ScanNext(scan) != NULL) {
+            r.matches++;
+        }
+        r.range_blocks += HP_ScanClose(scan);
+    }
+    r.range = now() - start;
+
+    HP_CloseFile(info);
+    unlink(BENCH_HP);
+    unlink(BENCH_HP ".zone");
+    return r;
+}
+
+static Result bench_sf(const Record * records, int total, int delta_blocks) {
+    Result r = {0};
+
+    unlink(BENCH_SF);
+    double start = now();
+    SF_CreateFile(BENCH_SF, delta_blocks);
+    SF_info* info = SF_OpenFile(BENCH_SF);
+    for (int k = 0; k < total; k++) {
+        SF_InsertEntry(info, records[k]);
+    }
+    r.load = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        r.point_blocks += SF_GetAllEntries(info, records[k].id);
+    }
+    r.point = now() - start;
+
+    start = now();
+    for (int k = 0; k < BENCH_LOOKUPS; k++) {
+        SF_Scan * scan = SF_ScanOpenRange(info, records[k].id, records[k].id + BENCH_RANGE);
+        while (SF_ScanNext(scan) != NULL) {
+            r.matches++;
+        }
+        r.range_blocks += SF_ScanClose(scan);
+    }
+    r.range = now() - start;
+
+    SF_CloseFile(info);
+    unlink(BENCH_SF);
+    return r;
+}
+
+int main(int argc, char ** argv) {
+    int total = argc > 1 ? atoi(argv[1]) : 100000;
+    int delta_blocks = argc > 2 ? atoi(argv[2]) : 64;
+
+    srand(12569874);
+    Record * records = malloc(sizeof (Record) * total);
+    for (int k = 0; k < total; k++) {
+        records[k] = randomRecord();
+        records[k].id = k;
+    }
+    for (int k = total - 1; k > 0; k--) {
+        int j = rand() % (k + 1);
+        int id = records[k].id;
+        records[k].id = records[j].id;
+        records[j].id = id;
+    }
+
+    BF_InitEx(LRU, 4096, 1024, BF_DEFAULT);
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+    Result hp = bench_hp(records, total);
+    Result sf = bench_sf(records, total, delta_blocks);
+    fclose(stdout);
+    stdout = out;
+
+    report("HP", &hp);
+    report("SF", &sf);
+
+    BF_Close();
+    free(records);
+    return 0;
+}
@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "bf.h"
+#include "hp_file.h"
+#include "sf_file.h"
+
+/*
+ * Μέτρηση των εισαγωγών σε αρχείο σωρού χωρίς ημερολόγιο και με ημερολόγιο
+ * για διάφορα μεγέθη ομαδικού commit, και έλεγχος ανάκτησης: μια διεργασία
+ * παιδί εισάγει εγγραφές με ενεργό ημερολόγιο και τερματίζει χωρίς να
+ * κλείσει τα αρχεία, και στην συνέχεια το αρχείο ανοίγεται ξανά και
+ * ελέγχεται ότι περιέχει όλες τις εγγραφές που έγιναν commit.
+ *
+ * Δύο ακόμη έλεγχοι αφορούν αλλαγές που δεν έγιναν commit. Στον πρώτο ένα
+ * παιδί αλλάζει block χωρίς BF_Commit, προκαλεί απομακρύνσεις και
+ * checkpoint και τερματίζει· μετά την ανάκτηση τα block πρέπει να έχουν το
+ * περιεχόμενο της τελευταίας BF_Commit. Στον δεύτερο ένα παιδί εισάγει σε
+ * ταξινομημένο αρχείο με μικρή περιοχή αλλαγών, ώστε να συγχωνεύει συχνά,
+ * με τον writer ενεργό, και σκοτώνεται με SIGKILL σε διάφορες στιγμές·
+ * μετά την ανάκτηση το αρχείο πρέπει να περιέχει ακριβώς τις πρώτες
+ * records εγγραφές που εισήχθησαν, ταξινομημένες.
+ *
+ * Χρήση: ./build/wal_bench [records]
+ */
+
+#define BENCH_FILE "wal_bench.db"
+#define BENCH_LOG "wal_bench.log"
+#define BENCH_CHECKPOINT (8LL << 20)
+#define CRASH_BLOCKS 64
+#define CRASH_CHANGED 8
+#define CRASH_FRAMES 16
+#define MERGE_RECORDS 10000
+#define MERGE_DELTA_BLOCKS 2
+#define MERGE_BLOCK_SIZE 4096
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void insert_records(int records) {
+    HP_CreateFile(BENCH_FILE);
+    HP_info* info = HP_OpenFile(BENCH_FILE);
+    for (int id = 0; id < records; id++) {
+        Record record = randomRecord();
+        record.id = id;
+        HP_InsertEntry(info, record);
+    }
+    HP_CloseFile(info);
+}
+
+static void bench_insert(int records, int group_commit) {
+    BF_LogConfig config = {group_commit, BENCH_CHECKPOINT};
+    BF_LogStats stats = {0};
+
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+    BF_Init(LRU);
+    if (group_commit > 0) {
+        BF_OpenLog(BENCH_LOG, &config);
+    }
+
+    FILE * out = stdout;
+    stdout = fopen("/dev/null", "w");
+
+    double start = now();
+    insert_records(records);
+    double seconds = now() - start;
+
+    fclose(stdout);
+    stdout = out;
+
+    if (group_commit > 0) {
+        BF_GetLogStats(&stats);
+        printf("group commit %4d ", group_commit);
+    } else {
+        printf("no log           ");
+    }
+    printf("%8d records %10.0f inserts/s  syncs %7llu  pages logged %8llu  checkpoints %3llu \n",
+            records, records / seconds, stats.syncs, stats.pages_logged, stats.checkpoints);
+
+    BF_Close();
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+}
+
+/* Το παιδί δεν καλεί HP_CloseFile ούτε BF_Close: ό,τι δεν έχει γραφτεί στο
+ * αρχείο υπάρχει μόνο στο ημερολόγιο. */
+static void crash_child(int records) {
+    BF_LogConfig config = {1, 0};
+
+    BF_Init(LRU);
+    BF_OpenLog(BENCH_LOG, &config);
+    HP_CreateFile(BENCH_FILE);
+    HP_info* info = HP_OpenFile(BENCH_FILE);
+    for (int id = 0; id < records; id++) {
+        Record record = randomRecord();
+        record.id = id;
+        HP_InsertEntry(info, record);
+    }
+    _exit(0);
+}
+
+static void bench_recovery(int records) {
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        freopen("/dev/null", "w", stdout);
+        crash_child(records);
+    }
+    waitpid(pid, NULL, 0);
+
+    BF_LogConfig config = {1, 0};
+    BF_LogStats stats = {0};
+    BF_BlockHandle handle;
+    BF_Block *block;
+
+    BF_Block_InitInPlace(&handle, &block);
+    BF_Init(LRU);
+    BF_OpenLog(BENCH_LOG, &config);
+
+    /* Το άνοιγμα του αρχείου εφαρμόζει τις σελίδες του ημερολογίου. Τα block
+     * του σωρού διαβάζονται απευθείας: στο τέλος κάθε block βρίσκεται το
+     * πλήθος των εγγραφών του. */
+    int fd, blocks = 0, block_size = 0, found = 0;
+    double start = now();
+    BF_OpenFile(BENCH_FILE, &fd);
+    double seconds = now() - start;
+    BF_GetLogStats(&stats);
+    BF_GetBlockCounter(fd, &blocks);
+    BF_GetBlockSize(fd, &block_size);
+
+    for (int b = 1; b < blocks; b++) {
+        if (BF_GetBlock(fd, b, block) != BF_OK) {
+            break;
+        }
+        char * data = BF_Block_GetData(block);
+        int count = *(int *) (data + block_size - 2 * sizeof (int));
+        for (int k = 0; k < count; k++) {
+            found += ((Record *) data)[k].id == found;
+        }
+        BF_UnpinBlock(block);
+    }
+
+    printf("recovery: %d of %d records after crash, %llu pages recovered in %.3f s: %s \n",
+            found, records, stats.pages_recovered, seconds, found == records ? "OK" : "FAILED");
+
+    BF_CloseFile(fd);
+    BF_Close();
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+}
+
+/* Τα block 0 έως CRASH_CHANGED - 1 αλλάζουν σε 'B' χωρίς BF_Commit. Με
+ * CRASH_FRAMES πλαίσια η ανάγνωση των υπολοίπων απομακρύνει ό,τι μπορεί. */
+static void uncommitted_child(void) {
+    BF_LogConfig config = {1, 0};
+    BF_BlockHandle handle;
+    BF_Block *block;
+    int fd;
+
+    BF_Block_InitInPlace(&handle, &block);
+    BF_InitEx(LRU, BF_BLOCK_SIZE, CRASH_FRAMES, BF_DEFAULT);
+    BF_OpenLog(BENCH_LOG, &config);
+    BF_CreateFile(BENCH_FILE);
+    BF_OpenFile(BENCH_FILE, &fd);
+    for (int b = 0; b < CRASH_BLOCKS; b++) {
+        BF_AllocateBlock(fd, block);
+        memset(BF_Block_GetData(block), 'A', BF_BLOCK_SIZE);
+        BF_Block_SetDirty(block);
+        BF_UnpinBlock(block);
+        BF_Commit();
+    }
+    for (int b = 0; b < CRASH_CHANGED; b++) {
+        BF_GetBlock(fd, b, block);
+        memset(BF_Block_GetData(block), 'B', BF_BLOCK_SIZE);
+        BF_Block_SetDirty(block);
+        BF_UnpinBlock(block);
+    }
+    for (int b = CRASH_CHANGED; b < CRASH_BLOCKS; b++) {
+        BF_GetBlock(fd, b, block);
+        BF_UnpinBlock(block);
+    }
+    BF_Checkpoint();
+    _exit(0);
+}
+
+static void bench_uncommitted(void) {
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        uncommitted_child();
+    }
+    waitpid(pid, NULL, 0);
+
+    BF_LogConfig config = {1, 0};
+    BF_BlockHandle handle;
+    BF_Block *block;
+    int fd, blocks = 0, same = 0;
+
+    BF_Block_InitInPlace(&handle, &block);
+    BF_InitEx(LRU, BF_BLOCK_SIZE, CRASH_FRAMES, BF_DEFAULT);
+    BF_OpenLog(BENCH_LOG, &config);
+    BF_OpenFile(BENCH_FILE, &fd);
+    BF_GetBlockCounter(fd, &blocks);
+    for (int b = 0; b < blocks; b++) {
+        if (BF_GetBlock(fd, b, block) != BF_OK) {
+            break;
+        }
+        const char * data = BF_Block_GetData(block);
+        int k = 0;
+        while (k < BF_BLOCK_SIZE && data[k] == 'A') {
+            k++;
+        }
+        same += k == BF_BLOCK_SIZE;
+        BF_UnpinBlock(block);
+    }
+
+    printf("recovery: %d of %d blocks as of the last commit after uncommitted changes, eviction and checkpoint: %s \n",
+            same, CRASH_BLOCKS, same == CRASH_BLOCKS ? "OK" : "FAILED");
+
+    BF_CloseFile(fd);
+    BF_Close();
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+}
+
+/* Η k-οστή εισαγωγή έχει id merge_id(k): μετάθεση των 0 έως
+ * MERGE_RECORDS - 1, ώστε σχεδόν όλες να πηγαίνουν στην περιοχή αλλαγών. */
+static int merge_id(int k) {
+    return (int) ((long long) k * 7919 % MERGE_RECORDS);
+}
+
+static void merge_child(void) {
+    BF_LogConfig config = {1, 1LL << 20};
+    BF_WriterConfig writer = {0, 0, 100, 1};
+
+    BF_InitEx(LRU, MERGE_BLOCK_SIZE, 1024, BF_DEFAULT);
+    BF_OpenLog(BENCH_LOG, &config);
+    BF_StartWriter(&writer);
+    SF_CreateFile(BENCH_FILE, MERGE_DELTA_BLOCKS);
+    SF_info* info = SF_OpenFile(BENCH_FILE);
+    for (int k = 0; k < MERGE_RECORDS; k++) {
+        Record record = randomRecord();
+        record.id = merge_id(k);
+        SF_InsertEntry(info, record);
+    }
+    _exit(0);
+}
+
+/* Επιστρέφει 1 αν το αρχείο περιέχει ακριβώς τις πρώτες *records εισαγωγές,
+ * ταξινομημένες και χωρίς διπλότυπα. */
+static int merge_check(int * records) {
+    BF_LogConfig config = {1, 0};
+    int * position = malloc(sizeof (int) * MERGE_RECORDS);
+    int found = 0, previous = -1, consistent = 1;
+
+    for (int k = 0; k < MERGE_RECORDS; k++) {
+        position[merge_id(k)] = k;
+    }
+
+    BF_InitEx(LRU, MERGE_BLOCK_SIZE, 1024, BF_DEFAULT);
+    BF_OpenLog(BENCH_LOG, &config);
+    SF_info* info = SF_OpenFile(BENCH_FILE);
+    if (info == NULL) {
+        BF_Close();
+        free(position);
+        *records = 0;
+        return 0;
+    }
+
+    SF_Scan * scan = SF_ScanOpenRange(info, INT_MIN, INT_MAX);
+    const Record * record;
+    int last = -1;
+    while ((record = SF_ScanNext(scan)) != NULL) {
+        if (record->id <= previous || record->id < 0 || record->id >= MERGE_RECORDS) {
+            consistent = 0;
+        } else if (position[record->id] > last) {
+            last = position[record->id];
+        }
+        previous = record->id;
+        found++;
+    }
+    SF_ScanClose(scan);
+    if (last != found - 1) {
+        consistent = 0;
+    }
+    *records = found;
+
+    SF_CloseFile(info);
+    BF_Close();
+    free(position);
+    return consistent;
+}
+
+static void bench_merge_crash(void) {
+    const int delays[] = {100, 250, 500, 1000, 2000};
+    const int runs = (int) (sizeof (delays) / sizeof (delays[0]));
+    int consistent = 0;
+
+    for (int r = 0; r < runs; r++) {
+        unlink(BENCH_FILE);
+        unlink(BENCH_LOG);
+
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            freopen("/dev/null", "w", stdout);
+            freopen("/dev/null", "w", stderr);
+            merge_child();
+        }
+        usleep(delays[r] * 1000);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        FILE * out = stdout;
+        stdout = fopen("/dev/null", "w");
+        int records;
+        int ok = merge_check(&records);
+        fclose(stdout);
+        stdout = out;
+
+        printf("recovery: SIGKILL after %4d ms during SF merges, %5d records: %s \n",
+                delays[r], records, ok ? "consistent" : "INCONSISTENT");
+        consistent += ok;
+    }
+
+    printf("recovery: %d of %d SF crashes consistent: %s \n", consistent, runs, consistent == runs ? "OK" : "FAILED");
+    unlink(BENCH_FILE);
+    unlink(BENCH_LOG);
+}
+
+int main(int argc, char ** argv) {
+    int records = argc > 1 ? atoi(argv[1]) : 20000;
+    int groups[] = {0, 1, 8, 64, 512};
+
+    srand(12569874);
+
+    for (int g = 0; g < (int) (sizeof (groups) / sizeof (groups[0])); g++) {
+        bench_insert(records, groups[g]);
+    }
+    bench_recovery(records);
+    bench_uncommitted();
+    bench_merge_crash();
+
+    return 0;
+}
@@ -7,7 +7,9 @@ extern "C" {
 
 #define BF_BLOCK_SIZE 512      /* Το μέγεθος ενός block σε bytes */
 #define BF_BUFFER_SIZE 100     /* Ο μέγιστος αριθμός block που κρατάμε στην μνήμη */
-#define BF_MAX_OPEN_FILES 100  /* Ο μέγιστος αριθμός ανοικτών αρχείων */
+#define BF_MAX_OPEN_FILES 65536 /* Ο μέγιστος αριθμός ανοικτών αρχείων */
+#define BF_MAX_OS_FILES 256     /* Αρχεία με ανοικτό descriptor του λειτουργικού, εξ ορισμού */
+#define BF_MAX_BLOCK_SIZE 65536 /* Το μέγιστο μέγεθος block που δέχεται η BF_InitEx */
 
 typedef enum BF_ErrorCode {
   BF_OK,
@@ -23,9 +25,75 @@ typedef enum BF_ErrorCode {
 
 typedef enum ReplacementAlgorithm {
   LRU,
-  MRU
+  MRU,
+  CLOCK,   /* Προσέγγιση του LRU με ένα bit αναφοράς ανά πλαίσιο */
+  TWO_Q,   /* A1in/A1out/Am: τα block που διαβάζονται μία φορά δεν εκτοπίζουν τα "ζεστά" */
+  ARC,     /* Adaptive Replacement Cache: ισορροπεί δυναμικά πρόσφατα και συχνά block */
+  LRU_K    /* LRU-2: απομακρύνεται το block με την παλαιότερη προτελευταία αναφορά */
 } ReplacementAlgorithm;
 
+typedef enum BF_InitFlags {
+  BF_DEFAULT = 0,
+  BF_CONCURRENT = 1 << 0,  /* Η ενδιάμεση μνήμη χωρίζεται σε τμήματα με ξεχωριστό latch */
+  BF_READAHEAD = 1 << 1,   /* Σειριακή προανάγνωση των block με posix_fadvise */
+  BF_DIRECT_IO = 1 << 2    /* Τα αρχεία ανοίγουν με O_DIRECT, χωρίς την cache του λειτουργικού */
+} BF_InitFlags;
+
+/*
+ * Τρόπος πρόσβασης σε ένα αρχείο, που επιλέγεται στην BF_OpenFileEx.
+ */
+typedef enum BF_FileMode {
+  BF_FILE_POOL = 0,  /* Τα block αντιγράφονται σε πλαίσια της ενδιάμεσης μνήμης */
+  BF_FILE_MMAP = 1   /* Το αρχείο απεικονίζεται με mmap και τα block δείχνουν μέσα του */
+} BF_FileMode;
+
+/*
+ * Μετρητές του επιπέδου BF. Ως αιτήσεις μετράνε οι κλήσεις της BF_GetBlock,
+ * που είναι είτε hits (το block ήταν στην μνήμη) είτε misses. Οι αναγνώσεις
+ * και εγγραφές είναι οι πραγματικές λειτουργίες στον δίσκο.
+ */
+typedef struct BF_Stats {
+  ReplacementAlgorithm policy;        /* Η πολιτική αντικατάστασης της μνήμης */
+  unsigned long long requests;        /* Αιτήσεις block (BF_GetBlock) */
+  unsigned long long hits;            /* Αιτήσεις που βρήκαν το block στην μνήμη */
+  unsigned long long misses;          /* Αιτήσεις που διάβασαν το block από τον δίσκο */
+  unsigned long long dirty_evictions; /* Απομακρύνσεις block που γράφτηκαν πρώτα στον δίσκο */
+  unsigned long long clean_evictions; /* Απομακρύνσεις block χωρίς εγγραφή */
+  unsigned long long reads;           /* Αναγνώσεις block από τον δίσκο */
+  unsigned long long writes;          /* Εγγραφές block στον δίσκο */
+  unsigned long long bytes_read;
+  unsigned long long bytes_written;
+} BF_Stats;
+
+/*
+ * Ρυθμίσεις του writer που γράφει dirty block στο παρασκήνιο. Τα όρια
+ * είναι ποσοστά (0-100) των πλαισίων της ενδιάμεσης μνήμης που είναι dirty.
+ */
+typedef struct BF_WriterConfig {
+  int pages_per_second; /* Μέγιστος ρυθμός εγγραφών κάτω από το high_watermark, 0 χωρίς όριο */
+  int low_watermark;    /* Κάτω από αυτό το ποσοστό ο writer δεν γράφει */
+  int high_watermark;   /* Πάνω από αυτό το ποσοστό γράφει χωρίς όριο ρυθμού */
+  int interval_ms;      /* Κάθε πόσα ms ξυπνάει */
+} BF_WriterConfig;
+
+/*
+ * Ρυθμίσεις του ημερολογίου (write-ahead log). Με group_commit > 1 ένα
+ * fdatasync του ημερολογίου γίνεται ανά group_commit κλήσεις της BF_Commit,
+ * οπότε σε κατάρρευση μπορεί να χαθούν έως τόσες ολοκληρωμένες αλλαγές.
+ */
+typedef struct BF_LogConfig {
+  int group_commit;          /* Κλήσεις της BF_Commit ανά fdatasync, 1 για κάθε κλήση */
+  long long checkpoint_bytes; /* Μέγεθος ημερολογίου που προκαλεί checkpoint, 0 ποτέ */
+} BF_LogConfig;
+
+typedef struct BF_LogStats {
+  unsigned long long commits;      /* Κλήσεις της BF_Commit */
+  unsigned long long syncs;        /* fdatasync του ημερολογίου */
+  unsigned long long pages_logged; /* Εικόνες σελίδων που γράφτηκαν στο ημερολόγιο */
+  unsigned long long bytes_logged;
+  unsigned long long checkpoints;
+  unsigned long long pages_recovered; /* Σελίδες που εφαρμόστηκαν από το ημερολόγιο στην ανάκτηση */
+} BF_LogStats;
 
 // Δομή Block
 typedef struct BF_Block BF_Block;
@@ -42,6 +110,21 @@ void BF_Block_Init(BF_Block **block);
  */
 void BF_Block_Destroy(BF_Block **block);
 
+/*
+ * Χώρος για μια δομή BF_Block που δεσμεύεται από τον καλούντα, συνήθως
+ * στη στοίβα. Τα περιεχόμενά του είναι αδιαφανή.
+ */
+typedef struct BF_BlockHandle {
+  void *opaque[4];
+} BF_BlockHandle;
+
+/*
+ * Η συνάρτηση BF_Block_InitInPlace αρχικοποιεί μια δομή BF_BLOCK μέσα στο
+ * handle χωρίς να δεσμεύσει μνήμη. Το block που επιστρέφεται ισχύει όσο
+ * ζει το handle και δεν πρέπει να δοθεί στην BF_Block_Destroy.
+ */
+void BF_Block_InitInPlace(BF_BlockHandle *handle, BF_Block **block);
+
 /*
  * Η συνάρτηση BF_Block_SetDirty αλάζει την κατάσταση του block σε dirty.
  * Αυτό πρακτικά σημαίνει ότι τα δεδομένα του block έχουν αλλαχθεί και το
@@ -60,11 +143,30 @@ char* BF_Block_GetData(const BF_Block *block);
 
 /*
  * Με τη συνάρτηση BF_Init πραγματοποιείται η αρχικοποίηση του επιπέδου BF.
- * Μπορούμε να επιλέξουμε ανάμεσα σε δύο πολιτικές αντικατάστασις Block
- * εκείνης της LRU και εκείνης της MRU.
+ * Μπορούμε να επιλέξουμε ανάμεσα στις πολιτικές αντικατάστασης Block LRU,
+ * MRU, CLOCK, TWO_Q, ARC και LRU_K. Οι TWO_Q, ARC και LRU_K αντέχουν σε
+ * πλήρεις σαρώσεις αρχείων χωρίς να εκτοπίζουν τα συχνά χρησιμοποιούμενα
+ * block.
  */
 BF_ErrorCode BF_Init(const ReplacementAlgorithm repl_alg);
 
+/*
+ * Η συνάρτηση BF_InitEx αρχικοποιεί το επίπεδο BF όπως η BF_Init, αλλά με
+ * μέγεθος block block_size bytes και ενδιάμεση μνήμη pool_frames block που
+ * ορίζονται κατά την εκτέλεση. Το block_size πρέπει να είναι δύναμη του 2
+ * από BF_BLOCK_SIZE έως BF_MAX_BLOCK_SIZE (π.χ. 4096 ή 65536). Η παράμετρος
+ * flags είναι συνδυασμός τιμών BF_InitFlags. Με BF_CONCURRENT οι
+ * BF_GetBlock, BF_GetBlocks, BF_UnpinBlock και BF_AllocateBlock μπορούν να καλούνται
+ * ταυτόχρονα από πολλά νήματα με διαφορετικά BF_Block. Η BF_Init ισοδυναμεί
+ * με BF_InitEx(repl_alg, BF_BLOCK_SIZE, BF_BUFFER_SIZE, BF_DEFAULT). Σε
+ * περίπτωση επιτυχίας επιστρέφεται BF_OK ενώ σε περίπτωση αποτυχίας,
+ * επιστρέφεται ένας κωδικός λάθους.
+ */
+BF_ErrorCode BF_InitEx(const ReplacementAlgorithm repl_alg,
+                       const int block_size,
+                       const int pool_frames,
+                       const int flags);
+
 /*
  * Η συνάρτηση BF_CreateFile δημιουργεί ένα αρχείο με όνομα filename το
  * οποίο αποτελείται από blocks. Αν το αρχείο υπάρχει ήδη τότε επιστρέφεται
@@ -83,11 +185,23 @@ BF_ErrorCode BF_CreateFile(const char* filename);
  */
 BF_ErrorCode BF_OpenFile(const char* filename, int *file_desc);
 
+/*
+ * Η συνάρτηση BF_OpenFileEx ανοίγει το αρχείο όπως η BF_OpenFile, με τον
+ * τρόπο πρόσβασης mode. Με BF_FILE_MMAP το αρχείο απεικονίζεται στην μνήμη:
+ * η BF_Block_GetData επιστρέφει δείκτη μέσα στην απεικόνιση, οι αλλαγές
+ * γράφονται κατευθείαν στο αρχείο μέσω της cache του λειτουργικού και τα
+ * pin είναι απλοί μετρητές. Ταιριάζει σε αρχεία που διαβάζονται συχνά και
+ * χωράνε στην μνήμη. Οι αιτήσεις τέτοιων αρχείων δεν περνούν από την
+ * ενδιάμεση μνήμη και δεν εμφανίζονται στα στατιστικά της.
+ */
+BF_ErrorCode BF_OpenFileEx(const char* filename, int *file_desc, const BF_FileMode mode);
+
 /*
  * Η συνάρτηση BF_CloseFile κλείνει το ανοιχτό αρχείο με αναγνωριστικό αριθμό
  * file_desc. Σε περίπτωση επιτυχίας επιστρέφεται BF_OK ενώ σε περίπτωση
  * αποτυχίας, επιστρέφεται ένας κωδικός λάθους. Αν θέλετε να δείτε το
- * είδος του λάθους μπορείτε να καλέσετε τη συνάρτηση BF_PrintError.
+ * είδος του λάθους μπορείτε να καλέσετε τη συνάρτηση BF_PrintError. Με
+ * ενεργό ημερολόγιο καλεί πρώτα την BF_Commit.
  */
 BF_ErrorCode BF_CloseFile(const int file_desc);
 
@@ -101,6 +215,14 @@ BF_ErrorCode BF_CloseFile(const int file_desc);
  */
 BF_ErrorCode BF_GetBlockCounter(const int file_desc, int *blocks_num);
 
+/*
+ * Η συνάρτηση BF_GetBlockSize επιστρέφει στην μεταβλητή block_size το
+ * μέγεθος σε bytes των block του ανοιχτού αρχείου file_desc. Σε περίπτωση
+ * επιτυχίας επιστρέφεται BF_OK ενώ σε περίπτωση αποτυχίας, επιστρέφεται
+ * ένας κωδικός λάθους.
+ */
+BF_ErrorCode BF_GetBlockSize(const int file_desc, int *block_size);
+
 /*
  * Με τη συνάρτηση BF_AllocateBlock δεσμεύεται ένα καινούριο block για το
  * αρχείο με αναγνωριστικό αριθμό blockFile. Το νέο block δεσμεύεται πάντα
@@ -115,6 +237,25 @@ BF_ErrorCode BF_GetBlockCounter(const int file_desc, int *blocks_num);
  */
 BF_ErrorCode BF_AllocateBlock(const int file_desc, BF_Block *block);
 
+/*
+ * Η συνάρτηση BF_AllocateBlockEx λειτουργεί όπως η BF_AllocateBlock και
+ * επιπλέον επιστρέφει στην μεταβλητή block_num τον αριθμό του νέου block.
+ * Το block επιστρέφεται ήδη καρφιτσωμένο, οπότε δεν χρειάζεται κλήση της
+ * BF_GetBlockCounter πριν ούτε της BF_GetBlock μετά.
+ */
+BF_ErrorCode BF_AllocateBlockEx(const int file_desc, BF_Block *block, int *block_num);
+
+/*
+ * Η συνάρτηση BF_AppendBlocks προσθέτει στο τέλος του αρχείου file_desc n
+ * νέα block με τα περιεχόμενα των n * block_size bytes του data και
+ * επιστρέφει στην first_block τον αριθμό του πρώτου. Τα block γράφονται με
+ * μία εγγραφή κατευθείαν στο αρχείο, χωρίς να περάσουν από την ενδιάμεση
+ * μνήμη. Με BF_DIRECT_IO το data πρέπει να είναι στοιχισμένο στα 4096 bytes.
+ * Με ενεργό ημερολόγιο ή σε αρχείο BF_FILE_MMAP λειτουργεί όπως n κλήσεις
+ * της BF_AllocateBlock.
+ */
+BF_ErrorCode BF_AppendBlocks(const int file_desc, const char *data, const int n, int *first_block);
+
 
 /*
  * Η συνάρτηση BF_GetBlock βρίσκει το block με αριθμό block_num του ανοιχτού
@@ -129,6 +270,16 @@ BF_ErrorCode BF_GetBlock(const int file_desc,
                          const int block_num,
                          BF_Block *block);
 
+/*
+ * Η συνάρτηση BF_GetBlocks φέρνει τα n block με αριθμούς block_nums του
+ * ανοιχτού αρχείου file_desc και τα επιστρέφει καρφιτσωμένα στα blocks[0..n-1],
+ * όπως n κλήσεις της BF_GetBlock. Τα block που δεν βρίσκονται στην μνήμη
+ * διαβάζονται μαζί, με μία ανάγνωση για κάθε σειρά διαδοχικών αριθμών. Κάθε
+ * block πρέπει να ξεκαρφιτσωθεί με την BF_UnpinBlock. Σε περίπτωση αποτυχίας
+ * κανένα block δεν μένει καρφιτσωμένο και επιστρέφεται ένας κωδικός λάθους.
+ */
+BF_ErrorCode BF_GetBlocks(const int file_desc, const int *block_nums, const int n, BF_Block **blocks);
+
 /*
  * Η συνάρτηση BF_UnpinBlock αποδεσμεύει το block από το επίπεδο Block το
  * οποίο κάποια στηγμή θα το γράψει στο δίσκο. Σε περίπτωση επιτυχίας
@@ -138,6 +289,118 @@ BF_ErrorCode BF_GetBlock(const int file_desc,
  */
 BF_ErrorCode BF_UnpinBlock(BF_Block *block);
 
+/*
+ * Η συνάρτηση BF_StartWriter ξεκινάει ένα νήμα που γράφει στον δίσκο τα
+ * dirty block που δεν είναι καρφιτσωμένα, ξεκινώντας από αυτά που θα
+ * απομακρύνει πρώτα η πολιτική αντικατάστασης. Έτσι η BF_GetBlock βρίσκει
+ * συνήθως καθαρό πλαίσιο και δεν γράφει η ίδια. Σταματάει με την
+ * BF_StopWriter ή την BF_Close. Σε περίπτωση επιτυχίας επιστρέφεται BF_OK
+ * ενώ σε περίπτωση αποτυχίας, επιστρέφεται ένας κωδικός λάθους.
+ */
+BF_ErrorCode BF_StartWriter(const BF_WriterConfig *config);
+
+/*
+ * Η συνάρτηση BF_StopWriter σταματάει τον writer και περιμένει να
+ * τερματίσει. Τα dirty block που απομένουν γράφονται όπως και πριν.
+ */
+BF_ErrorCode BF_StopWriter();
+
+/*
+ * Η συνάρτηση BF_SetDescriptorLimit ορίζει πόσα από τα ανοικτά αρχεία
+ * κρατούν ταυτόχρονα ανοικτό descriptor του λειτουργικού (εξ ορισμού
+ * BF_MAX_OS_FILES). Τα υπόλοιπα αρχεία μένουν ανοικτά για το επίπεδο BF:
+ * ο descriptor τους κλείνει όταν είναι αδρανή, με σειρά LRU, και ξανανοίγει
+ * στην επόμενη ανάγνωση ή εγγραφή.
+ */
+BF_ErrorCode BF_SetDescriptorLimit(const int limit);
+
+/*
+ * Η συνάρτηση BF_OpenLog ενεργοποιεί το ημερολόγιο επανάληψης (redo log)
+ * στο αρχείο filename, που δημιουργείται αν δεν υπάρχει. Καλείται μετά την
+ * BF_InitEx και πριν ανοίξει οποιοδήποτε αρχείο. Αν το ημερολόγιο περιέχει
+ * εγγραφές από προηγούμενη εκτέλεση που δεν έκλεισε σωστά, οι σελίδες κάθε
+ * αρχείου εφαρμόζονται όταν αυτό ανοίξει με την BF_OpenFile, και όσων δεν
+ * ανοίξουν στο επόμενο checkpoint ή στην BF_Close. Τα αρχεία BF_FILE_MMAP
+ * δεν καταγράφονται. Η ανάκτηση φτάνει έως την τελευταία BF_Commit που
+ * ολοκληρώθηκε. Ένα block που άλλαξε μετά την τελευταία BF_Commit μένει
+ * στην ενδιάμεση μνήμη (no-steal), οπότε όσα block αλλάζουν μεταξύ δύο
+ * κλήσεων της BF_Commit πρέπει να χωράνε σε αυτήν, αλλιώς οι BF_GetBlock
+ * και BF_AllocateBlock επιστρέφουν BF_FULL_MEMORY_ERROR.
+ */
+BF_ErrorCode BF_OpenLog(const char *filename, const BF_LogConfig *config);
+
+/*
+ * Η συνάρτηση BF_Commit γράφει στο ημερολόγιο την εικόνα κάθε σελίδας που
+ * σημειώθηκε dirty από την προηγούμενη κλήση και μια εγγραφή commit που τις
+ * επικυρώνει όλες μαζί. Κάθε group_commit κλήσεις
+ * περιμένει να γίνει το ημερολόγιο μόνιμο· ταυτόχρονες κλήσεις από πολλά
+ * νήματα μοιράζονται το ίδιο fdatasync. Πρέπει να καλείται όταν οι σελίδες
+ * είναι σε συνεπή κατάσταση, π.χ. στο τέλος κάθε εισαγωγής. Χωρίς ενεργό
+ * ημερολόγιο δεν κάνει τίποτα.
+ */
+BF_ErrorCode BF_Commit();
+
+/*
+ * Η συνάρτηση BF_SyncLog κάνει μόνιμες όλες τις αλλαγές που έχουν περάσει
+ * από την BF_Commit, ανεξάρτητα από το group_commit.
+ */
+BF_ErrorCode BF_SyncLog();
+
+/*
+ * Η συνάρτηση BF_Checkpoint γράφει τις dirty σελίδες που έχουν επικυρωθεί
+ * με την BF_Commit στα αρχεία τους, κάνει fdatasync τα αρχεία και αφαιρεί
+ * από το ημερολόγιο τις εγγραφές που δεν χρειάζονται πια. Καλείται και αυτόματα όταν το ημερολόγιο ξεπεράσει
+ * τα checkpoint_bytes.
+ */
+BF_ErrorCode BF_Checkpoint();
+
+/*
+ * Η συνάρτηση BF_LogActive επιστρέφει 1 αν είναι ενεργό το ημερολόγιο.
+ */
+int BF_LogActive();
+
+BF_ErrorCode BF_GetLogStats(BF_LogStats *stats);
+
+/*
+ * Η συνάρτηση BF_GetStats επιστρέφει στην μεταβλητή stats τους μετρητές του
+ * ανοιχτού αρχείου file_desc από το άνοιγμά του ή από την τελευταία κλήση
+ * της BF_ResetStats. Οι απομακρύνσεις χρεώνονται στο αρχείο του block που
+ * απομακρύνθηκε. Σε περίπτωση επιτυχίας επιστρέφεται BF_OK ενώ σε περίπτωση
+ * αποτυχίας, επιστρέφεται ένας κωδικός λάθους.
+ */
+BF_ErrorCode BF_GetStats(const int file_desc, BF_Stats *stats);
+
+/*
+ * Η συνάρτηση BF_ResetStats μηδενίζει τους μετρητές του ανοιχτού αρχείου
+ * file_desc.
+ */
+BF_ErrorCode BF_ResetStats(const int file_desc);
+
+/*
+ * Η συνάρτηση BF_GetGlobalStats επιστρέφει τους μετρητές όλων των αρχείων
+ * από την BF_Init. Επιστρέφει BF_ERROR αν το επίπεδο BF δεν είναι ενεργό.
+ */
+BF_ErrorCode BF_GetGlobalStats(BF_Stats *stats);
+
+/*
+ * Η συνάρτηση BF_GetPolicyStats επιστρέφει τους μετρητές όλων των
+ * εκτελέσεων (από BF_Init έως BF_Close) με πολιτική repl_alg, μαζί με την
+ * τρέχουσα αν χρησιμοποιεί την ίδια πολιτική. Έτσι μπορεί να συγκριθεί το
+ * ίδιο φορτίο με διαφορετικές πολιτικές μέσα στο ίδιο πρόγραμμα.
+ */
+BF_ErrorCode BF_GetPolicyStats(const ReplacementAlgorithm repl_alg, BF_Stats *stats);
+
+/*
+ * Η συνάρτηση BF_ResetGlobalStats μηδενίζει όλους τους μετρητές: των
+ * πολιτικών, της τρέχουσας εκτέλεσης και των ανοιχτών αρχείων.
+ */
+void BF_ResetGlobalStats();
+
+/*
+ * Η συνάρτηση BF_PrintStats εκτυπώνει τους μετρητές stats.
+ */
+void BF_PrintStats(const BF_Stats *stats);
+
 /*
  * Η συνάρτηση BF_PrintError βοηθά στην εκτύπωση των σφαλμάτων που δύναται να
  * υπάρξουν με την κλήση συναρτήσεων του επιπέδου αρχείου block. Εκτυπώνεται
@@ -0,0 +1,56 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+/* Η δομή BL_info κρατάει μεταδεδομένα ενός αρχείου φίλτρων Bloom. Το
+αρχείο έχει filters ανεξάρτητα φίλτρα για ακέραια κλειδιά, το καθένα
+lines γραμμές των BL_LINE_BYTES bytes (μία γραμμή της cache). Κάθε κλειδί
+αντιστοιχεί σε μία γραμμή του φίλτρου του και οι hashes θέσεις του
+βρίσκονται μέσα σε αυτήν, οπότε ένας έλεγχος διαβάζει ένα block και μία
+γραμμή. */
+typedef struct {
+    int fd;
+    int filters;
+    int lines;
+    int hashes;
+    int block_size;
+} BL_info;
+
+#define BL_LINE_BYTES 64
+
+/*Η συνάρτηση BL_CreateFile δημιουργεί το αρχείο fileName με filters
+άδεια φίλτρα, το καθένα αρκετά μεγάλο ώστε με expected κλειδιά να δίνει
+λάθος θετικά με πιθανότητα το πολύ fp_rate (0 < fp_rate < 1). Σε
+περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική
+περίπτωση -1.*/
+int BL_CreateFile(
+    char *fileName, /*όνομα αρχείου*/
+    int filters, /*πλήθος φίλτρων*/
+    int expected, /*αναμενόμενα κλειδιά ανά φίλτρο*/
+    double fp_rate /*πιθανότητα λάθους θετικού*/);
+
+/*Η συνάρτηση BL_OpenFile ανοίγει το αρχείο φίλτρων fileName. Σε
+περίπτωση που συμβεί οποιοδήποτε σφάλμα, επιστρέφεται τιμή NULL.*/
+BL_info* BL_OpenFile(char *fileName /*όνομα αρχείου*/);
+
+/*Η συνάρτηση BL_CloseFile κλείνει το αρχείο και αποδεσμεύει την δομή.
+Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
+διαφορετική περίπτωση -1.*/
+int BL_CloseFile(BL_info* header_info);
+
+/*Η συνάρτηση BL_Add προσθέτει το key στο φίλτρο filter. Σε περίπτωση
+που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική περίπτωση
+-1.*/
+int BL_Add(
+    BL_info* header_info, /*επικεφαλίδα του αρχείου*/
+    int filter, /*αριθμός φίλτρου*/
+    int key /*κλειδί*/);
+
+/*Η συνάρτηση BL_MayContain επιστρέφει 0 αν το key σίγουρα δεν έχει
+προστεθεί στο φίλτρο filter, 1 αν μπορεί να έχει προστεθεί και -1 σε
+λάθος.*/
+int BL_MayContain(
+    BL_info* header_info, /*επικεφαλίδα του αρχείου*/
+    int filter, /*αριθμός φίλτρου*/
+    int key /*κλειδί*/);
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,86 @@
+#ifndef BPT_INDEX_H
+#define BPT_INDEX_H
+#include <stddef.h>
+#include <record.h>
+
+/* Η δομή BPT_info κρατάει μεταδεδομένα που σχετίζονται με το B+ δέντρο.
+Τα φύλλα κρατάνε τις εγγραφές ταξινομημένες κατά id και οι εσωτερικοί
+κόμβοι κλειδιά και δείκτες σε block παιδιών. Η χωρητικότητα των κόμβων
+προκύπτει από το μέγεθος του block. Το root είναι -1 στο άδειο δέντρο. */
+typedef struct {
+    int fd;
+    int records;
+    int block_size;
+    int leaf_capacity;
+    int inner_capacity;
+    int root;
+    int height;
+    int nodes;
+} BPT_info;
+
+/* Κατάσταση μιας σάρωσης σε εξέλιξη. */
+typedef struct BPT_Scan BPT_Scan;
+
+/*Η συνάρτηση BPT_CreateFile χρησιμοποιείται για τη δημιουργία και
+κατάλληλη αρχικοποίηση ενός άδειου B+ δέντρου με όνομα fileName.
+Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
+διαφορετική περίπτωση -1.*/
+int BPT_CreateFile(char *fileName /*όνομα αρχείου*/);
+
+/*Η συνάρτηση BPT_OpenFile ανοίγει το αρχείο με όνομα filename και
+διαβάζει από το πρώτο μπλοκ την πληροφορία που αφορά το B+ δέντρο. Σε
+περίπτωση που συμβεί οποιοδήποτε σφάλμα ή το αρχείο δεν είναι B+ δέντρο,
+επιστρέφεται τιμή NULL.*/
+BPT_info* BPT_OpenFile(char *fileName /*όνομα αρχείου*/);
+
+/*Η συνάρτηση BPT_CloseFile κλείνει το αρχείο που προσδιορίζεται μέσα
+στη δομή header_info και αποδεσμεύει την δομή. Σε περίπτωση που
+εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική περίπτωση -1.*/
+int BPT_CloseFile(BPT_info* header_info);
+
+/*Η συνάρτηση BPT_InsertEntry εισάγει την εγγραφή record στο φύλλο που
+της αντιστοιχεί. Ένα γεμάτο φύλλο χωρίζεται στα δύο και το πρώτο id του
+νέου φύλλου εισάγεται στον πατέρα, που μπορεί να χωριστεί κι αυτός έως
+την ρίζα. Επιτρέπονται εγγραφές με ίδιο id. Σε περίπτωση που εκτελεστεί
+επιτυχώς, επιστρέφετε τον αριθμό του block στο οποίο έγινε η εισαγωγή
+(blockId), ενώ σε διαφορετική περίπτωση -1.*/
+int BPT_InsertEntry(BPT_info* header_info, /*επικεφαλίδα του αρχείου*/
+        Record record /*δομή που προσδιορίζει την εγγραφή*/);
+
+/*Η συνάρτηση BPT_BulkLoad χτίζει το δέντρο από κάτω προς τα πάνω από τις
+n εγγραφές του records, που πρέπει να είναι ταξινομημένες κατά id. Τα
+φύλλα γεμίζουν πλήρως και γράφονται σειριακά, και μετά κάθε επίπεδο
+εσωτερικών κόμβων. Αν το δέντρο δεν είναι άδειο, οι εγγραφές εισάγονται
+μία μία. Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
+διαφορετική περίπτωση -1.*/
+int BPT_BulkLoad(BPT_info* header_info, /*επικεφαλίδα του αρχείου*/
+        const Record *records, /*ταξινομημένες εγγραφές*/
+        size_t n /*πλήθος εγγραφών*/);
+
+/* Η συνάρτηση αυτή εκτυπώνει όλες τις εγγραφές με id ίσο με value. Το
+δέντρο διασχίζεται από την ρίζα έως το πρώτο φύλλο που μπορεί να έχει το
+id και οι εγγραφές με το ίδιο id διαβάζονται ακολουθώντας τα επόμενα
+φύλλα. Σε περίπτωση επιτυχίας επιστρέφει το πλήθος των blocks που
+διαβάστηκαν, ενώ σε περίπτωση λάθους επιστρέφει -1.*/
+int BPT_GetAllEntries(BPT_info* header_info, /*επικεφαλίδα του αρχείου*/
+        int value /*τιμή του πεδίου-κλειδιού προς αναζήτηση*/);
+
+/* Η συνάρτηση BPT_ScanOpenRange ξεκινάει μια σάρωση για τις εγγραφές με
+low <= id <= high, που επιστρέφονται σε αύξουσα σειρά id ακολουθώντας
+τους δείκτες των φύλλων. Σε περίπτωση λάθους επιστρέφει NULL.*/
+BPT_Scan* BPT_ScanOpenRange(BPT_info* header_info, /*επικεφαλίδα του αρχείου*/
+        int low, /* μικρότερο id */
+        int high /* μεγαλύτερο id */);
+
+/* Η συνάρτηση BPT_ScanNext επιστρέφει την επόμενη εγγραφή της σάρωσης ή
+NULL στο τέλος της ή σε λάθος. Ο δείκτης δείχνει μέσα στο καρφιτσωμένο
+φύλλο και ισχύει έως την επόμενη κλήση της BPT_ScanNext ή της
+BPT_ScanClose.*/
+const Record* BPT_ScanNext(BPT_Scan* scan);
+
+/* Η συνάρτηση BPT_ScanClose τερματίζει την σάρωση και αποδεσμεύει την
+δομή. Επιστρέφει το πλήθος των blocks που διαβάστηκαν ή -1 αν η σάρωση
+σταμάτησε από λάθος.*/
+int BPT_ScanClose(BPT_Scan* scan);
+
+#endif // BPT_INDEX_H
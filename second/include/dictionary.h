@@ -0,0 +1,90 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+#include <record.h>
+
+/* Η δομή DC_info κρατάει μεταδεδομένα ενός λεξικού για τα πεδία name,
+surname και city (NAME, SURNAME, CITY). Κάθε διαφορετική τιμή ενός πεδίου
+παίρνει τον επόμενο κωδικό του πεδίου, από το 0, και το λεξικό γράφεται
+στο αρχείο του μόλις προστεθεί μια τιμή. Όσο το αρχείο είναι ανοιχτό όλες
+οι τιμές βρίσκονται και στην μνήμη, οπότε η μετατροπή προς τις δύο
+κατευθύνσεις δεν διαβάζει block. */
+typedef struct {
+    int fd;
+    int block_size;
+    int entries;
+} DC_info;
+
+/* Μέγιστο μήκος μιας τιμής και πλήθος κωδικών ανά πεδίο. */
+#define DC_VALUE_SIZE 20
+#define DC_MAX_CODES 65536
+
+/* Εγγραφή με κωδικούς στην θέση των πεδίων name, surname και city. */
+typedef struct {
+    int id;
+    unsigned short name;
+    unsigned short surname;
+    unsigned short city;
+    char record[15];
+} DC_tuple;
+
+/*Η συνάρτηση DC_CreateFile δημιουργεί το άδειο λεξικό fileName. Σε
+περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική
+περίπτωση -1.*/
+int DC_CreateFile(char *fileName /*όνομα αρχείου*/);
+
+/*Η συνάρτηση DC_OpenFile ανοίγει το λεξικό fileName και διαβάζει όλες τις
+τιμές του. Σε περίπτωση που συμβεί οποιοδήποτε σφάλμα, επιστρέφεται τιμή
+NULL.*/
+DC_info* DC_OpenFile(char *fileName /*όνομα αρχείου*/);
+
+/*Η συνάρτηση DC_CloseFile κλείνει το λεξικό και αποδεσμεύει την δομή. Σε
+περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική
+περίπτωση -1.*/
+int DC_CloseFile(DC_info* header_info);
+
+/*Η συνάρτηση DC_Encode επιστρέφει τον κωδικό της τιμής value του πεδίου
+attribute, και αν δεν υπάρχει την προσθέτει στο λεξικό. Επιστρέφει -1 σε
+λάθος ή αν το πεδίο έχει ήδη DC_MAX_CODES τιμές.*/
+int DC_Encode(
+    DC_info* header_info, /*επικεφαλίδα του λεξικού*/
+    Record_Attribute attribute, /*NAME, SURNAME ή CITY*/
+    const char *value /*τιμή του πεδίου*/);
+
+/*Η συνάρτηση DC_Lookup επιστρέφει τον κωδικό της τιμής value του πεδίου
+attribute χωρίς να αλλάξει το λεξικό, ή -1 αν η τιμή δεν υπάρχει, οπότε
+καμία εγγραφή δεν την έχει.*/
+int DC_Lookup(
+    DC_info* header_info, /*επικεφαλίδα του λεξικού*/
+    Record_Attribute attribute, /*NAME, SURNAME ή CITY*/
+    const char *value /*τιμή του πεδίου*/);
+
+/*Η συνάρτηση DC_Decode επιστρέφει την τιμή του κωδικού code του πεδίου
+attribute, ή NULL αν ο κωδικός δεν υπάρχει. Η τιμή έχει DC_VALUE_SIZE
+bytes συμπληρωμένα με '\0'.*/
+const char* DC_Decode(
+    DC_info* header_info, /*επικεφαλίδα του λεξικού*/
+    Record_Attribute attribute, /*NAME, SURNAME ή CITY*/
+    int code /*κωδικός της τιμής*/);
+
+/*Η συνάρτηση DC_EncodeRecord γράφει στο tuple την εγγραφή record με τους
+κωδικούς των πεδίων της, προσθέτοντας στο λεξικό όσες τιμές λείπουν.
+Επιστρέφει 0, ή -1 σε λάθος.*/
+int DC_EncodeRecord(
+    DC_info* header_info, /*επικεφαλίδα του λεξικού*/
+    const Record *record, /*εγγραφή προς κωδικοποίηση*/
+    DC_tuple *tuple /*η κωδικοποιημένη εγγραφή*/);
+
+/*Η συνάρτηση DC_DecodeRecord ανασυνθέτει στο record την εγγραφή tuple,
+με τα υπόλοιπα bytes των πεδίων μηδενικά όπως στην randomRecord.*/
+void DC_DecodeRecord(
+    DC_info* header_info, /*επικεφαλίδα του λεξικού*/
+    const DC_tuple *tuple, /*κωδικοποιημένη εγγραφή*/
+    Record *record /*η εγγραφή που ανασυντέθηκε*/);
+
+/*Η συνάρτηση DC_Code επιστρέφει τον κωδικό του πεδίου attribute (NAME,
+SURNAME ή CITY) της κωδικοποιημένης εγγραφής tuple, ή -1 για άλλο πεδίο.*/
+int DC_Code(
+    const DC_tuple *tuple, /*κωδικοποιημένη εγγραφή*/
+    Record_Attribute attribute /*πεδίο*/);
+
+#endif // DICTIONARY_H
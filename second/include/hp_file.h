@@ -1,5 +1,6 @@
 #ifndef HP_FILE_H
 #define HP_FILE_H
+#include <stddef.h>
 #include <record.h>
 
 
@@ -9,15 +10,53 @@ typedef struct {
     int fd;
     int records;
     int density;
+    int block_size;
+    int layout;
 } HP_info;
 
+/* Μορφές block του αρχείου σωρού. Στην HP_LAYOUT_PAX κάθε block κρατάει
+χωριστά τα id και κάθε άλλο πεδίο των εγγραφών του. Στην
+HP_LAYOUT_SLOTTED οι εγγραφές έχουν μεταβλητό μήκος, με τα πεδία χωρίς
+τα αχρησιμοποίητα bytes τους, και βρίσκονται από κατάλογο θέσεων (βλ.
+slotted_page.h), οπότε το density είναι μόνο το ελάχιστο πλήθος εγγραφών
+ενός block. Στην HP_LAYOUT_DICT τα name, surname και city αποθηκεύονται
+ως κωδικοί δύο bytes του λεξικού fileName.dict (βλ. dictionary.h). */
+#define HP_LAYOUT_ROW 0
+#define HP_LAYOUT_PAX 1
+#define HP_LAYOUT_SLOTTED 2
+#define HP_LAYOUT_DICT 3
+
 /*Η συνάρτηση HP_CreateFile χρησιμοποιείται για τη δημιουργία και
 κατάλληλη αρχικοποίηση ενός άδειου αρχείου σωρού με όνομα fileName.
+Δίπλα του το αρχείο fileName.zone κρατάει το μικρότερο και το μεγαλύτερο
+id κάθε block (χάρτης ζωνών) και δημιουργείται στο πρώτο άνοιγμα.
 Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
 διαφορετική περίπτωση -1.*/
 int HP_CreateFile(
     char *fileName /*όνομα αρχείου*/);
 
+/*Η συνάρτηση HP_CreateFileEx λειτουργεί όπως η HP_CreateFile και
+επιπλέον ορίζει την μορφή των block του αρχείου (HP_LAYOUT_ROW,
+HP_LAYOUT_PAX, HP_LAYOUT_SLOTTED ή HP_LAYOUT_DICT). Για την HP_LAYOUT_DICT
+δημιουργεί και το άδειο λεξικό fileName.dict.*/
+int HP_CreateFileEx(
+    char *fileName, /*όνομα αρχείου*/
+    int layout /*μορφή των block*/);
+
+/*Η συνάρτηση HP_CreateFileBloom λειτουργεί όπως η HP_CreateFileEx και
+επιπλέον δημιουργεί το αρχείο fileName.bloom με ένα φίλτρο Bloom για τα
+id του σωρού, που δίνει λάθος θετικά με πιθανότητα το πολύ fp_rate όσο ο
+σωρός έχει έως expected εγγραφές. Κάθε εισαγωγή προσθέτει το id της στο
+φίλτρο και οι αναζητήσεις ισότητας (HP_GetAllEntries και HP_ScanOpenRange
+με low == high) διαβάζουν πρώτα μία γραμμή του φίλτρου, οπότε ένα id που
+δεν υπάρχει συνήθως δεν διαβάζει κανένα block δεδομένων. Σε περίπτωση που
+εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική περίπτωση -1.*/
+int HP_CreateFileBloom(
+    char *fileName, /*όνομα αρχείου*/
+    int layout, /*μορφή των block*/
+    int expected, /*αναμενόμενες εγγραφές*/
+    double fp_rate /*πιθανότητα λάθους θετικού*/);
+
 /* Η συνάρτηση HP_OpenFile ανοίγει το αρχείο με όνομα filename και
 διαβάζει από το πρώτο μπλοκ την πληροφορία που αφορά το αρχείο σωρού.
 Κατόπιν, ενημερώνεται μια δομή που κρατάτε όσες πληροφορίες κρίνονται
@@ -48,6 +87,17 @@ int HP_InsertEntry(
     HP_info* header_info, /* επικεφαλίδα του αρχείου*/
     Record record /* δομή που προσδιορίζει την εγγραφή */ );
 
+/* Η συνάρτηση HP_BulkInsert εισάγει στο αρχείο σωρού τις n εγγραφές του
+πίνακα records με την σειρά τους. Συμπληρώνει πρώτα το τελευταίο block αν
+είναι μισογεμάτο και στην συνέχεια γεμίζει ολόκληρα νέα block, χωρίς να
+τυπώνει τις εγγραφές. Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται
+0, ενώ σε διαφορετική περίπτωση -1.
+*/
+int HP_BulkInsert(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    const Record *records, /* οι εγγραφές προς εισαγωγή */
+    size_t n /* πλήθος εγγραφών */ );
+
 /*Η συνάρτηση αυτή χρησιμοποιείται για την εκτύπωση όλων των εγγραφών
 που υπάρχουν στο αρχείο κατακερματισμού οι οποίες έχουν τιμή στο
 πεδίο-κλειδί ίση με value. Η πρώτη δομή δίνει πληροφορία για το αρχείο
@@ -57,10 +107,97 @@ int HP_InsertEntry(
 και του πεδίου-κλειδιού). Να επιστρέφεται επίσης το πλήθος των blocks που
 διαβάστηκαν μέχρι να βρεθούν όλες οι εγγραφές. Σε περίπτωση επιτυχίας
 επιστρέφει το πλήθος των blocks που διαβάστηκαν, ενώ σε περίπτωση λάθους επιστρέφει -1.
+Υλοποιείται με την HP_ScanEach.
 */
 int HP_GetAllEntries(
     HP_info* header_info, /* επικεφαλίδα του αρχείου*/
     int id /* η τιμή id της εγγραφής στην οποία πραγματοποιείται η αναζήτηση*/);
 
 
+/* Κατηγόρημα της σάρωσης: επιστρέφει μη μηδενική τιμή για τις εγγραφές
+που ζητάμε. Το arg είναι αυτό που δόθηκε στην HP_ScanOpen. */
+typedef int (*HP_Predicate)(const Record *record, void *arg);
+
+/* Callback της HP_ScanEach: επιστρέφει μη μηδενική τιμή για να σταματήσει
+η σάρωση. */
+typedef int (*HP_Callback)(const Record *record, void *arg);
+
+/* Κατάσταση μιας σάρωσης σε εξέλιξη. */
+typedef struct HP_Scan HP_Scan;
+
+/* Η συνάρτηση HP_ScanOpen ξεκινάει μια σάρωση του αρχείου σωρού για τις
+εγγραφές που ικανοποιούν το predicate (όλες αν είναι NULL). Σε περίπτωση
+λάθους επιστρέφει NULL.
+*/
+HP_Scan* HP_ScanOpen(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    HP_Predicate predicate, /* κατηγόρημα ή NULL */
+    void *arg /* όρισμα του κατηγορήματος */ );
+
+/* Η συνάρτηση HP_ScanOpenRange ξεκινάει μια σάρωση για τις εγγραφές με
+low <= id <= high. Τα block των οποίων το διάστημα id στον χάρτη ζωνών
+δεν τέμνει το [low, high] δεν διαβάζονται. Στα αρχεία PAX η σύγκριση
+γίνεται με εντολές SIMD πάνω στα id και ανασυντίθενται μόνο οι εγγραφές
+που ταιριάζουν.
+*/
+HP_Scan* HP_ScanOpenRange(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    int low, /* μικρότερο id */
+    int high /* μεγαλύτερο id */ );
+
+/* Η συνάρτηση HP_ScanOpenEquals ξεκινάει μια σάρωση για τις εγγραφές με
+πεδίο attribute (NAME, SURNAME ή CITY) ίσο με value. Στα αρχεία
+HP_LAYOUT_DICT η value μετατρέπεται μία φορά στον κωδικό της, οι εγγραφές
+συγκρίνονται στον κωδικό και ανασυντίθενται μόνο όσες ταιριάζουν· αν η
+value δεν υπάρχει στο λεξικό δεν διαβάζεται κανένα block. Σε περίπτωση
+λάθους επιστρέφει NULL.
+*/
+HP_Scan* HP_ScanOpenEquals(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    Record_Attribute attribute, /* πεδίο της σύγκρισης */
+    const char *value /* τιμή του πεδίου */ );
+
+/* Η συνάρτηση HP_ScanNext επιστρέφει την επόμενη εγγραφή της σάρωσης ή
+NULL στο τέλος της ή σε λάθος. Ο δείκτης δείχνει μέσα στο καρφιτσωμένο
+block (σε αρχεία PAX, SLOTTED και DICT σε αντίγραφο της εγγραφής) και
+ισχύει έως την επόμενη κλήση της HP_ScanNext ή της HP_ScanClose.
+*/
+const Record* HP_ScanNext(HP_Scan* scan);
+
+/* Η συνάρτηση HP_ScanClose τερματίζει την σάρωση, ξεκαρφιτσώνει ό,τι
+block έχει μείνει και αποδεσμεύει την δομή. Επιστρέφει το πλήθος των
+blocks που διαβάστηκαν ή -1 αν η σάρωση σταμάτησε από λάθος.
+*/
+int HP_ScanClose(HP_Scan* scan);
+
+/* Η συνάρτηση HP_ScanEach καλεί την callback για κάθε εγγραφή που
+ικανοποιεί το predicate, έως το τέλος του αρχείου ή έως ότου η callback
+επιστρέψει μη μηδενική τιμή. Επιστρέφει το πλήθος των blocks που
+διαβάστηκαν ή -1 σε λάθος.
+*/
+int HP_ScanEach(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    HP_Predicate predicate, /* κατηγόρημα ή NULL */
+    void *predicate_arg, /* όρισμα του κατηγορήματος */
+    HP_Callback callback, /* καλείται για κάθε εγγραφή */
+    void *callback_arg /* όρισμα της callback */ );
+
+/* Η συνάρτηση HP_ScanParallel λειτουργεί όπως η HP_ScanEach με threads
+νήματα (όσους επεξεργαστές έχει το σύστημα αν threads <= 0). Τα block
+μοιράζονται σε τμήματα συνεχόμενων block και όποιο νήμα τελειώνει νωρίς
+παίρνει τμήματα των άλλων. Η callback καλείται ταυτόχρονα από τα νήματα,
+χωρίς σειρά, και πρέπει να είναι ασφαλής για πολλά νήματα· όταν επιστρέψει
+μη μηδενική τιμή σταματούν όλα. Το επίπεδο BF πρέπει να έχει αρχικοποιηθεί
+με BF_CONCURRENT και κάθε νήμα κρατάει καρφιτσωμένα έως 9 block. Επιστρέφει
+το πλήθος των blocks που διαβάστηκαν ή -1 σε λάθος.
+*/
+int HP_ScanParallel(
+    HP_info* header_info, /* επικεφαλίδα του αρχείου*/
+    HP_Predicate predicate, /* κατηγόρημα ή NULL */
+    void *predicate_arg, /* όρισμα του κατηγορήματος */
+    HP_Callback callback, /* καλείται για κάθε εγγραφή */
+    void *callback_arg, /* όρισμα της callback */
+    int threads /* πλήθος νημάτων */ );
+
+
 #endif // HP_FILE_H
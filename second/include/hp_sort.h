@@ -0,0 +1,31 @@
+#ifndef HP_SORT_H
+#define HP_SORT_H
+#include <stddef.h>
+#include <record.h>
+
+/* Μετρητές μιας ταξινόμησης. */
+typedef struct {
+    long long records; /* εγγραφές που ταξινομήθηκαν */
+    int runs;          /* ταξινομημένα τμήματα (runs) της πρώτης φάσης */
+    int passes;        /* φάσεις συγχώνευσης, μαζί με την τελική */
+    int fan_in;        /* μέγιστο πλήθος runs που συγχωνεύονται μαζί */
+} HP_SortStats;
+
+/*Η συνάρτηση HP_Sort δημιουργεί το αρχείο σωρού output με τις εγγραφές
+του αρχείου σωρού input ταξινομημένες κατά το πεδίο key (ID, NAME, SURNAME
+ή CITY, και ίσες τιμές κατά id). Οι εγγραφές διαβάζονται μέσα από το
+επίπεδο BF σε ταξινομημένα runs των memory bytes, που γράφονται σειριακά
+σε προσωρινά αρχεία output.runN και συγχωνεύονται με δέντρο ηττημένων
+(loser tree) όσα χωράνε στην μνήμη μαζί, με δύο buffer ανά run ώστε το
+επόμενο τμήμα κάθε run να είναι ήδη διαβασμένο όταν χρειαστεί. Με
+BF_READAHEAD το λειτουργικό προφορτώνει τα επόμενα block των runs. Αν
+το stats δεν είναι NULL επιστρέφονται εκεί οι μετρητές. Σε περίπτωση που
+εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική περίπτωση -1.*/
+int HP_Sort(
+    char *input, /*όνομα αρχείου εισόδου*/
+    char *output, /*όνομα του ταξινομημένου αρχείου*/
+    Record_Attribute key, /*πεδίο ταξινόμησης*/
+    size_t memory, /*bytes μνήμης για την ταξινόμηση*/
+    HP_SortStats *stats /*μετρητές ή NULL*/);
+
+#endif // HP_SORT_H
@@ -1,14 +1,26 @@
 #ifndef HT_TABLE_H
 #define HT_TABLE_H
 #include <record.h>
+#include <dictionary.h>
 
 typedef struct {
     int fd;
     int records;
     int density;
     int buckets;
+    int block_size;
+    int layout;
 } HT_info;
 
+/* Μορφές block του αρχείου κατακερματισμού. Στην HT_LAYOUT_SLOTTED οι
+εγγραφές έχουν μεταβλητό μήκος και βρίσκονται από κατάλογο θέσεων (βλ.
+slotted_page.h), οπότε το density είναι μόνο το ελάχιστο πλήθος εγγραφών
+ενός block. Στην HT_LAYOUT_DICT τα name, surname και city αποθηκεύονται
+ως κωδικοί δύο bytes του λεξικού fileName.dict (βλ. dictionary.h). */
+#define HT_LAYOUT_ROW 0
+#define HT_LAYOUT_SLOTTED 1
+#define HT_LAYOUT_DICT 2
+
 typedef struct {
     int records;
     int next_block;
@@ -24,6 +36,29 @@ int HT_CreateFile(
         char *fileName, /*όνομα αρχείου*/
         int buckets /*αριθμός από buckets*/);
 
+/*Η συνάρτηση HT_CreateFileEx λειτουργεί όπως η HT_CreateFile και
+επιπλέον ορίζει την μορφή των block του αρχείου (HT_LAYOUT_ROW,
+HT_LAYOUT_SLOTTED ή HT_LAYOUT_DICT). Για την HT_LAYOUT_DICT δημιουργεί
+και το άδειο λεξικό fileName.dict.*/
+int HT_CreateFileEx(
+        char *fileName, /*όνομα αρχείου*/
+        int buckets, /*αριθμός από buckets*/
+        int layout /*μορφή των block*/);
+
+/*Η συνάρτηση HT_CreateFileBloom λειτουργεί όπως η HT_CreateFileEx και
+επιπλέον δημιουργεί το αρχείο fileName.bloom με ένα φίλτρο Bloom για την
+αλυσίδα κάθε κάδου, που δίνει λάθος θετικά με πιθανότητα το πολύ fp_rate
+όσο το αρχείο έχει έως expected εγγραφές. Η HT_GetAllEntries διαβάζει
+πρώτα μία γραμμή του φίλτρου του κάδου, οπότε για ένα id που δεν υπάρχει
+συνήθως δεν διαβάζεται κανένα block της αλυσίδας. Σε περίπτωση που
+εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε διαφορετική περίπτωση -1.*/
+int HT_CreateFileBloom(
+        char *fileName, /*όνομα αρχείου*/
+        int buckets, /*αριθμός από buckets*/
+        int layout, /*μορφή των block*/
+        int expected, /*αναμενόμενες εγγραφές*/
+        double fp_rate /*πιθανότητα λάθους θετικού*/);
+
 /*Η συνάρτηση HT_OpenFile ανοίγει το αρχείο με όνομα filename
 και διαβάζει από το πρώτο μπλοκ την πληροφορία που αφορά το
 αρχείο κατακερματισμού. Κατόπιν, ενημερώνεται μια δομή που κρατάτε
@@ -35,6 +70,13 @@ int HT_CreateFile(
 τότε αυτό επίσης θεωρείται σφάλμα. */
 HT_info* HT_OpenFile(char *fileName /*όνομα αρχείου*/);
 
+/*Η συνάρτηση HT_OpenFileEx λειτουργεί όπως η HT_OpenFile, αλλά ανοίγει το
+αρχείο στο επίπεδο BF με τον τρόπο πρόσβασης mode (BF_FILE_POOL ή
+BF_FILE_MMAP). Τα αρχεία κατακερματισμού που διαβάζονται συχνά και χωράνε
+στην μνήμη μπορούν να ανοιχτούν με BF_FILE_MMAP.*/
+HT_info* HT_OpenFileEx(char *fileName, /*όνομα αρχείου*/
+        int mode /*τρόπος πρόσβασης του επιπέδου BF*/);
+
 /*Η συνάρτηση HT_CloseFile κλείνει το αρχείο που προσδιορίζεται μέσα
 στη δομή header_info. Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται
 0, ενώ σε διαφορετική περίπτωση -1. Η συνάρτηση είναι υπεύθυνη και για την
@@ -58,6 +100,11 @@ int HT_InsertEntry(HT_info* header_info, /*επικεφαλίδα του αρχ
 int HT_GetAllEntries(HT_info* header_info, /*επικεφαλίδα του αρχείου*/
         int value /*τιμή του πεδίου-κλειδιού προς αναζήτηση*/);
 
+/*Η συνάρτηση HT_Dictionary επιστρέφει το λεξικό ενός αρχείου
+HT_LAYOUT_DICT, ή NULL για τις άλλες μορφές. Το λεξικό ανήκει στο αρχείο
+και κλείνει με την HT_CloseFile.*/
+DC_info* HT_Dictionary(HT_info* header_info /*επικεφαλίδα του αρχείου*/);
+
 int HT_HashStatistics(char * filename);
 
 #endif // HT_FILE_H
@@ -0,0 +1,101 @@
+#ifndef SF_FILE_H
+#define SF_FILE_H
+#include <record.h>
+
+/* Η δομή SF_info κρατάει μεταδεδομένα που σχετίζονται με το ταξινομημένο
+αρχείο. Οι sorted πρώτες εγγραφές είναι ταξινομημένες κατά id στα block
+1, 2, ... και ακολουθούν οι delta εγγραφές της περιοχής αλλαγών, με την
+σειρά εισαγωγής τους. */
+typedef struct {
+    int fd;
+    int records;
+    int density;
+    int block_size;
+    int sorted;
+    int delta;
+    int delta_blocks;
+} SF_info;
+
+/* Κατάσταση μιας σάρωσης σε εξέλιξη. */
+typedef struct SF_Scan SF_Scan;
+
+/*Η συνάρτηση SF_CreateFile χρησιμοποιείται για τη δημιουργία και
+κατάλληλη αρχικοποίηση ενός άδειου ταξινομημένου αρχείου με όνομα
+fileName. Η περιοχή αλλαγών χωράει delta_blocks block εγγραφών που δεν
+ήρθαν με αύξουσα σειρά id· όταν γεμίσει συγχωνεύεται με τις ταξινομημένες.
+Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
+διαφορετική περίπτωση -1.*/
+int SF_CreateFile(
+    char *fileName, /*όνομα αρχείου*/
+    int delta_blocks /*block της περιοχής αλλαγών*/);
+
+/* Η συνάρτηση SF_OpenFile ανοίγει το αρχείο με όνομα filename και
+διαβάζει από το πρώτο μπλοκ την πληροφορία που αφορά το ταξινομημένο
+αρχείο, και στην μνήμη τις εγγραφές της περιοχής αλλαγών. Σε περίπτωση
+που συμβεί οποιοδήποτε σφάλμα, επιστρέφεται τιμή NULL.
+*/
+SF_info* SF_OpenFile( char *fileName /* όνομα αρχείου */ );
+
+/* Η συνάρτηση SF_CloseFile κλείνει το αρχείο που προσδιορίζεται
+μέσα στη δομή header_info και αποδεσμεύει την δομή. Η περιοχή αλλαγών
+δεν συγχωνεύεται. Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0,
+ενώ σε διαφορετική περίπτωση -1.
+*/
+int SF_CloseFile( SF_info* header_info );
+
+/* Η συνάρτηση SF_InsertEntry εισάγει την εγγραφή record. Αν το id της
+δεν είναι μικρότερο από κανένα ταξινομημένο id, η εγγραφή μπαίνει στο
+τέλος των ταξινομημένων· αλλιώς μπαίνει στην περιοχή αλλαγών. Αν η
+περιοχή αλλαγών είναι γεμάτη, συγχωνεύεται πρώτα, και αν αποτύχει η
+συγχώνευση το αρχείο μένει αμετάβλητο. Σε περίπτωση που εκτελεστεί
+επιτυχώς, επιστρέφετε τον αριθμό του block στο οποίο έγινε η εισαγωγή
+(blockId), που ισχύει έως την επόμενη συγχώνευση, ενώ σε διαφορετική
+περίπτωση -1.
+*/
+int SF_InsertEntry(
+    SF_info* header_info, /* επικεφαλίδα του αρχείου*/
+    Record record /* δομή που προσδιορίζει την εγγραφή */ );
+
+/* Η συνάρτηση SF_Merge συγχωνεύει την περιοχή αλλαγών με τις
+ταξινομημένες εγγραφές. Οι ταξινομημένες εγγραφές μετακινούνται από το
+τέλος προς την αρχή, οπότε δεν χρειάζεται δεύτερο αρχείο και δεν
+αγγίζονται τα block πριν από την θέση του μικρότερου id της περιοχής
+αλλαγών. Σε περίπτωση που εκτελεστεί επιτυχώς, επιστρέφεται 0, ενώ σε
+διαφορετική περίπτωση -1.
+*/
+int SF_Merge( SF_info* header_info );
+
+/* Η συνάρτηση αυτή εκτυπώνει όλες τις εγγραφές με id ίσο με value.
+Το πρώτο block με id >= value βρίσκεται με δυαδική αναζήτηση στα
+ταξινομημένα block, οπότε διαβάζονται O(log N) block συν όσα έχουν
+εγγραφές με αυτό το id. Η περιοχή αλλαγών κρατιέται ταξινομημένη στην
+μνήμη όσο το αρχείο είναι ανοιχτό και δεν διαβάζεται. Σε περίπτωση
+επιτυχίας επιστρέφει το πλήθος των blocks που διαβάστηκαν, ενώ σε
+περίπτωση λάθους επιστρέφει -1.
+*/
+int SF_GetAllEntries(
+    SF_info* header_info, /* επικεφαλίδα του αρχείου*/
+    int value /* η τιμή id της εγγραφής στην οποία πραγματοποιείται η αναζήτηση*/);
+
+/* Η συνάρτηση SF_ScanOpenRange ξεκινάει μια σάρωση για τις εγγραφές με
+low <= id <= high, που επιστρέφονται σε αύξουσα σειρά id. Σε περίπτωση
+λάθους επιστρέφει NULL.
+*/
+SF_Scan* SF_ScanOpenRange(
+    SF_info* header_info, /* επικεφαλίδα του αρχείου*/
+    int low, /* μικρότερο id */
+    int high /* μεγαλύτερο id */ );
+
+/* Η συνάρτηση SF_ScanNext επιστρέφει την επόμενη εγγραφή της σάρωσης ή
+NULL στο τέλος της ή σε λάθος. Ο δείκτης ισχύει έως την επόμενη κλήση
+της SF_ScanNext ή της SF_ScanClose.
+*/
+const Record* SF_ScanNext(SF_Scan* scan);
+
+/* Η συνάρτηση SF_ScanClose τερματίζει την σάρωση και αποδεσμεύει την
+δομή. Επιστρέφει το πλήθος των blocks που διαβάστηκαν ή -1 αν η σάρωση
+σταμάτησε από λάθος.
+*/
+int SF_ScanClose(SF_Scan* scan);
+
+#endif // SF_FILE_H
@@ -8,6 +8,7 @@ typedef struct {
     int records;
     int density;
     int buckets;
+    int block_size;
     char record_attribute[15];
     char primary_data_file[20];
 } SHT_info;
@@ -0,0 +1,46 @@
+#ifndef SLOTTED_PAGE_H
+#define SLOTTED_PAGE_H
+#include <record.h>
+
+/* Μορφή block με κατάλογο θέσεων (slotted page) για εγγραφές μεταβλητού
+μήκους. Οι εγγραφές γράφονται η μία μετά την άλλη από την αρχή του block:
+το id και μετά τα πεδία record, name, surname και city, το καθένα ως ένα
+byte μήκους και τους χαρακτήρες του χωρίς το τελικό '\0'. Ο κατάλογος
+μεγαλώνει από το τέλος του χώρου προς τα πίσω, με μία SP_slot για κάθε
+εγγραφή. Το πλήθος των εγγραφών το κρατάει ο καλών, π.χ. στο
+HP_block_info ή στο HT_block_info που ακολουθεί τον χώρο. */
+typedef struct {
+    unsigned short offset;
+    unsigned short length;
+} SP_slot;
+
+/* Το μέγιστο μήκος μιας εγγραφής μαζί με την θέση της στον κατάλογο. */
+#define SP_MAX_TUPLE (sizeof(int) + 4 + sizeof(((Record *) 0)->record) \
+    + sizeof(((Record *) 0)->name) + sizeof(((Record *) 0)->surname) \
+    + sizeof(((Record *) 0)->city) + sizeof(SP_slot))
+
+/*Η συνάρτηση SP_Append γράφει την εγγραφή record μετά τις count
+εγγραφές ενός χώρου space bytes που ξεκινάει στο data. Επιστρέφει 0 αν
+χώρεσε, ενώ σε διαφορετική περίπτωση -1, οπότε ο χώρος δεν αλλάζει.*/
+int SP_Append(
+    char *data, /*αρχή του χώρου*/
+    int space, /*μέγεθος του χώρου σε bytes*/
+    int count, /*εγγραφές που έχει ήδη ο χώρος*/
+    const Record *record /*εγγραφή προς εισαγωγή*/);
+
+/*Η συνάρτηση SP_Get ανασυνθέτει στο record την εγγραφή της θέσης slot,
+με τα υπόλοιπα bytes των πεδίων μηδενικά όπως στην randomRecord.*/
+void SP_Get(
+    const char *data, /*αρχή του χώρου*/
+    int space, /*μέγεθος του χώρου σε bytes*/
+    int slot, /*θέση της εγγραφής*/
+    Record *record /*η εγγραφή που διαβάστηκε*/);
+
+/*Η συνάρτηση SP_Id επιστρέφει το id της εγγραφής της θέσης slot χωρίς να
+ανασυνθέσει την υπόλοιπη εγγραφή.*/
+int SP_Id(
+    const char *data, /*αρχή του χώρου*/
+    int space, /*μέγεθος του χώρου σε bytes*/
+    int slot /*θέση της εγγραφής*/);
+
+#endif // SLOTTED_PAGE_H
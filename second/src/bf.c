@@ -0,0 +1,3295 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sched.h>
+#include <time.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "bf.h"
+
+/*
+ * Υλοποίηση του επιπέδου BF. Η ενδιάμεση μνήμη αποτελείται από
+ * pool_frames πλαίσια (frames) των block_size bytes, όπως ορίστηκαν στην
+ * BF_InitEx (BF_BUFFER_SIZE και BF_BLOCK_SIZE για την BF_Init). Ένας πίνακας
+ * κατακερματισμού αντιστοιχεί το ζεύγος (file_desc, block_num) στο πλαίσιο
+ * που το φιλοξενεί, ενώ η πολιτική αντικατάστασης επιλέγει το θύμα όταν
+ * δεν υπάρχει ελεύθερο πλαίσιο.
+ *
+ * Με την σημαία BF_CONCURRENT τα πλαίσια μοιράζονται σε ανεξάρτητα
+ * τμήματα (partitions), το καθένα με δικό του latch, πίνακα
+ * κατακερματισμού και πολιτική. Ένα block ανήκει πάντα στο τμήμα που
+ * ορίζει ο κατακερματισμός του (file_desc, block_num). Οι μετρητές pin
+ * είναι ατομικοί, ώστε το BF_UnpinBlock να μην χρειάζεται latch.
+ */
+
+#define BF_NONE -1
+#define BF_LRU_K_DEPTH 2
+#define BF_MAX_PARTITIONS 64
+#define BF_MIN_PARTITION_FRAMES 16
+#define BF_BATCH 64
+#define BF_READAHEAD_MIN 4
+#define BF_WRITER_CHUNK 8
+#define BF_PAGE_ALIGN 4096
+#define BF_HUGE_PAGE (2 << 20)
+#define BF_READAHEAD_MAX_BYTES (4 << 20)
+#define BF_MAP_MIN_BYTES ((size_t) 1 << 30)
+#define BF_MAP_MOVE_TRIES 1000
+#define BF_FILE_CHUNK 256
+#define BF_LOG_BUFFER (1 << 20)
+#define BF_LOG_MAGIC 0x474C4642u
+#define BF_LOG_FILE 1
+#define BF_LOG_PAGE 2
+#define BF_LOG_COMMIT 3
+#define BF_FILE_CHUNKS (BF_MAX_OPEN_FILES / BF_FILE_CHUNK)
+
+enum {
+    BF_LIST_FREE = -1,
+    BF_LIST_FIRST = 0,  /* LRU/MRU: η μοναδική λίστα, 2Q: A1in, ARC: T1 */
+    BF_LIST_SECOND = 1  /* 2Q: Am, ARC: T2 */
+};
+
+struct BF_Block {
+    int file_desc;
+    int block_num;
+    int partition;
+    int frame;
+    bool pinned;
+    bool mapped;
+    char *data;
+};
+
+typedef struct {
+    int prev;
+    int next;
+} BF_Link;
+
+typedef struct {
+    int head;
+    int tail;
+    int size;
+} BF_List;
+
+typedef struct {
+    int file_desc;
+    int block_num;
+    atomic_int pin_count;
+    atomic_bool dirty;
+    atomic_bool unlogged;
+    atomic_bool changed;
+    uint64_t lsn;
+    bool referenced;
+    int list;
+    int heap_pos;
+    unsigned long history[BF_LRU_K_DEPTH];
+    char *data;
+} BF_Frame;
+
+/*
+ * Εγγραφές "φαντάσματα": αναγνωριστικά block που έχουν απομακρυνθεί από
+ * την μνήμη αλλά θυμόμαστε ότι τα είδαμε πρόσφατα (A1out του 2Q, B1/B2
+ * του ARC, ιστορικό του LRU-K).
+ */
+typedef struct {
+    int file_desc;
+    int block_num;
+    int list;
+    int hash_next;
+    unsigned long history[BF_LRU_K_DEPTH];
+} BF_Ghost;
+
+/*
+ * Κάθε ανοικτό αρχείο κρατάει το όνομά του, ώστε ο descriptor του
+ * λειτουργικού (fd) να κλείνει όταν το αρχείο μένει αδρανές και να
+ * ξανανοίγει στην επόμενη I/O. Τα fd, fd_users, fd_prev και fd_next
+ * προστατεύονται από το fd_lock.
+ */
+typedef struct {
+    bool used;
+    char *path;
+    int next_free;
+    int fd;
+    int fd_users;
+    int fd_prev;
+    int fd_next;
+    atomic_bool direct;
+    atomic_bool needs_sync;
+    int log_id;
+    atomic_int blocks;
+    pthread_mutex_t alloc_lock;
+
+    pthread_mutex_t ra_lock;
+    int ra_last;
+    int ra_front;
+    int ra_window;
+
+    BF_FileMode mode;
+    _Atomic(char *) map;
+    size_t map_size;
+    atomic_int map_pins;
+    atomic_bool map_moving;
+} BF_File;
+
+typedef struct {
+    bool from_ghost;
+    int ghost_list;
+    int target_list;
+    unsigned long history[BF_LRU_K_DEPTH];
+} BF_Admission;
+
+/*
+ * Θέση του πίνακα σελίδων: το ζεύγος (file_desc, block_num) πακεταρισμένο
+ * σε 64 bit και το πλαίσιο που το φιλοξενεί.
+ */
+typedef struct {
+    uint64_t key;
+    int frame;
+} BF_Slot;
+
+typedef struct {
+    pthread_mutex_t latch;
+    ReplacementAlgorithm policy;
+    int frames;
+    int block_size;
+    char *memory;
+    BF_Frame *frame;
+    BF_Link *link;
+    uint8_t *ctrl;
+    BF_Slot *slots;
+    unsigned int group_mask;
+    int growth_left;
+    BF_List free_list;
+    BF_List lists[2];
+    int clock_hand;
+    unsigned long tick;
+
+    int ghost_capacity;
+    BF_Ghost *ghost;
+    BF_Link *ghost_link;
+    int *ghost_buckets;
+    unsigned int ghost_mask;
+    BF_List ghost_free;
+    BF_List ghost_lists[2];
+
+    int twoq_kin;
+    int arc_p;
+
+    int *heap;
+    int heap_size;
+
+    atomic_int dirty_frames;
+
+    BF_Stats total;
+    BF_Stats *file_stats[BF_FILE_CHUNKS];
+} BF_Pool;
+
+/*
+ * Εγγραφή του ημερολογίου: ακολουθούν length bytes, το όνομα του αρχείου
+ * (BF_LOG_FILE), η εικόνα του block (BF_LOG_PAGE) ή ο αύξων αριθμός της
+ * BF_Commit που ολοκληρώθηκε (BF_LOG_COMMIT). Το crc καλύπτει την
+ * επικεφαλίδα και τα δεδομένα, ώστε η ανάκτηση να σταματάει σε μισογραμμένη
+ * εγγραφή.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t length;
+    uint32_t file_id;
+    int32_t block_num;
+    uint32_t crc;
+} BF_LogRecord;
+
+/* Εικόνα σελίδας του ημερολογίου που δεν έχει εφαρμοστεί ακόμη στο αρχείο της. */
+typedef struct {
+    int file_id;
+    int block_num;
+    off_t offset;
+} BF_Redo;
+
+typedef struct {
+    int partition;
+    int frame;
+} BF_Changed;
+
+/*
+ * Τα lsn μετράνε bytes του ημερολογίου από την BF_OpenLog και χρησιμεύουν
+ * μόνο μέσα στην εκτέλεση: lsn είναι το τέλος όσων έχουν προστεθεί,
+ * written_lsn όσων έχουν γραφτεί στο αρχείο και durable_lsn όσων έχουν
+ * γίνει μόνιμα. Το byte lsn βρίσκεται στην θέση lsn - lsn_base + phys_base
+ * του αρχείου.
+ */
+typedef struct {
+    bool active;
+    int fd;
+    char *path;
+    BF_LogConfig config;
+    pthread_mutex_t lock;
+    pthread_cond_t synced;
+    pthread_mutex_t commit_lock;
+    pthread_mutex_t checkpoint_lock;
+
+    char *buffer;
+    size_t buffered;
+    uint64_t lsn;
+    uint64_t written_lsn;
+    _Atomic uint64_t durable_lsn;
+    uint64_t lsn_base;
+    off_t phys_base;
+    off_t file_end;
+    bool syncing;
+    int pending_commits;
+    int next_file_id;
+
+    BF_Changed *changed;
+    BF_Changed *changed_spare;
+    int changed_count;
+
+    char **redo_paths;
+    int redo_path_count;
+    BF_Redo *redo;
+    int redo_count;
+
+    BF_LogStats stats;
+} BF_Log;
+
+/* Block της BF_GetBlocks που δεν ήταν στην μνήμη και περιμένει ανάγνωση. */
+typedef struct {
+    BF_Pool *pool;
+    int frame;
+    int block_num;
+} BF_Pending;
+
+static bool bf_active = false;
+static bool writer_running = false;
+static bool writer_stop = false;
+static pthread_t writer_thread;
+static BF_WriterConfig writer_config;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static BF_Pool *pools = NULL;
+static int partitions = 0;
+static int bf_block_size = 0;
+static int bf_flags = 0;
+static BF_File *file_chunks[BF_FILE_CHUNKS];
+static int file_count = 0;
+static int free_files = BF_NONE;
+static pthread_mutex_t files_lock = PTHREAD_MUTEX_INITIALIZER;
+static int fd_open = 0;
+static int fd_limit = BF_MAX_OS_FILES;
+static int fd_head = BF_NONE;
+static int fd_tail = BF_NONE;
+static pthread_mutex_t fd_lock = PTHREAD_MUTEX_INITIALIZER;
+static BF_Stats policy_stats[LRU_K + 1];
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static BF_Log bf_log = {
+    .fd = BF_NONE,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .synced = PTHREAD_COND_INITIALIZER,
+    .commit_lock = PTHREAD_MUTEX_INITIALIZER,
+    .checkpoint_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Ο πίνακας αρχείων μεγαλώνει κατά BF_FILE_CHUNK αρχεία, που δεν
+ * μετακινούνται ποτέ, ώστε οι δείκτες σε BF_File να μένουν έγκυροι χωρίς
+ * κλείδωμα.
+ */
+#define file_at(file_desc) (&file_chunks[(file_desc) / BF_FILE_CHUNK][(file_desc) % BF_FILE_CHUNK])
+
+/*
+ * Οι μετρητές κρατιούνται ανά τμήμα και ενημερώνονται κάτω από το latch
+ * του, οπότε δεν χρειάζονται ατομικές πράξεις. Η BF_GetStats αθροίζει τα
+ * τμήματα. Στο BF_Close τα συνολικά κάθε τμήματος προστίθενται στα
+ * policy_stats της πολιτικής του.
+ */
+#define file_stats_of(pool, file_desc) \
+    (&(pool)->file_stats[(file_desc) / BF_FILE_CHUNK][(file_desc) % BF_FILE_CHUNK])
+
+#define BF_COUNT(pool, file_desc, field, n)               \
+    do {                                                  \
+        (pool)->total.field += (n);                       \
+        file_stats_of(pool, file_desc)->field += (n);     \
+    } while (0)
+
+/* ---------------------------------------------------------------------- */
+/* Διπλά συνδεδεμένες λίστες πάνω σε δείκτες πινάκων                        */
+/* ---------------------------------------------------------------------- */
+
+static void list_init(BF_List *list) {
+    list->head = BF_NONE;
+    list->tail = BF_NONE;
+    list->size = 0;
+}
+
+static void list_push_front(BF_List *list, BF_Link *link, int i) {
+    link[i].prev = BF_NONE;
+    link[i].next = list->head;
+    if (list->head != BF_NONE) {
+        link[list->head].prev = i;
+    } else {
+        list->tail = i;
+    }
+    list->head = i;
+    list->size++;
+}
+
+static void list_remove(BF_List *list, BF_Link *link, int i) {
+    if (link[i].prev != BF_NONE) {
+        link[link[i].prev].next = link[i].next;
+    } else {
+        list->head = link[i].next;
+    }
+    if (link[i].next != BF_NONE) {
+        link[link[i].next].prev = link[i].prev;
+    } else {
+        list->tail = link[i].prev;
+    }
+    link[i].prev = BF_NONE;
+    link[i].next = BF_NONE;
+    list->size--;
+}
+
+static void list_move_front(BF_List *list, BF_Link *link, int i) {
+    if (list->head == i) {
+        return;
+    }
+    list_remove(list, link, i);
+    list_push_front(list, link, i);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Κατακερματισμός (file_desc, block_num)                                  */
+/* ---------------------------------------------------------------------- */
+
+static unsigned int page_hash(int file_desc, int block_num) {
+    uint64_t key = ((uint64_t) (uint32_t) file_desc << 32) | (uint32_t) block_num;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (unsigned int) (key >> 32);
+}
+
+static unsigned int table_size(int entries) {
+    unsigned int size = 16;
+    while (size < (unsigned int) entries * 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/*
+ * Πίνακας σελίδων με ανοιχτή διευθυνσιοδότηση, στο στυλ του Swiss table.
+ * Οι θέσεις χωρίζονται σε ομάδες των BF_GROUP. Για κάθε θέση ένα byte
+ * ελέγχου κρατάει είτε BF_CTRL_EMPTY ή BF_CTRL_DELETED είτε 7 bit από τον
+ * κατακερματισμό του κλειδιού (tag). Μια αναζήτηση συγκρίνει με μία εντολή
+ * SSE2 τα 16 tags της ομάδας και ελέγχει κλειδιά μόνο στις θέσεις που
+ * ταιριάζουν. Σταματάει στην πρώτη ομάδα που έχει κενή θέση. Οι ομάδες
+ * εξετάζονται με τριγωνική σειρά, που για πλήθος ομάδων δύναμη του 2 τις
+ * περνάει όλες.
+ *
+ * Μια διαγραφή αφήνει τη θέση κενή αν η ομάδα της έχει ήδη κενή θέση.
+ * Τότε καμία αναζήτηση δεν έχει περάσει ποτέ από αυτή την ομάδα. Αλλιώς
+ * αφήνει ταφόπλακα (BF_CTRL_DELETED). Όταν εξαντληθούν οι θέσεις που
+ * επιτρέπονται (7/8 του πίνακα), ο πίνακας ξαναχτίζεται χωρίς ταφόπλακες.
+ * Το μέγεθός του δεν αλλάζει, γιατί περιέχει το πολύ frames σελίδες.
+ */
+
+#define BF_GROUP 16
+#define BF_CTRL_EMPTY ((uint8_t) 0x80)
+#define BF_CTRL_DELETED ((uint8_t) 0xFE)
+
+static uint64_t page_key(int file_desc, int block_num) {
+    return ((uint64_t) (uint32_t) file_desc << 32) | (uint32_t) block_num;
+}
+
+/*
+ * Ίδιος πολλαπλασιαστικός κατακερματισμός με την page_hash. Η ομάδα παίρνεται
+ * από τα χαμηλά bit του άνω μισού (τα υψηλά διαλέγουν τμήμα) και το tag από
+ * τα 7 bit ακριβώς κάτω από αυτό.
+ */
+static uint64_t key_hash(uint64_t key) {
+    return key * 0x9E3779B97F4A7C15ULL;
+}
+
+#define BF_TAG(h) ((uint8_t) (((h) >> 25) & 0x7F))
+#define BF_GROUP_OF(pool, h) ((unsigned int) ((h) >> 32) & (pool)->group_mask)
+
+static unsigned int group_match(const uint8_t *ctrl, uint8_t value) {
+#if defined(__SSE2__)
+    __m128i group = _mm_load_si128((const __m128i *) ctrl);
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) value)));
+#else
+    unsigned int mask = 0;
+    for (int k = 0; k < BF_GROUP; k++) {
+        if (ctrl[k] == value) {
+            mask |= 1u << k;
+        }
+    }
+    return mask;
+#endif
+}
+
+static int table_capacity(BF_Pool *pool) {
+    return (int) (pool->group_mask + 1) * BF_GROUP;
+}
+
+static int table_limit(BF_Pool *pool) {
+    return table_capacity(pool) / 8 * 7;
+}
+
+static void table_clear(BF_Pool *pool) {
+    memset(pool->ctrl, BF_CTRL_EMPTY, table_capacity(pool));
+    pool->growth_left = table_limit(pool);
+}
+
+static int frame_lookup(BF_Pool *pool, int file_desc, int block_num) {
+    uint64_t key = page_key(file_desc, block_num);
+    uint64_t h = key_hash(key);
+    uint8_t tag = BF_TAG(h);
+    unsigned int g = BF_GROUP_OF(pool, h);
+
+    for (unsigned int step = 1;; step++) {
+        const uint8_t *ctrl = pool->ctrl + (size_t) g * BF_GROUP;
+        for (unsigned int m = group_match(ctrl, tag); m != 0; m &= m - 1) {
+            BF_Slot *slot = &pool->slots[(size_t) g * BF_GROUP + __builtin_ctz(m)];
+            if (slot->key == key) {
+                return slot->frame;
+            }
+        }
+        if (group_match(ctrl, BF_CTRL_EMPTY) != 0) {
+            return BF_NONE;
+        }
+        g = (g + step) & pool->group_mask;
+    }
+}
+
+/* Βάζει στον πίνακα κλειδί που δεν υπάρχει ήδη, στην πρώτη ελεύθερη θέση. */
+static void table_place(BF_Pool *pool, uint64_t key, int frame) {
+    uint64_t h = key_hash(key);
+    unsigned int g = BF_GROUP_OF(pool, h);
+
+    for (unsigned int step = 1;; step++) {
+        uint8_t *ctrl = pool->ctrl + (size_t) g * BF_GROUP;
+        unsigned int m = group_match(ctrl, BF_CTRL_EMPTY) | group_match(ctrl, BF_CTRL_DELETED);
+        if (m != 0) {
+            int k = __builtin_ctz(m);
+            if (ctrl[k] == BF_CTRL_EMPTY) {
+                pool->growth_left--;
+            }
+            ctrl[k] = BF_TAG(h);
+            pool->slots[(size_t) g * BF_GROUP + k].key = key;
+            pool->slots[(size_t) g * BF_GROUP + k].frame = frame;
+            return;
+        }
+        g = (g + step) & pool->group_mask;
+    }
+}
+
+static void frame_hash_insert(BF_Pool *pool, int i) {
+    if (pool->growth_left == 0) {
+        table_clear(pool);
+        for (int f = 0; f < pool->frames; f++) {
+            if (f != i && pool->frame[f].file_desc != BF_NONE) {
+                table_place(pool, page_key(pool->frame[f].file_desc, pool->frame[f].block_num), f);
+            }
+        }
+    }
+    table_place(pool, page_key(pool->frame[i].file_desc, pool->frame[i].block_num), i);
+}
+
+static void frame_hash_remove(BF_Pool *pool, int i) {
+    uint64_t key = page_key(pool->frame[i].file_desc, pool->frame[i].block_num);
+    uint64_t h = key_hash(key);
+    uint8_t tag = BF_TAG(h);
+    unsigned int g = BF_GROUP_OF(pool, h);
+
+    for (unsigned int step = 1;; step++) {
+        uint8_t *ctrl = pool->ctrl + (size_t) g * BF_GROUP;
+        for (unsigned int m = group_match(ctrl, tag); m != 0; m &= m - 1) {
+            int k = __builtin_ctz(m);
+            if (pool->slots[(size_t) g * BF_GROUP + k].key == key) {
+                if (group_match(ctrl, BF_CTRL_EMPTY) != 0) {
+                    ctrl[k] = BF_CTRL_EMPTY;
+                    pool->growth_left++;
+                } else {
+                    ctrl[k] = BF_CTRL_DELETED;
+                }
+                return;
+            }
+        }
+        g = (g + step) & pool->group_mask;
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Εγγραφές φαντάσματα                                                    */
+/* ---------------------------------------------------------------------- */
+
+static int ghost_lookup(BF_Pool *pool, int file_desc, int block_num) {
+    if (pool->ghost_capacity == 0) {
+        return BF_NONE;
+    }
+    int i = pool->ghost_buckets[page_hash(file_desc, block_num) & pool->ghost_mask];
+    while (i != BF_NONE) {
+        if (pool->ghost[i].file_desc == file_desc && pool->ghost[i].block_num == block_num) {
+            return i;
+        }
+        i = pool->ghost[i].hash_next;
+    }
+    return BF_NONE;
+}
+
+static void ghost_remove(BF_Pool *pool, int i) {
+    BF_Ghost *g = &pool->ghost[i];
+    unsigned int b = page_hash(g->file_desc, g->block_num) & pool->ghost_mask;
+    int *p = &pool->ghost_buckets[b];
+    while (*p != i) {
+        p = &pool->ghost[*p].hash_next;
+    }
+    *p = g->hash_next;
+    list_remove(&pool->ghost_lists[g->list], pool->ghost_link, i);
+    g->list = BF_LIST_FREE;
+    list_push_front(&pool->ghost_free, pool->ghost_link, i);
+}
+
+static void ghost_insert(BF_Pool *pool, int list, const BF_Frame *frame) {
+    if (pool->ghost_capacity == 0) {
+        return;
+    }
+    if (pool->ghost_free.size == 0) {
+        int victim_list = pool->ghost_lists[0].size >= pool->ghost_lists[1].size ? 0 : 1;
+        ghost_remove(pool, pool->ghost_lists[victim_list].tail);
+    }
+    int i = pool->ghost_free.head;
+    list_remove(&pool->ghost_free, pool->ghost_link, i);
+
+    BF_Ghost *g = &pool->ghost[i];
+    g->file_desc = frame->file_desc;
+    g->block_num = frame->block_num;
+    g->list = list;
+    memcpy(g->history, frame->history, sizeof (g->history));
+
+    unsigned int b = page_hash(g->file_desc, g->block_num) & pool->ghost_mask;
+    g->hash_next = pool->ghost_buckets[b];
+    pool->ghost_buckets[b] = i;
+    list_push_front(&pool->ghost_lists[list], pool->ghost_link, i);
+}
+
+static void ghost_drop_lru(BF_Pool *pool, int list) {
+    if (pool->ghost_lists[list].tail != BF_NONE) {
+        ghost_remove(pool, pool->ghost_lists[list].tail);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* LRU-K: σωρός ελαχίστων με κλειδί την K-οστή πιο πρόσφατη αναφορά        */
+/* ---------------------------------------------------------------------- */
+
+static bool lruk_less(BF_Pool *pool, int a, int b) {
+    const unsigned long *ha = pool->frame[a].history;
+    const unsigned long *hb = pool->frame[b].history;
+    if (ha[BF_LRU_K_DEPTH - 1] != hb[BF_LRU_K_DEPTH - 1]) {
+        return ha[BF_LRU_K_DEPTH - 1] < hb[BF_LRU_K_DEPTH - 1];
+    }
+    return ha[0] < hb[0];
+}
+
+static void heap_swap(BF_Pool *pool, int x, int y) {
+    int a = pool->heap[x];
+    int b = pool->heap[y];
+    pool->heap[x] = b;
+    pool->heap[y] = a;
+    pool->frame[b].heap_pos = x;
+    pool->frame[a].heap_pos = y;
+}
+
+static void heap_sift_up(BF_Pool *pool, int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!lruk_less(pool, pool->heap[pos], pool->heap[parent])) {
+            break;
+        }
+        heap_swap(pool, pos, parent);
+        pos = parent;
+    }
+}
+
+static void heap_sift_down(BF_Pool *pool, int pos) {
+    while (1) {
+        int smallest = pos;
+        int l = 2 * pos + 1;
+        int r = l + 1;
+        if (l < pool->heap_size && lruk_less(pool, pool->heap[l], pool->heap[smallest])) {
+            smallest = l;
+        }
+        if (r < pool->heap_size && lruk_less(pool, pool->heap[r], pool->heap[smallest])) {
+            smallest = r;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        heap_swap(pool, pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void heap_push(BF_Pool *pool, int i) {
+    pool->heap[pool->heap_size] = i;
+    pool->frame[i].heap_pos = pool->heap_size;
+    pool->heap_size++;
+    heap_sift_up(pool, pool->heap_size - 1);
+}
+
+static void heap_remove(BF_Pool *pool, int i) {
+    int pos = pool->frame[i].heap_pos;
+    pool->heap_size--;
+    if (pos != pool->heap_size) {
+        heap_swap(pool, pos, pool->heap_size);
+        heap_sift_down(pool, pos);
+        heap_sift_up(pool, pos);
+    }
+    pool->frame[i].heap_pos = BF_NONE;
+}
+
+/*
+ * Με ενεργό ημερολόγιο, η εικόνα ενός dirty πλαισίου που δεν έχει γίνει
+ * ακόμη μόνιμη απαιτεί fdatasync του ημερολογίου πριν γραφτεί το πλαίσιο.
+ */
+static bool log_pending(BF_Pool *pool, int i) {
+    return bf_log.active && atomic_load(&pool->frame[i].dirty) && pool->frame[i].lsn > bf_log.durable_lsn;
+}
+
+/*
+ * Θύμα μπορεί να γίνει ένα πλαίσιο που δεν είναι καρφιτσωμένο και δεν έχει
+ * αλλάξει μετά την τελευταία BF_Commit. Με durable αποκλείονται και όσα
+ * θα χρειάζονταν fdatasync του ημερολογίου κάτω από το latch.
+ */
+static bool frame_evictable(BF_Pool *pool, int i, bool durable) {
+    if (atomic_load(&pool->frame[i].pin_count) > 0 || atomic_load(&pool->frame[i].changed)) {
+        return false;
+    }
+    return !durable || !log_pending(pool, i);
+}
+
+/*
+ * Το μικρότερο υποψήφιο στοιχείο του σωρού έχει μόνο μη υποψήφιους
+ * προγόνους, οπότε αρκεί να επεκτείνουμε μόνο τους μη υποψήφιους κόμβους.
+ */
+static int heap_min_unpinned(BF_Pool *pool, int pos, bool durable) {
+    if (pos >= pool->heap_size) {
+        return BF_NONE;
+    }
+    int i = pool->heap[pos];
+    if (frame_evictable(pool, i, durable)) {
+        return i;
+    }
+    int l = heap_min_unpinned(pool, 2 * pos + 1, durable);
+    int r = heap_min_unpinned(pool, 2 * pos + 2, durable);
+    if (l == BF_NONE) {
+        return r;
+    }
+    if (r == BF_NONE) {
+        return l;
+    }
+    return lruk_less(pool, l, r) ? l : r;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Πολιτικές αντικατάστασης                                                */
+/* ---------------------------------------------------------------------- */
+
+static void touch_history(BF_Pool *pool, unsigned long *history) {
+    memmove(history + 1, history, sizeof (unsigned long) * (BF_LRU_K_DEPTH - 1));
+    history[0] = ++pool->tick;
+}
+
+static int list_victim(BF_Pool *pool, int list, bool from_tail, bool durable) {
+    int i = from_tail ? pool->lists[list].tail : pool->lists[list].head;
+    while (i != BF_NONE && !frame_evictable(pool, i, durable)) {
+        i = from_tail ? pool->link[i].prev : pool->link[i].next;
+    }
+    return i;
+}
+
+/*
+ * Καλείται σε κάθε αστοχία πριν την επιλογή θύματος ώστε να ληφθούν υπόψη
+ * οι εγγραφές φαντάσματα του block που ζητήθηκε.
+ */
+static BF_Admission policy_admit(BF_Pool *pool, int file_desc, int block_num) {
+    BF_Admission admission = {0};
+    admission.target_list = BF_LIST_FIRST;
+
+    int g = ghost_lookup(pool, file_desc, block_num);
+    if (g != BF_NONE) {
+        admission.from_ghost = true;
+        admission.ghost_list = pool->ghost[g].list;
+        memcpy(admission.history, pool->ghost[g].history, sizeof (admission.history));
+    }
+
+    switch (pool->policy) {
+        case TWO_Q:
+            if (g != BF_NONE) {
+                admission.target_list = BF_LIST_SECOND;
+                ghost_remove(pool, g);
+            }
+            break;
+        case ARC: {
+            int b1 = pool->ghost_lists[0].size;
+            int b2 = pool->ghost_lists[1].size;
+            int c = pool->frames;
+            if (g != BF_NONE) {
+                if (admission.ghost_list == 0) {
+                    int delta = b2 > b1 ? b2 / b1 : 1;
+                    pool->arc_p = pool->arc_p + delta > c ? c : pool->arc_p + delta;
+                } else {
+                    int delta = b1 > b2 ? b1 / b2 : 1;
+                    pool->arc_p = pool->arc_p - delta < 0 ? 0 : pool->arc_p - delta;
+                }
+                admission.target_list = BF_LIST_SECOND;
+                ghost_remove(pool, g);
+            } else {
+                int t1 = pool->lists[0].size;
+                int t2 = pool->lists[1].size;
+                if (t1 + b1 >= c) {
+                    if (t1 < c) {
+                        ghost_drop_lru(pool, 0);
+                    }
+                } else if (t1 + t2 + b1 + b2 >= 2 * c) {
+                    ghost_drop_lru(pool, 1);
+                }
+            }
+            break;
+        }
+        case LRU_K:
+            if (g != BF_NONE) {
+                ghost_remove(pool, g);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return admission;
+}
+
+static int policy_victim(BF_Pool *pool, const BF_Admission *admission, bool durable) {
+    switch (pool->policy) {
+        case LRU:
+            return list_victim(pool, BF_LIST_FIRST, true, durable);
+        case MRU:
+            return list_victim(pool, BF_LIST_FIRST, false, durable);
+        case CLOCK:
+            for (int step = 0; step < 2 * pool->frames; step++) {
+                int i = pool->clock_hand;
+                pool->clock_hand = (pool->clock_hand + 1) % pool->frames;
+                if (!frame_evictable(pool, i, durable)) {
+                    continue;
+                }
+                if (pool->frame[i].referenced) {
+                    pool->frame[i].referenced = false;
+                    continue;
+                }
+                return i;
+            }
+            return BF_NONE;
+        case TWO_Q: {
+            int first = pool->lists[BF_LIST_FIRST].size > pool->twoq_kin ? BF_LIST_FIRST : BF_LIST_SECOND;
+            int i = list_victim(pool, first, true, durable);
+            if (i == BF_NONE) {
+                i = list_victim(pool, 1 - first, true, durable);
+            }
+            return i;
+        }
+        case ARC: {
+            int t1 = pool->lists[0].size;
+            bool from_b2 = admission->from_ghost && admission->ghost_list == 1;
+            int first = (t1 > 0 && (t1 > pool->arc_p || (from_b2 && t1 == pool->arc_p))) ? 0 : 1;
+            int i = list_victim(pool, first, true, durable);
+            if (i == BF_NONE) {
+                i = list_victim(pool, 1 - first, true, durable);
+            }
+            return i;
+        }
+        case LRU_K:
+            return heap_min_unpinned(pool, 0, durable);
+    }
+    return BF_NONE;
+}
+
+static void policy_insert(BF_Pool *pool, int i, const BF_Admission *admission) {
+    BF_Frame *frame = &pool->frame[i];
+    frame->list = admission->target_list;
+
+    switch (pool->policy) {
+        case LRU:
+        case MRU:
+        case TWO_Q:
+        case ARC:
+            list_push_front(&pool->lists[frame->list], pool->link, i);
+            break;
+        case CLOCK:
+            frame->referenced = true;
+            break;
+        case LRU_K:
+            if (admission->from_ghost) {
+                memcpy(frame->history, admission->history, sizeof (frame->history));
+            } else {
+                memset(frame->history, 0, sizeof (frame->history));
+            }
+            touch_history(pool, frame->history);
+            heap_push(pool, i);
+            break;
+    }
+}
+
+static void policy_hit(BF_Pool *pool, int i) {
+    BF_Frame *frame = &pool->frame[i];
+
+    switch (pool->policy) {
+        case LRU:
+        case MRU:
+            list_move_front(&pool->lists[frame->list], pool->link, i);
+            break;
+        case CLOCK:
+            frame->referenced = true;
+            break;
+        case TWO_Q:
+            if (frame->list == BF_LIST_SECOND) {
+                list_move_front(&pool->lists[frame->list], pool->link, i);
+            }
+            break;
+        case ARC:
+            list_remove(&pool->lists[frame->list], pool->link, i);
+            frame->list = BF_LIST_SECOND;
+            list_push_front(&pool->lists[frame->list], pool->link, i);
+            break;
+        case LRU_K:
+            touch_history(pool, frame->history);
+            heap_sift_down(pool, frame->heap_pos);
+            break;
+    }
+}
+
+/*
+ * Αφαιρεί το πλαίσιο από τις δομές της πολιτικής. Όταν remember είναι
+ * αληθές, το block καταγράφεται ως φάντασμα (πραγματική απομάκρυνση και
+ * όχι κλείσιμο αρχείου).
+ */
+static void policy_remove(BF_Pool *pool, int i, bool remember) {
+    BF_Frame *frame = &pool->frame[i];
+
+    switch (pool->policy) {
+        case LRU:
+        case MRU:
+            list_remove(&pool->lists[frame->list], pool->link, i);
+            break;
+        case CLOCK:
+            frame->referenced = false;
+            break;
+        case TWO_Q:
+            list_remove(&pool->lists[frame->list], pool->link, i);
+            if (remember && frame->list == BF_LIST_FIRST) {
+                ghost_insert(pool, 0, frame);
+            }
+            break;
+        case ARC:
+            list_remove(&pool->lists[frame->list], pool->link, i);
+            if (remember) {
+                ghost_insert(pool, frame->list, frame);
+            }
+            break;
+        case LRU_K:
+            heap_remove(pool, i);
+            if (remember) {
+                ghost_insert(pool, 0, frame);
+            }
+            break;
+    }
+    frame->list = BF_LIST_FREE;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Ενδιάμεση μνήμη                                                         */
+/* ---------------------------------------------------------------------- */
+
+static bool valid_file(int file_desc) {
+    return bf_active && file_desc >= 0 && file_desc < BF_MAX_OPEN_FILES
+            && file_chunks[file_desc / BF_FILE_CHUNK] != NULL && file_at(file_desc)->used;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Descriptors του λειτουργικού                                            */
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Τα αρχεία με ανοικτό descriptor βρίσκονται σε μια λίστα LRU. Όταν είναι
+ * ανοικτά περισσότερα από fd_limit, κλείνουν τα λιγότερο πρόσφατα
+ * χρησιμοποιημένα που δεν κάνουν εκείνη τη στιγμή I/O. Κάθε I/O παίρνει
+ * τον descriptor με την fd_acquire, που τον ξανανοίγει αν χρειάζεται, και
+ * τον αφήνει με την fd_release.
+ */
+static void fd_unlink(int file_desc) {
+    BF_File *file = file_at(file_desc);
+    if (file->fd_prev != BF_NONE) {
+        file_at(file->fd_prev)->fd_next = file->fd_next;
+    } else {
+        fd_head = file->fd_next;
+    }
+    if (file->fd_next != BF_NONE) {
+        file_at(file->fd_next)->fd_prev = file->fd_prev;
+    } else {
+        fd_tail = file->fd_prev;
+    }
+    file->fd_prev = BF_NONE;
+    file->fd_next = BF_NONE;
+}
+
+static void fd_push(int file_desc) {
+    BF_File *file = file_at(file_desc);
+    file->fd_prev = BF_NONE;
+    file->fd_next = fd_head;
+    if (fd_head != BF_NONE) {
+        file_at(fd_head)->fd_prev = file_desc;
+    } else {
+        fd_tail = file_desc;
+    }
+    fd_head = file_desc;
+}
+
+static void fd_trim() {
+    for (int f = fd_tail; f != BF_NONE && fd_open > fd_limit;) {
+        BF_File *file = file_at(f);
+        int prev = file->fd_prev;
+        if (file->fd_users == 0) {
+            fd_unlink(f);
+            close(file->fd);
+            file->fd = BF_NONE;
+            fd_open--;
+        }
+        f = prev;
+    }
+}
+
+/*
+ * Ανοίγει αρχείο με το fd_lock. Αν το λειτουργικό δεν δίνει άλλους
+ * descriptors (EMFILE), κλείνει αδρανείς ακόμη και κάτω από το fd_limit.
+ */
+static bool fd_evict_idle() {
+    for (int f = fd_tail; f != BF_NONE; f = file_at(f)->fd_prev) {
+        BF_File *file = file_at(f);
+        if (file->fd_users == 0) {
+            fd_unlink(f);
+            close(file->fd);
+            file->fd = BF_NONE;
+            fd_open--;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int fd_open_path(const char *path, int flags) {
+    int fd = open(path, flags);
+    while (fd < 0 && (errno == EMFILE || errno == ENFILE) && fd_evict_idle()) {
+        fd = open(path, flags);
+    }
+    return fd;
+}
+
+static void fd_register(int file_desc, int fd) {
+    pthread_mutex_lock(&fd_lock);
+    file_at(file_desc)->fd = fd;
+    file_at(file_desc)->fd_users = 0;
+    fd_open++;
+    fd_push(file_desc);
+    fd_trim();
+    pthread_mutex_unlock(&fd_lock);
+}
+
+static int fd_acquire(int file_desc) {
+    BF_File *file = file_at(file_desc);
+
+    pthread_mutex_lock(&fd_lock);
+    if (file->fd == BF_NONE) {
+        int fd = fd_open_path(file->path, O_RDWR | (atomic_load(&file->direct) ? O_DIRECT : 0));
+        if (fd < 0) {
+            pthread_mutex_unlock(&fd_lock);
+            return BF_NONE;
+        }
+        file->fd = fd;
+        fd_open++;
+        fd_push(file_desc);
+    } else if (fd_head != file_desc) {
+        fd_unlink(file_desc);
+        fd_push(file_desc);
+    }
+    file->fd_users++;
+    fd_trim();
+    int fd = file->fd;
+    pthread_mutex_unlock(&fd_lock);
+    return fd;
+}
+
+static void fd_release(int file_desc) {
+    pthread_mutex_lock(&fd_lock);
+    file_at(file_desc)->fd_users--;
+    fd_trim();
+    pthread_mutex_unlock(&fd_lock);
+}
+
+static int fd_close(int file_desc) {
+    BF_File *file = file_at(file_desc);
+    int result = 0;
+
+    pthread_mutex_lock(&fd_lock);
+    if (file->fd != BF_NONE) {
+        fd_unlink(file_desc);
+        result = close(file->fd);
+        file->fd = BF_NONE;
+        fd_open--;
+    }
+    pthread_mutex_unlock(&fd_lock);
+    return result;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Πίνακας αρχείων                                                         */
+/* ---------------------------------------------------------------------- */
+
+static BF_ErrorCode file_chunk_alloc(int chunk) {
+    BF_File *chunk_files = calloc(BF_FILE_CHUNK, sizeof (BF_File));
+    if (chunk_files == NULL) {
+        return BF_ERROR;
+    }
+
+    for (int p = 0; p < partitions; p++) {
+        BF_Stats *stats = calloc(BF_FILE_CHUNK, sizeof (BF_Stats));
+        if (stats == NULL) {
+            for (int q = 0; q < p; q++) {
+                pthread_mutex_lock(&pools[q].latch);
+                free(pools[q].file_stats[chunk]);
+                pools[q].file_stats[chunk] = NULL;
+                pthread_mutex_unlock(&pools[q].latch);
+            }
+            free(chunk_files);
+            return BF_ERROR;
+        }
+        pthread_mutex_lock(&pools[p].latch);
+        pools[p].file_stats[chunk] = stats;
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+
+    for (int f = 0; f < BF_FILE_CHUNK; f++) {
+        BF_File *file = &chunk_files[f];
+        file->fd = BF_NONE;
+        file->fd_prev = BF_NONE;
+        file->fd_next = BF_NONE;
+        file->next_free = BF_NONE;
+        atomic_init(&file->blocks, 0);
+        pthread_mutex_init(&file->alloc_lock, NULL);
+        pthread_mutex_init(&file->ra_lock, NULL);
+    }
+    file_chunks[chunk] = chunk_files;
+    return BF_OK;
+}
+
+/* Βρίσκει ελεύθερη θέση σε O(1). Καλείται με το files_lock. */
+static int file_slot() {
+    if (free_files != BF_NONE) {
+        int slot = free_files;
+        free_files = file_at(slot)->next_free;
+        return slot;
+    }
+    if (file_count == BF_MAX_OPEN_FILES) {
+        return BF_NONE;
+    }
+    if (file_chunks[file_count / BF_FILE_CHUNK] == NULL && file_chunk_alloc(file_count / BF_FILE_CHUNK) != BF_OK) {
+        return BF_NONE;
+    }
+    return file_count++;
+}
+
+static void file_free_slot(int file_desc) {
+    BF_File *file = file_at(file_desc);
+    free(file->path);
+    file->path = NULL;
+    file->used = false;
+    file->next_free = free_files;
+    free_files = file_desc;
+}
+
+/*
+ * Το πλήθος των dirty πλαισίων κάθε τμήματος κρατιέται για τον writer και
+ * αλλάζει μόνο όταν αλλάζει πραγματικά η κατάσταση του πλαισίου.
+ */
+static void mark_dirty(BF_Pool *pool, int i) {
+    if (!atomic_exchange(&pool->frame[i].dirty, true)) {
+        atomic_fetch_add(&pool->dirty_frames, 1);
+    }
+}
+
+static void mark_clean(BF_Pool *pool, int i) {
+    if (atomic_exchange(&pool->frame[i].dirty, false)) {
+        atomic_fetch_sub(&pool->dirty_frames, 1);
+    }
+}
+
+static void stats_add(BF_Stats *sum, const BF_Stats *stats) {
+    sum->requests += stats->requests;
+    sum->hits += stats->hits;
+    sum->misses += stats->misses;
+    sum->dirty_evictions += stats->dirty_evictions;
+    sum->clean_evictions += stats->clean_evictions;
+    sum->reads += stats->reads;
+    sum->writes += stats->writes;
+    sum->bytes_read += stats->bytes_read;
+    sum->bytes_written += stats->bytes_written;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Ημερολόγιο επανάληψης (WAL)                                             */
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Το ημερολόγιο κρατάει ολόκληρες εικόνες σελίδων. Η BF_Commit γράφει τις
+ * εικόνες των σελίδων που άλλαξαν και μετά μια εγγραφή BF_LOG_COMMIT. Μια
+ * σελίδα που άλλαξε μετά την τελευταία BF_Commit δεν απομακρύνεται και δεν
+ * γράφεται στο αρχείο της (no-steal), και καμία σελίδα δεν γράφεται στο
+ * αρχείο πριν γίνει μόνιμη η εικόνα της. Το ημερολόγιο είναι μόνο
+ * επανάληψης, οπότε η ανάκτηση ξαναγράφει με την σειρά τους τις εικόνες
+ * έως την τελευταία BF_LOG_COMMIT και αγνοεί όσες ακολουθούν: τα αρχεία
+ * καταλήγουν στην κατάσταση της τελευταίας ολοκληρωμένης BF_Commit.
+ */
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const void *data, size_t length) {
+    const unsigned char *p = data;
+    for (size_t k = 0; k < length; k++) {
+        crc = crc_table[(crc ^ p[k]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t log_crc(const BF_LogRecord *record, const void *payload) {
+    BF_LogRecord header = *record;
+    header.crc = 0;
+    uint32_t crc = crc_update(0xFFFFFFFFu, &header, sizeof (header));
+    return crc_update(crc, payload, record->length) ^ 0xFFFFFFFFu;
+}
+
+/* Οι συναρτήσεις log_* καλούνται με το bf_log.lock, εκτός αν λέει αλλιώς. */
+static BF_ErrorCode log_write_buffer() {
+    size_t done = 0;
+    while (done < bf_log.buffered) {
+        ssize_t n = pwrite(bf_log.fd, bf_log.buffer + done, bf_log.buffered - done, bf_log.file_end + (off_t) done);
+        if (n <= 0) {
+            return BF_ERROR;
+        }
+        done += (size_t) n;
+    }
+    bf_log.file_end += (off_t) bf_log.buffered;
+    bf_log.written_lsn = bf_log.lsn;
+    bf_log.buffered = 0;
+    return BF_OK;
+}
+
+static BF_ErrorCode log_append(uint32_t type, int file_id, int block_num, const void *payload, uint32_t length) {
+    BF_LogRecord record = {BF_LOG_MAGIC, type, length, (uint32_t) file_id, block_num, 0};
+    size_t size = sizeof (record) + length;
+
+    if (bf_log.buffered + size > BF_LOG_BUFFER && log_write_buffer() != BF_OK) {
+        return BF_ERROR;
+    }
+    record.crc = log_crc(&record, payload);
+    memcpy(bf_log.buffer + bf_log.buffered, &record, sizeof (record));
+    memcpy(bf_log.buffer + bf_log.buffered + sizeof (record), payload, length);
+    bf_log.buffered += size;
+    bf_log.lsn += size;
+    bf_log.stats.bytes_logged += size;
+    return BF_OK;
+}
+
+static int log_file_id(int file_desc) {
+    BF_File *file = file_at(file_desc);
+    if (file->log_id == BF_NONE) {
+        int id = bf_log.next_file_id;
+        if (log_append(BF_LOG_FILE, id, BF_NONE, file->path, (uint32_t) strlen(file->path) + 1) != BF_OK) {
+            return BF_NONE;
+        }
+        bf_log.next_file_id++;
+        file->log_id = id;
+    }
+    return file->log_id;
+}
+
+/*
+ * Σημειώνει ότι το πλαίσιο άλλαξε από την τελευταία εικόνα του. Κάθε
+ * πλαίσιο μπαίνει το πολύ μία φορά στην λίστα changed της επόμενης
+ * BF_Commit. Καλείται χωρίς κλείδωμα, με το block καρφιτσωμένο.
+ */
+static void log_note(BF_Pool *pool, int i) {
+    if (!bf_log.active || file_at(pool->frame[i].file_desc)->mode != BF_FILE_POOL) {
+        return;
+    }
+    atomic_store(&pool->frame[i].unlogged, true);
+    if (!atomic_exchange(&pool->frame[i].changed, true)) {
+        pthread_mutex_lock(&bf_log.lock);
+        bf_log.changed[bf_log.changed_count].partition = (int) (pool - pools);
+        bf_log.changed[bf_log.changed_count].frame = i;
+        bf_log.changed_count++;
+        pthread_mutex_unlock(&bf_log.lock);
+    }
+}
+
+/* Γράφει την εικόνα του πλαισίου στο ημερολόγιο. Καλείται με το latch. */
+static BF_ErrorCode log_frame(BF_Pool *pool, int i) {
+    BF_Frame *frame = &pool->frame[i];
+    if (!atomic_exchange(&frame->unlogged, false)) {
+        return BF_OK;
+    }
+
+    pthread_mutex_lock(&bf_log.lock);
+    int id = log_file_id(frame->file_desc);
+    BF_ErrorCode code = id == BF_NONE ? BF_ERROR
+            : log_append(BF_LOG_PAGE, id, frame->block_num, frame->data, (uint32_t) pool->block_size);
+    if (code == BF_OK) {
+        frame->lsn = bf_log.lsn;
+        bf_log.stats.pages_logged++;
+    } else {
+        atomic_store(&frame->unlogged, true);
+    }
+    pthread_mutex_unlock(&bf_log.lock);
+    return code;
+}
+
+/*
+ * Group commit: όποιος βρει το ημερολόγιο ελεύθερο γράφει ό,τι έχει
+ * μαζευτεί και κάνει fdatasync χωρίς το lock, ενώ οι υπόλοιποι προσθέτουν
+ * εγγραφές και περιμένουν. Μόλις τελειώσει, ο επόμενος που δεν καλύφθηκε
+ * κάνει ένα fdatasync για όλους όσους μαζεύτηκαν στο μεταξύ. Καλείται
+ * χωρίς το bf_log.lock.
+ */
+static BF_ErrorCode log_sync(uint64_t target) {
+    BF_ErrorCode code = BF_OK;
+
+    pthread_mutex_lock(&bf_log.lock);
+    while (bf_log.durable_lsn < target && code == BF_OK) {
+        if (bf_log.syncing) {
+            pthread_cond_wait(&bf_log.synced, &bf_log.lock);
+            continue;
+        }
+        if (bf_log.buffered > 0 && log_write_buffer() != BF_OK) {
+            code = BF_ERROR;
+            break;
+        }
+
+        uint64_t upto = bf_log.written_lsn;
+        bf_log.syncing = true;
+        pthread_mutex_unlock(&bf_log.lock);
+        int rc = fdatasync(bf_log.fd);
+        pthread_mutex_lock(&bf_log.lock);
+        bf_log.syncing = false;
+        if (rc != 0) {
+            code = BF_ERROR;
+        } else {
+            bf_log.durable_lsn = upto > bf_log.durable_lsn ? upto : bf_log.durable_lsn;
+            bf_log.stats.syncs++;
+        }
+        pthread_cond_broadcast(&bf_log.synced);
+    }
+    pthread_mutex_unlock(&bf_log.lock);
+    return code;
+}
+
+/*
+ * Κανόνας WAL: πριν γραφτεί ένα πλαίσιο στο αρχείο του, η εικόνα του πρέπει
+ * να είναι μόνιμη στο ημερολόγιο. Καλείται με το latch του τμήματος, οπότε
+ * οι καλούντες κάνουν πρώτα log_sync χωρίς latch ή προτιμούν πλαίσια που
+ * δεν το χρειάζονται (log_pending).
+ */
+static BF_ErrorCode log_before_write(BF_Pool *pool, int i) {
+    BF_Frame *frame = &pool->frame[i];
+    if (!bf_log.active) {
+        return BF_OK;
+    }
+    if (log_frame(pool, i) != BF_OK) {
+        return BF_ERROR;
+    }
+    atomic_store(&file_at(frame->file_desc)->needs_sync, true);
+    return log_sync(frame->lsn);
+}
+
+/*
+ * Εφαρμόζει τις εικόνες του ημερολογίου που αφορούν το αρχείο path. Με
+ * fd < 0 το αρχείο ανοίγεται εδώ. Καλείται χωρίς το bf_log.lock, από ένα
+ * νήμα τη φορά (BF_OpenFile με το files_lock ή checkpoint).
+ */
+static BF_ErrorCode log_redo(const char *path, int fd) {
+    BF_ErrorCode code = BF_OK;
+    bool own = false;
+    char *page = NULL;
+    int applied = 0;
+
+    for (int r = 0; r < bf_log.redo_count && code == BF_OK; r++) {
+        BF_Redo *redo = &bf_log.redo[r];
+        if (redo->file_id == BF_NONE || strcmp(bf_log.redo_paths[redo->file_id], path) != 0) {
+            continue;
+        }
+        if (page == NULL && posix_memalign((void **) &page, BF_PAGE_ALIGN, bf_block_size) != 0) {
+            return BF_ERROR;
+        }
+        if (fd < 0) {
+            fd = open(path, O_RDWR);
+            own = true;
+            if (fd < 0) {
+                free(page);
+                return errno == ENOENT ? BF_OK : BF_ERROR;
+            }
+        }
+        off_t target = (off_t) redo->block_num * bf_block_size;
+        if (pread(bf_log.fd, page, bf_block_size, redo->offset) != bf_block_size
+                || pwrite(fd, page, bf_block_size, target) != bf_block_size) {
+            code = BF_ERROR;
+            break;
+        }
+        redo->file_id = BF_NONE;
+        applied++;
+    }
+
+    if (applied > 0 && code == BF_OK && fdatasync(fd) != 0) {
+        code = BF_ERROR;
+    }
+    if (own) {
+        close(fd);
+    }
+    free(page);
+    pthread_mutex_lock(&bf_log.lock);
+    bf_log.stats.pages_recovered += applied;
+    pthread_mutex_unlock(&bf_log.lock);
+    return code;
+}
+
+static void log_free_redo() {
+    for (int p = 0; p < bf_log.redo_path_count; p++) {
+        free(bf_log.redo_paths[p]);
+    }
+    free(bf_log.redo_paths);
+    free(bf_log.redo);
+    bf_log.redo_paths = NULL;
+    bf_log.redo_path_count = 0;
+    bf_log.redo = NULL;
+    bf_log.redo_count = 0;
+}
+
+/*
+ * Διαβάζει το ημερολόγιο μιας προηγούμενης εκτέλεσης έως την πρώτη
+ * εγγραφή που δεν είναι ακέραια και κρατάει σε μνήμη μόνο τις θέσεις των
+ * εικόνων έως την τελευταία BF_LOG_COMMIT. Οι εικόνες μετά από αυτήν
+ * ανήκουν σε BF_Commit που δεν ολοκληρώθηκε· αγνοούνται και αποκόπτονται
+ * μαζί με ό,τι ακολουθεί, ώστε να μην τις επικυρώσει η επόμενη BF_Commit.
+ */
+static BF_ErrorCode log_scan() {
+    BF_LogRecord record;
+    off_t offset = 0;
+    off_t committed_end = 0;
+    int committed = 0;
+    int redo_capacity = 0;
+    char *payload = malloc(BF_MAX_BLOCK_SIZE);
+    if (payload == NULL) {
+        return BF_ERROR;
+    }
+
+    BF_ErrorCode code = BF_OK;
+    while (pread(bf_log.fd, &record, sizeof (record), offset) == sizeof (record)) {
+        if (record.magic != BF_LOG_MAGIC || record.length == 0 || record.length > BF_MAX_BLOCK_SIZE) {
+            break;
+        }
+        if (pread(bf_log.fd, payload, record.length, offset + sizeof (record)) != (ssize_t) record.length
+                || log_crc(&record, payload) != record.crc) {
+            break;
+        }
+
+        if (record.type == BF_LOG_FILE) {
+            int id = (int) record.file_id;
+            if (id >= bf_log.redo_path_count) {
+                char **paths = realloc(bf_log.redo_paths, sizeof (char *) * (id + 1));
+                if (paths == NULL) {
+                    code = BF_ERROR;
+                    break;
+                }
+                for (int p = bf_log.redo_path_count; p <= id; p++) {
+                    paths[p] = NULL;
+                }
+                bf_log.redo_paths = paths;
+                bf_log.redo_path_count = id + 1;
+            }
+            payload[record.length - 1] = '\0';
+            free(bf_log.redo_paths[id]);
+            bf_log.redo_paths[id] = strdup(payload);
+        } else if (record.type == BF_LOG_PAGE) {
+            if ((int) record.length != bf_block_size) {
+                code = BF_ERROR;
+                break;
+            }
+            /* Αρχείο που έκλεισε πριν το checkpoint: οι σελίδες του είναι ήδη μόνιμες. */
+            if ((int) record.file_id >= bf_log.redo_path_count || bf_log.redo_paths[record.file_id] == NULL) {
+                offset += (off_t) sizeof (record) + record.length;
+                continue;
+            }
+            if (bf_log.redo_count == redo_capacity) {
+                redo_capacity = redo_capacity > 0 ? redo_capacity * 2 : 1024;
+                BF_Redo *redo = realloc(bf_log.redo, sizeof (BF_Redo) * redo_capacity);
+                if (redo == NULL) {
+                    code = BF_ERROR;
+                    break;
+                }
+                bf_log.redo = redo;
+            }
+            bf_log.redo[bf_log.redo_count].file_id = (int) record.file_id;
+            bf_log.redo[bf_log.redo_count].block_num = record.block_num;
+            bf_log.redo[bf_log.redo_count].offset = offset + (off_t) sizeof (record);
+            bf_log.redo_count++;
+        } else if (record.type == BF_LOG_COMMIT) {
+            committed = bf_log.redo_count;
+            committed_end = offset + (off_t) sizeof (record) + record.length;
+        }
+        offset += (off_t) sizeof (record) + record.length;
+    }
+    free(payload);
+
+    bf_log.redo_count = committed;
+    if (code != BF_OK || ftruncate(bf_log.fd, committed_end) != 0) {
+        log_free_redo();
+        return BF_ERROR;
+    }
+    bf_log.file_end = committed_end;
+    bf_log.phys_base = committed_end;
+    return BF_OK;
+}
+
+static BF_ErrorCode log_sync_dir() {
+    char *dir = strdup(bf_log.path);
+    if (dir == NULL) {
+        return BF_ERROR;
+    }
+    char *slash = strrchr(dir, '/');
+    if (slash == dir) {
+        slash[1] = '\0';
+    } else if (slash != NULL) {
+        *slash = '\0';
+    }
+    int fd = open(slash != NULL ? dir : ".", O_RDONLY | O_DIRECTORY);
+    free(dir);
+    if (fd < 0) {
+        return BF_ERROR;
+    }
+    int rc = fsync(fd);
+    close(fd);
+    return rc == 0 ? BF_OK : BF_ERROR;
+}
+
+/*
+ * Ξαναγράφει το ημερολόγιο κρατώντας μόνο τις εγγραφές από το lsn start και
+ * μετά, με τα ονόματα των ανοικτών αρχείων στην αρχή. Το νέο αρχείο γίνεται
+ * μόνιμο πριν αντικαταστήσει το παλιό με rename. Καλείται με το
+ * bf_log.lock, χωρίς fdatasync σε εξέλιξη.
+ */
+static BF_ErrorCode log_rewrite(uint64_t start) {
+    size_t length = strlen(bf_log.path) + 5;
+    char *tmp = malloc(length);
+    if (tmp == NULL) {
+        return BF_ERROR;
+    }
+    snprintf(tmp, length, "%s.tmp", bf_log.path);
+
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || log_write_buffer() != BF_OK) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(tmp);
+        return BF_ERROR;
+    }
+
+    /* Οι εγγραφές BF_LOG_FILE δεν έχουν lsn· γράφονται στο buffer και από εκεί στο νέο αρχείο. */
+    int old_fd = bf_log.fd;
+    off_t old_tail = (off_t) (start - bf_log.lsn_base) + bf_log.phys_base;
+    off_t old_end = bf_log.file_end;
+    uint64_t lsn = bf_log.lsn;
+    BF_ErrorCode code = BF_OK;
+
+    bf_log.fd = fd;
+    bf_log.file_end = 0;
+    for (int f = 0; f < file_count && code == BF_OK; f++) {
+        BF_File *file = file_at(f);
+        if (file->used && file->log_id != BF_NONE) {
+            code = log_append(BF_LOG_FILE, file->log_id, BF_NONE, file->path, (uint32_t) strlen(file->path) + 1);
+        }
+    }
+    if (code == BF_OK) {
+        code = log_write_buffer();
+    }
+    off_t phys_base = bf_log.file_end;
+
+    char *chunk = malloc(BF_LOG_BUFFER);
+    for (off_t at = old_tail; code == BF_OK && at < old_end;) {
+        size_t want = old_end - at < BF_LOG_BUFFER ? (size_t) (old_end - at) : BF_LOG_BUFFER;
+        ssize_t n = chunk == NULL ? -1 : pread(old_fd, chunk, want, at);
+        if (n <= 0 || pwrite(fd, chunk, n, bf_log.file_end) != n) {
+            code = BF_ERROR;
+            break;
+        }
+        at += n;
+        bf_log.file_end += n;
+    }
+    free(chunk);
+
+    if (code == BF_OK && (fdatasync(fd) != 0 || rename(tmp, bf_log.path) != 0 || log_sync_dir() != BF_OK)) {
+        code = BF_ERROR;
+    }
+    if (code != BF_OK) {
+        close(fd);
+        unlink(tmp);
+        bf_log.fd = old_fd;
+        bf_log.file_end = old_end;
+        bf_log.lsn = lsn;
+        bf_log.written_lsn = lsn;
+        free(tmp);
+        return code;
+    }
+
+    close(old_fd);
+    free(tmp);
+    bf_log.lsn = lsn;
+    bf_log.written_lsn = lsn;
+    bf_log.durable_lsn = lsn;
+    bf_log.lsn_base = start;
+    bf_log.phys_base = phys_base;
+    return BF_OK;
+}
+
+/*
+ * Με BF_DIRECT_IO ο πυρήνας μπορεί να απορρίψει μια λειτουργία με EINVAL,
+ * π.χ. όταν το block είναι μικρότερο από τον τομέα της συσκευής. Τότε το
+ * αρχείο γυρίζει μόνιμα σε κανονική I/O και η λειτουργία ξαναγίνεται.
+ */
+static bool direct_fallback(int file_desc, int fd) {
+    BF_File *file = file_at(file_desc);
+    if (errno != EINVAL || !atomic_load(&file->direct)) {
+        return false;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) != 0) {
+        return false;
+    }
+    atomic_store(&file->direct, false);
+    return true;
+}
+
+static BF_ErrorCode write_frame(BF_Pool *pool, int i) {
+    BF_Frame *frame = &pool->frame[i];
+    off_t offset = (off_t) frame->block_num * pool->block_size;
+    if (log_before_write(pool, i) != BF_OK) {
+        return BF_ERROR;
+    }
+    int fd = fd_acquire(frame->file_desc);
+    if (fd < 0) {
+        return BF_ERROR;
+    }
+    ssize_t n = pwrite(fd, frame->data, pool->block_size, offset);
+    if (n < 0 && direct_fallback(frame->file_desc, fd)) {
+        n = pwrite(fd, frame->data, pool->block_size, offset);
+    }
+    fd_release(frame->file_desc);
+    if (n != pool->block_size) {
+        return BF_ERROR;
+    }
+    BF_COUNT(pool, frame->file_desc, writes, 1);
+    BF_COUNT(pool, frame->file_desc, bytes_written, pool->block_size);
+    frame->lsn = 0;
+    mark_clean(pool, i);
+    return BF_OK;
+}
+
+static BF_ErrorCode read_frame(BF_Pool *pool, int i) {
+    BF_Frame *frame = &pool->frame[i];
+    off_t offset = (off_t) frame->block_num * pool->block_size;
+    int fd = fd_acquire(frame->file_desc);
+    if (fd < 0) {
+        return BF_ERROR;
+    }
+    ssize_t n = pread(fd, frame->data, pool->block_size, offset);
+    if (n < 0 && direct_fallback(frame->file_desc, fd)) {
+        n = pread(fd, frame->data, pool->block_size, offset);
+    }
+    fd_release(frame->file_desc);
+    if (n < 0) {
+        return BF_ERROR;
+    }
+    BF_COUNT(pool, frame->file_desc, reads, 1);
+    BF_COUNT(pool, frame->file_desc, bytes_read, n);
+    if (n < pool->block_size) {
+        memset(frame->data + n, 0, pool->block_size - n);
+    }
+    return BF_OK;
+}
+
+static void release_frame(BF_Pool *pool, int i) {
+    frame_hash_remove(pool, i);
+    mark_clean(pool, i);
+    pool->frame[i].file_desc = BF_NONE;
+    pool->frame[i].block_num = BF_NONE;
+    pool->frame[i].list = BF_LIST_FREE;
+    list_push_front(&pool->free_list, pool->link, i);
+}
+
+/*
+ * Βρίσκει πλαίσιο για νέο block: πρώτα από τα ελεύθερα, αλλιώς ζητάει
+ * θύμα από την πολιτική και το γράφει στον δίσκο αν είναι dirty. Προτιμάει
+ * θύμα που δεν χρειάζεται fdatasync του ημερολογίου, που θα γινόταν με το
+ * latch και θα καθυστερούσε κάθε πρόσβαση στο τμήμα.
+ */
+static BF_ErrorCode obtain_frame(BF_Pool *pool, int file_desc, int block_num, int *frame_out) {
+    BF_Admission admission = policy_admit(pool, file_desc, block_num);
+    int i;
+
+    if (pool->free_list.size > 0) {
+        i = pool->free_list.head;
+        list_remove(&pool->free_list, pool->link, i);
+    } else {
+        i = policy_victim(pool, &admission, true);
+        if (i == BF_NONE && bf_log.active) {
+            i = policy_victim(pool, &admission, false);
+        }
+        if (i == BF_NONE) {
+            return BF_FULL_MEMORY_ERROR;
+        }
+        if (pool->frame[i].dirty) {
+            BF_ErrorCode code = write_frame(pool, i);
+            if (code != BF_OK) {
+                return code;
+            }
+            BF_COUNT(pool, pool->frame[i].file_desc, dirty_evictions, 1);
+        } else {
+            BF_COUNT(pool, pool->frame[i].file_desc, clean_evictions, 1);
+        }
+        policy_remove(pool, i, true);
+        frame_hash_remove(pool, i);
+    }
+
+    BF_Frame *frame = &pool->frame[i];
+    frame->file_desc = file_desc;
+    frame->block_num = block_num;
+    atomic_store(&frame->pin_count, 0);
+    atomic_store(&frame->unlogged, false);
+    frame->lsn = 0;
+    mark_clean(pool, i);
+    frame_hash_insert(pool, i);
+    policy_insert(pool, i, &admission);
+
+    *frame_out = i;
+    return BF_OK;
+}
+
+/*
+ * Ένα BF_Block κρατάει το πολύ ένα pin, οπότε αν είναι ακόμη καρφιτσωμένο
+ * σε άλλο block ξεκαρφιτσώνεται πρώτα· αλλιώς το παλιό pin θα χανόταν. Οι
+ * καλούντες δεν το καλούν για το block που ήδη κρατάει.
+ */
+static void bind_block(BF_Pool *pool, BF_Block *block, int i) {
+    if (block->pinned) {
+        BF_UnpinBlock(block);
+    }
+    atomic_fetch_add(&pool->frame[i].pin_count, 1);
+    block->file_desc = pool->frame[i].file_desc;
+    block->block_num = pool->frame[i].block_num;
+    block->partition = (int) (pool - pools);
+    block->frame = i;
+    block->pinned = true;
+    block->mapped = false;
+    block->data = pool->frame[i].data;
+}
+
+/*
+ * Σειριακή προανάγνωση ανά αρχείο, όταν η BF_InitEx κλήθηκε με
+ * BF_READAHEAD. Καλείται χωρίς latch για κάθε block που διαβάστηκε από
+ * τον δίσκο (miss). Όσο τα misses έχουν διαδοχικούς
+ * αριθμούς, ζητάμε από το λειτουργικό με posix_fadvise(WILLNEED) να φέρει
+ * ασύγχρονα στην cache του τα επόμενα ra_window block, πριν φτάσει εκεί η
+ * σάρωση. Νέα αίτηση γίνεται όταν η σάρωση καταναλώσει το μισό παράθυρο,
+ * που κάθε φορά διπλασιάζεται έως BF_READAHEAD_MAX_BYTES. Μια μη σειριακή
+ * πρόσβαση το υποδιπλασιάζει έως BF_READAHEAD_MIN.
+ */
+static void read_ahead(int file_desc, int block_num) {
+    BF_File *file = file_at(file_desc);
+    if ((bf_flags & BF_READAHEAD) == 0 || atomic_load(&file->direct)) {
+        return;
+    }
+
+    int max_window = BF_READAHEAD_MAX_BYTES / bf_block_size;
+    int start = 0, end = 0;
+
+    if (max_window < BF_READAHEAD_MIN) {
+        max_window = BF_READAHEAD_MIN;
+    }
+
+    pthread_mutex_lock(&file->ra_lock);
+    if (block_num == file->ra_last + 1) {
+        if (block_num + file->ra_window / 2 >= file->ra_front) {
+            start = file->ra_front > block_num + 1 ? file->ra_front : block_num + 1;
+            end = block_num + 1 + file->ra_window;
+            if (end > atomic_load(&file->blocks)) {
+                end = atomic_load(&file->blocks);
+            }
+            if (end > start) {
+                file->ra_front = end;
+            }
+            if (file->ra_window * 2 <= max_window) {
+                file->ra_window *= 2;
+            }
+        }
+    } else if (block_num != file->ra_last) {
+        if (file->ra_window / 2 >= BF_READAHEAD_MIN) {
+            file->ra_window /= 2;
+        }
+        file->ra_front = block_num + 1;
+    }
+    file->ra_last = block_num;
+    pthread_mutex_unlock(&file->ra_lock);
+
+    if (end > start) {
+        int fd = fd_acquire(file_desc);
+        if (fd >= 0) {
+            posix_fadvise(fd, (off_t) start * bf_block_size, (off_t) (end - start) * bf_block_size, POSIX_FADV_WILLNEED);
+            fd_release(file_desc);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Αρχεία απεικονισμένα στην μνήμη (BF_FILE_MMAP)                          */
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Ένα αρχείο BF_FILE_MMAP απεικονίζεται ολόκληρο με MAP_SHARED και τα
+ * BF_Block δείχνουν κατευθείαν μέσα στην απεικόνιση, χωρίς πλαίσια και
+ * αντιγραφές. Το pin είναι μόνο ένας ατομικός μετρητής ανά αρχείο. Η
+ * απεικόνιση είναι μεγαλύτερη από το αρχείο, ώστε τα νέα block της
+ * BF_AllocateBlock να χρειάζονται μόνο ftruncate. Όταν γεμίσει, μεγαλώνει
+ * με mremap στην ίδια διεύθυνση αν γίνεται, αλλιώς μετακινείται, αλλά μόνο
+ * αν δεν υπάρχει κανένα καρφιτσωμένο block του αρχείου.
+ */
+static size_t map_capacity(size_t bytes) {
+    size_t capacity = BF_MAP_MIN_BYTES;
+    while (capacity < 2 * bytes) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static BF_ErrorCode map_open(BF_File *file, int fd, size_t bytes) {
+    size_t capacity = map_capacity(bytes);
+    void *map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        return BF_ERROR;
+    }
+    atomic_store(&file->map, map);
+    file->map_size = capacity;
+    atomic_store(&file->map_pins, 0);
+    atomic_store(&file->map_moving, false);
+    return BF_OK;
+}
+
+/*
+ * Καλείται με το alloc_lock του αρχείου. Πριν από μια μετακίνηση σηκώνεται
+ * το map_moving και μετά ελέγχονται τα pin, ενώ η map_bind κάνει τα
+ * αντίστροφα· έτσι τουλάχιστον η μία πλευρά βλέπει την άλλη και κανένα
+ * block δεν μένει με δείκτη στην παλιά απεικόνιση. Τα σύντομα pin άλλων
+ * νημάτων προλαβαίνουν να αφεθούν· ένα pin που κρατιέται όσο καλείται η
+ * BF_AllocateBlock εμποδίζει την μετακίνηση και επιστρέφεται
+ * BF_FULL_MEMORY_ERROR.
+ */
+static BF_ErrorCode map_grow(BF_File *file, size_t bytes) {
+    if (bytes <= file->map_size) {
+        return BF_OK;
+    }
+
+    size_t capacity = map_capacity(bytes);
+    char *old = atomic_load(&file->map);
+    void *map = mremap(old, file->map_size, capacity, 0);
+    if (map == MAP_FAILED) {
+        atomic_store(&file->map_moving, true);
+        for (int tries = 0; atomic_load(&file->map_pins) > 0 && tries < BF_MAP_MOVE_TRIES; tries++) {
+            sched_yield();
+        }
+        if (atomic_load(&file->map_pins) == 0) {
+            map = mremap(old, file->map_size, capacity, MREMAP_MAYMOVE);
+            if (map != MAP_FAILED) {
+                atomic_store(&file->map, map);
+            }
+        }
+        atomic_store(&file->map_moving, false);
+    }
+    if (map == MAP_FAILED) {
+        return BF_FULL_MEMORY_ERROR;
+    }
+    file->map_size = capacity;
+    return BF_OK;
+}
+
+static void map_bind(int file_desc, BF_Block *block, int block_num) {
+    BF_File *file = file_at(file_desc);
+
+    if (!(block->pinned && block->mapped && block->file_desc == file_desc && block->block_num == block_num)) {
+        if (block->pinned) {
+            BF_UnpinBlock(block);
+        }
+        atomic_fetch_add(&file->map_pins, 1);
+        while (atomic_load(&file->map_moving)) {
+            atomic_fetch_sub(&file->map_pins, 1);
+            pthread_mutex_lock(&file->alloc_lock);
+            pthread_mutex_unlock(&file->alloc_lock);
+            atomic_fetch_add(&file->map_pins, 1);
+        }
+    }
+    block->file_desc = file_desc;
+    block->block_num = block_num;
+    block->partition = BF_NONE;
+    block->frame = BF_NONE;
+    block->pinned = true;
+    block->mapped = true;
+    block->data = atomic_load(&file->map) + (size_t) block_num * bf_block_size;
+}
+
+/*
+ * Το νέο block είναι ήδη μηδενισμένο, αφού το ftruncate επεκτείνει το
+ * αρχείο με μηδενικά.
+ */
+static BF_ErrorCode map_allocate(int file_desc, BF_Block *block, int *block_num) {
+    BF_File *file = file_at(file_desc);
+    pthread_mutex_lock(&file->alloc_lock);
+
+    int num = atomic_load(&file->blocks);
+    size_t bytes = (size_t) (num + 1) * bf_block_size;
+    BF_ErrorCode code = map_grow(file, bytes);
+    if (code == BF_OK) {
+        int fd = fd_acquire(file_desc);
+        if (fd < 0 || ftruncate(fd, (off_t) bytes) != 0) {
+            code = BF_ERROR;
+        }
+        if (fd >= 0) {
+            fd_release(file_desc);
+        }
+    }
+    if (code == BF_OK) {
+        map_bind(file_desc, block, num);
+        atomic_store(&file->blocks, num + 1);
+        *block_num = num;
+    }
+
+    pthread_mutex_unlock(&file->alloc_lock);
+    return code;
+}
+
+static void pool_free(BF_Pool *pool) {
+    free(pool->memory);
+    free(pool->frame);
+    free(pool->link);
+    free(pool->ctrl);
+    free(pool->slots);
+    free(pool->ghost);
+    free(pool->ghost_link);
+    free(pool->ghost_buckets);
+    free(pool->heap);
+    for (int c = 0; c < BF_FILE_CHUNKS; c++) {
+        free(pool->file_stats[c]);
+    }
+    pthread_mutex_destroy(&pool->latch);
+    memset(pool, 0, sizeof (*pool));
+}
+
+/*
+ * Τα πλαίσια ευθυγραμμίζονται σε σελίδα, όπως απαιτεί το O_DIRECT. Μεγάλες
+ * ενδιάμεσες μνήμες ευθυγραμμίζονται σε 2 MB και ζητούν transparent huge
+ * pages, για λιγότερα TLB misses.
+ */
+static char * frame_memory(size_t size) {
+    size_t align = size >= BF_HUGE_PAGE ? BF_HUGE_PAGE : BF_PAGE_ALIGN;
+    void *memory = NULL;
+    if (posix_memalign(&memory, align, size) != 0) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (size >= BF_HUGE_PAGE) {
+        madvise(memory, size, MADV_HUGEPAGE);
+    }
+#endif
+    return memory;
+}
+
+static BF_ErrorCode pool_init(BF_Pool *pool, ReplacementAlgorithm policy, int block_size, int frames) {
+    memset(pool, 0, sizeof (*pool));
+    pthread_mutex_init(&pool->latch, NULL);
+    pool->policy = policy;
+    pool->frames = frames;
+    pool->block_size = block_size;
+    pool->memory = frame_memory((size_t) frames * block_size);
+    pool->frame = calloc(frames, sizeof (BF_Frame));
+    pool->link = calloc(frames, sizeof (BF_Link));
+    pool->group_mask = table_size(frames) / BF_GROUP - 1;
+    if (posix_memalign((void **) &pool->ctrl, 64, table_size(frames)) != 0) {
+        pool->ctrl = NULL;
+    }
+    if (posix_memalign((void **) &pool->slots, 64, sizeof (BF_Slot) * table_size(frames)) != 0) {
+        pool->slots = NULL;
+    }
+
+    switch (policy) {
+        case TWO_Q:
+            pool->twoq_kin = frames / 4 > 0 ? frames / 4 : 1;
+            pool->ghost_capacity = frames / 2 > 0 ? frames / 2 : 1;
+            break;
+        case ARC:
+        case LRU_K:
+            pool->ghost_capacity = frames;
+            break;
+        default:
+            pool->ghost_capacity = 0;
+            break;
+    }
+
+    if (pool->ghost_capacity > 0) {
+        pool->ghost = calloc(pool->ghost_capacity, sizeof (BF_Ghost));
+        pool->ghost_link = calloc(pool->ghost_capacity, sizeof (BF_Link));
+        pool->ghost_mask = table_size(pool->ghost_capacity) - 1;
+        pool->ghost_buckets = malloc(sizeof (int) * (pool->ghost_mask + 1));
+    }
+
+    if (policy == LRU_K) {
+        pool->heap = malloc(sizeof (int) * frames);
+    }
+
+    if (pool->memory == NULL || pool->frame == NULL || pool->link == NULL || pool->ctrl == NULL || pool->slots == NULL
+            || (pool->ghost_capacity > 0 && (pool->ghost == NULL || pool->ghost_link == NULL || pool->ghost_buckets == NULL))
+            || (policy == LRU_K && pool->heap == NULL)) {
+        pool_free(pool);
+        return BF_ERROR;
+    }
+
+    table_clear(pool);
+
+    list_init(&pool->free_list);
+    list_init(&pool->lists[0]);
+    list_init(&pool->lists[1]);
+    for (int i = frames - 1; i >= 0; i--) {
+        pool->frame[i].file_desc = BF_NONE;
+        pool->frame[i].block_num = BF_NONE;
+        pool->frame[i].list = BF_LIST_FREE;
+        pool->frame[i].heap_pos = BF_NONE;
+        atomic_init(&pool->frame[i].pin_count, 0);
+        atomic_init(&pool->frame[i].dirty, false);
+        pool->frame[i].data = pool->memory + (size_t) i * block_size;
+        list_push_front(&pool->free_list, pool->link, i);
+    }
+
+    list_init(&pool->ghost_free);
+    list_init(&pool->ghost_lists[0]);
+    list_init(&pool->ghost_lists[1]);
+    for (unsigned int b = 0; pool->ghost_capacity > 0 && b <= pool->ghost_mask; b++) {
+        pool->ghost_buckets[b] = BF_NONE;
+    }
+    for (int i = pool->ghost_capacity - 1; i >= 0; i--) {
+        pool->ghost[i].list = BF_LIST_FREE;
+        list_push_front(&pool->ghost_free, pool->ghost_link, i);
+    }
+
+    return BF_OK;
+}
+
+static BF_Pool * partition_of(int file_desc, int block_num) {
+    uint64_t h = page_hash(file_desc, block_num);
+    return &pools[(h * (uint64_t) partitions) >> 32];
+}
+
+static int choose_partitions(int pool_frames, int flags) {
+    if ((flags & BF_CONCURRENT) == 0) {
+        return 1;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = 1;
+    while (n < 2 * cpus && n < BF_MAX_PARTITIONS && (n * 2) * BF_MIN_PARTITION_FRAMES <= pool_frames) {
+        n *= 2;
+    }
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Δημόσιο API                                                            */
+/* ---------------------------------------------------------------------- */
+
+_Static_assert(sizeof (BF_Block) <= sizeof (BF_BlockHandle), "BF_BlockHandle too small");
+_Static_assert(_Alignof (BF_Block) <= _Alignof (BF_BlockHandle), "BF_BlockHandle misaligned");
+
+static void block_reset(BF_Block *b) {
+    b->file_desc = BF_NONE;
+    b->block_num = BF_NONE;
+    b->partition = BF_NONE;
+    b->frame = BF_NONE;
+    b->pinned = false;
+    b->mapped = false;
+    b->data = NULL;
+}
+
+void BF_Block_Init(BF_Block **block) {
+    BF_Block *b = malloc(sizeof (BF_Block));
+    block_reset(b);
+    *block = b;
+}
+
+void BF_Block_InitInPlace(BF_BlockHandle *handle, BF_Block **block) {
+    BF_Block *b = (BF_Block *) handle;
+    block_reset(b);
+    *block = b;
+}
+
+void BF_Block_Destroy(BF_Block **block) {
+    free(*block);
+    *block = NULL;
+}
+
+/* Οι αλλαγές σε block BF_FILE_MMAP γράφονται κατευθείαν στην απεικόνιση. */
+void BF_Block_SetDirty(BF_Block *block) {
+    if (block->pinned && !block->mapped) {
+        mark_dirty(&pools[block->partition], block->frame);
+        log_note(&pools[block->partition], block->frame);
+    }
+}
+
+char* BF_Block_GetData(const BF_Block *block) {
+    return block->data;
+}
+
+BF_ErrorCode BF_Init(const ReplacementAlgorithm repl_alg) {
+    return BF_InitEx(repl_alg, BF_BLOCK_SIZE, BF_BUFFER_SIZE, BF_DEFAULT);
+}
+
+BF_ErrorCode BF_InitEx(const ReplacementAlgorithm repl_alg, const int block_size, const int pool_frames, const int flags) {
+    if (bf_active) {
+        return BF_ACTIVE_ERROR;
+    }
+    if (repl_alg < LRU || repl_alg > LRU_K) {
+        return BF_ERROR;
+    }
+    if (block_size < BF_BLOCK_SIZE || block_size > BF_MAX_BLOCK_SIZE || (block_size & (block_size - 1)) != 0) {
+        return BF_ERROR;
+    }
+    if (pool_frames < 1) {
+        return BF_ERROR;
+    }
+
+    int n = choose_partitions(pool_frames, flags);
+    pools = calloc(n, sizeof (BF_Pool));
+    if (pools == NULL) {
+        return BF_ERROR;
+    }
+
+    for (int p = 0; p < n; p++) {
+        int frames = pool_frames / n + (p < pool_frames % n ? 1 : 0);
+        BF_ErrorCode code = pool_init(&pools[p], repl_alg, block_size, frames);
+        if (code != BF_OK) {
+            for (int q = 0; q < p; q++) {
+                pool_free(&pools[q]);
+            }
+            free(pools);
+            pools = NULL;
+            return code;
+        }
+    }
+
+    partitions = n;
+    bf_block_size = block_size;
+    bf_flags = flags;
+    bf_active = true;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_CreateFile(const char* filename) {
+    if (!bf_active) {
+        return BF_ERROR;
+    }
+    pthread_mutex_lock(&fd_lock);
+    int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && (errno == EMFILE || errno == ENFILE) && fd_evict_idle()) {
+        fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    pthread_mutex_unlock(&fd_lock);
+    if (fd < 0) {
+        return BF_FILE_ALREADY_EXISTS;
+    }
+    close(fd);
+    return BF_OK;
+}
+
+BF_ErrorCode BF_OpenFile(const char* filename, int *file_desc) {
+    return BF_OpenFileEx(filename, file_desc, BF_FILE_POOL);
+}
+
+BF_ErrorCode BF_OpenFileEx(const char* filename, int *file_desc, const BF_FileMode mode) {
+    if (!bf_active) {
+        return BF_ERROR;
+    }
+    if (mode != BF_FILE_POOL && mode != BF_FILE_MMAP) {
+        return BF_ERROR;
+    }
+
+    bool direct = mode == BF_FILE_POOL && (bf_flags & BF_DIRECT_IO) != 0;
+    pthread_mutex_lock(&fd_lock);
+    int fd = fd_open_path(filename, O_RDWR | (direct ? O_DIRECT : 0));
+    if (fd < 0 && direct && errno == EINVAL) {
+        direct = false;
+        fd = fd_open_path(filename, O_RDWR);
+    }
+    pthread_mutex_unlock(&fd_lock);
+    if (fd < 0) {
+        return BF_ERROR;
+    }
+
+    struct stat st;
+    char *path = realpath(filename, NULL);
+    if (path != NULL && bf_log.active && mode == BF_FILE_POOL) {
+        pthread_mutex_lock(&bf_log.checkpoint_lock);
+        BF_ErrorCode code = log_redo(path, fd);
+        pthread_mutex_unlock(&bf_log.checkpoint_lock);
+        if (code != BF_OK) {
+            free(path);
+            close(fd);
+            return code;
+        }
+    }
+    if (path == NULL || fstat(fd, &st) != 0) {
+        free(path);
+        close(fd);
+        return BF_ERROR;
+    }
+
+    pthread_mutex_lock(&files_lock);
+    int slot = file_slot();
+    if (slot == BF_NONE) {
+        pthread_mutex_unlock(&files_lock);
+        free(path);
+        close(fd);
+        return BF_OPEN_FILES_LIMIT_ERROR;
+    }
+
+    BF_File *file = file_at(slot);
+    file->path = path;
+    if (mode == BF_FILE_MMAP && map_open(file, fd, (size_t) st.st_size) != BF_OK) {
+        file_free_slot(slot);
+        pthread_mutex_unlock(&files_lock);
+        close(fd);
+        return BF_ERROR;
+    }
+
+    for (int p = 0; p < partitions; p++) {
+        pthread_mutex_lock(&pools[p].latch);
+        memset(file_stats_of(&pools[p], slot), 0, sizeof (BF_Stats));
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+
+    atomic_store(&file->direct, direct);
+    atomic_store(&file->needs_sync, false);
+    file->log_id = BF_NONE;
+    atomic_store(&file->blocks, (int) (st.st_size / bf_block_size));
+    file->ra_last = BF_NONE;
+    file->ra_front = 0;
+    file->ra_window = BF_READAHEAD_MIN;
+    file->mode = mode;
+    fd_register(slot, fd);
+    file->used = true;
+    pthread_mutex_unlock(&files_lock);
+
+    *file_desc = slot;
+    return BF_OK;
+}
+
+/*
+ * Δεν επιτρέπεται να τρέχει ταυτόχρονα με άλλες λειτουργίες πάνω στο ίδιο
+ * αρχείο· οι έλεγχοι για καρφιτσωμένα block γίνονται τμήμα προς τμήμα.
+ */
+BF_ErrorCode BF_CloseFile(const int file_desc) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+
+    BF_File *file = file_at(file_desc);
+    if (file->mode == BF_FILE_MMAP) {
+        if (atomic_load(&file->map_pins) > 0) {
+            return BF_AVAILABLE_PIN_BLOCKS_ERROR;
+        }
+        BF_ErrorCode result = munmap(atomic_load(&file->map), file->map_size) == 0 ? BF_OK : BF_ERROR;
+        pthread_mutex_lock(&files_lock);
+        if (fd_close(file_desc) != 0) {
+            result = BF_ERROR;
+        }
+        atomic_store(&file->map, NULL);
+        file_free_slot(file_desc);
+        pthread_mutex_unlock(&files_lock);
+        return result;
+    }
+
+    for (int p = 0; p < partitions; p++) {
+        BF_Pool *pool = &pools[p];
+        bool pinned = false;
+        pthread_mutex_lock(&pool->latch);
+        for (int i = 0; i < pool->frames; i++) {
+            if (pool->frame[i].file_desc == file_desc && atomic_load(&pool->frame[i].pin_count) > 0) {
+                pinned = true;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&pool->latch);
+        if (pinned) {
+            return BF_AVAILABLE_PIN_BLOCKS_ERROR;
+        }
+    }
+
+    /* Με ενεργό ημερολόγιο το κλείσιμο επικυρώνει τις αλλαγές, ώστε να
+     * μπορούν να γραφτούν οι σελίδες του αρχείου, και οι εικόνες τους
+     * γίνονται μόνιμες πριν από τα latch. */
+    if (bf_log.active && (BF_Commit() != BF_OK || BF_SyncLog() != BF_OK)) {
+        return BF_ERROR;
+    }
+
+    BF_ErrorCode result = BF_OK;
+    for (int p = 0; p < partitions; p++) {
+        BF_Pool *pool = &pools[p];
+        pthread_mutex_lock(&pool->latch);
+        for (int i = 0; i < pool->frames; i++) {
+            if (pool->frame[i].file_desc != file_desc) {
+                continue;
+            }
+            if (atomic_load(&pool->frame[i].dirty) && write_frame(pool, i) != BF_OK) {
+                result = BF_ERROR;
+            }
+            policy_remove(pool, i, false);
+            release_frame(pool, i);
+        }
+        for (int i = 0; i < pool->ghost_capacity; i++) {
+            if (pool->ghost[i].list != BF_LIST_FREE && pool->ghost[i].file_desc == file_desc) {
+                ghost_remove(pool, i);
+            }
+        }
+        pthread_mutex_unlock(&pool->latch);
+    }
+
+    /* Οι εικόνες του αρχείου στο ημερολόγιο μπορεί να σβηστούν μετά το κλείσιμο. */
+    if (atomic_exchange(&file->needs_sync, false)) {
+        int fd = fd_acquire(file_desc);
+        if (fd < 0 || fdatasync(fd) != 0) {
+            result = BF_ERROR;
+        }
+        if (fd >= 0) {
+            fd_release(file_desc);
+        }
+    }
+
+    pthread_mutex_lock(&files_lock);
+    if (fd_close(file_desc) != 0) {
+        result = BF_ERROR;
+    }
+    file_free_slot(file_desc);
+    pthread_mutex_unlock(&files_lock);
+    return result;
+}
+
+BF_ErrorCode BF_GetBlockSize(const int file_desc, int *block_size) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    *block_size = bf_block_size;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_GetBlockCounter(const int file_desc, int *blocks_num) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    *blocks_num = atomic_load(&file_at(file_desc)->blocks);
+    return BF_OK;
+}
+
+/*
+ * Το νέο block δεν γράφεται αμέσως στον δίσκο: παραμένει dirty στην μνήμη
+ * και γράφεται όταν απομακρυνθεί ή όταν κλείσει το αρχείο. Ο μετρητής
+ * block του αρχείου αυξάνεται μόνο αφού το block μπει στην μνήμη, ώστε
+ * ένα ταυτόχρονο BF_GetBlock να μην το διαβάσει από τον δίσκο.
+ */
+BF_ErrorCode BF_AllocateBlockEx(const int file_desc, BF_Block *block, int *block_num) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    if (file_at(file_desc)->mode == BF_FILE_MMAP) {
+        return map_allocate(file_desc, block, block_num);
+    }
+
+    BF_File *file = file_at(file_desc);
+    pthread_mutex_lock(&file->alloc_lock);
+
+    int num = atomic_load(&file->blocks);
+    BF_Pool *pool = partition_of(file_desc, num);
+    int i;
+
+    pthread_mutex_lock(&pool->latch);
+    BF_ErrorCode code = obtain_frame(pool, file_desc, num, &i);
+    if (code == BF_OK) {
+        memset(pool->frame[i].data, 0, pool->block_size);
+        mark_dirty(pool, i);
+        bind_block(pool, block, i);
+        log_note(pool, i);
+    }
+    pthread_mutex_unlock(&pool->latch);
+
+    if (code == BF_OK) {
+        atomic_store(&file->blocks, num + 1);
+        *block_num = num;
+    }
+    pthread_mutex_unlock(&file->alloc_lock);
+    return code;
+}
+
+BF_ErrorCode BF_AllocateBlock(const int file_desc, BF_Block *block) {
+    int block_num;
+    return BF_AllocateBlockEx(file_desc, block, &block_num);
+}
+
+static BF_ErrorCode append_through_pool(int file_desc, const char *data, int n, int *first_block) {
+    BF_BlockHandle handle;
+    BF_Block *block;
+    BF_Block_InitInPlace(&handle, &block);
+
+    for (int k = 0; k < n; k++) {
+        int block_num;
+        BF_ErrorCode code = BF_AllocateBlockEx(file_desc, block, &block_num);
+        if (code != BF_OK) {
+            return code;
+        }
+        if (k == 0) {
+            *first_block = block_num;
+        }
+        memcpy(block->data, data + (size_t) k * bf_block_size, bf_block_size);
+        BF_Block_SetDirty(block);
+        BF_UnpinBlock(block);
+    }
+    return BF_OK;
+}
+
+/*
+ * Τα νέα block δεν υπάρχουν στην ενδιάμεση μνήμη, οπότε αρκεί το
+ * alloc_lock για να μην πάρει άλλο νήμα τους ίδιους αριθμούς.
+ */
+BF_ErrorCode BF_AppendBlocks(const int file_desc, const char *data, const int n, int *first_block) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    if (n <= 0) {
+        return BF_ERROR;
+    }
+    BF_File *file = file_at(file_desc);
+    if (file->mode == BF_FILE_MMAP || bf_log.active) {
+        return append_through_pool(file_desc, data, n, first_block);
+    }
+
+    pthread_mutex_lock(&file->alloc_lock);
+    int num = atomic_load(&file->blocks);
+    size_t length = (size_t) n * bf_block_size;
+    off_t offset = (off_t) num * bf_block_size;
+    size_t done = 0;
+
+    int fd = fd_acquire(file_desc);
+    while (fd >= 0 && done < length) {
+        ssize_t written = pwrite(fd, data + done, length - done, offset + (off_t) done);
+        if (written < 0 && direct_fallback(file_desc, fd)) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        done += (size_t) written;
+    }
+    if (fd >= 0) {
+        fd_release(file_desc);
+    }
+
+    if (done == length) {
+        atomic_store(&file->blocks, num + n);
+        *first_block = num;
+    }
+    pthread_mutex_unlock(&file->alloc_lock);
+    if (done != length) {
+        return BF_ERROR;
+    }
+
+    BF_Pool *pool = partition_of(file_desc, num);
+    pthread_mutex_lock(&pool->latch);
+    BF_COUNT(pool, file_desc, writes, 1);
+    BF_COUNT(pool, file_desc, bytes_written, length);
+    pthread_mutex_unlock(&pool->latch);
+    return BF_OK;
+}
+
+/*
+ * Κάθε BF_Block κρατάει το πολύ ένα pin: αν ζητηθεί ξανά το block που ήδη
+ * κρατάει, δεν αυξάνεται ο μετρητής, όπως και στην αρχική βιβλιοθήκη.
+ */
+BF_ErrorCode BF_GetBlock(const int file_desc, const int block_num, BF_Block *block) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    if (block_num < 0 || block_num >= atomic_load(&file_at(file_desc)->blocks)) {
+        return BF_INVALID_BLOCK_NUMBER_ERROR;
+    }
+    if (file_at(file_desc)->mode == BF_FILE_MMAP) {
+        map_bind(file_desc, block, block_num);
+        return BF_OK;
+    }
+
+    BF_Pool *pool = partition_of(file_desc, block_num);
+    pthread_mutex_lock(&pool->latch);
+
+    BF_COUNT(pool, file_desc, requests, 1);
+    int i = frame_lookup(pool, file_desc, block_num);
+    if (i != BF_NONE) {
+        BF_COUNT(pool, file_desc, hits, 1);
+        policy_hit(pool, i);
+        if (!(block->pinned && block->partition == pool - pools && block->frame == i)) {
+            bind_block(pool, block, i);
+        }
+        pthread_mutex_unlock(&pool->latch);
+        return BF_OK;
+    }
+
+    BF_COUNT(pool, file_desc, misses, 1);
+    BF_ErrorCode code = obtain_frame(pool, file_desc, block_num, &i);
+    if (code == BF_OK) {
+        code = read_frame(pool, i);
+        if (code == BF_OK) {
+            bind_block(pool, block, i);
+        } else {
+            policy_remove(pool, i, false);
+            release_frame(pool, i);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->latch);
+    if (code == BF_OK) {
+        read_ahead(file_desc, block_num);
+    }
+    return code;
+}
+
+static void lock_partitions(uint64_t mask) {
+    for (int p = 0; p < partitions; p++) {
+        if (mask & (1ULL << p)) {
+            pthread_mutex_lock(&pools[p].latch);
+        }
+    }
+}
+
+static void unlock_partitions(uint64_t mask) {
+    for (int p = partitions - 1; p >= 0; p--) {
+        if (mask & (1ULL << p)) {
+            pthread_mutex_unlock(&pools[p].latch);
+        }
+    }
+}
+
+/*
+ * Διαβάζει με ένα preadv count block με διαδοχικούς αριθμούς, που μπορεί
+ * να βρίσκονται σε πλαίσια διαφορετικών τμημάτων.
+ */
+static BF_ErrorCode read_run(int file_desc, BF_Pending *run, int count) {
+    struct iovec iov[BF_BATCH];
+    for (int k = 0; k < count; k++) {
+        iov[k].iov_base = run[k].pool->frame[run[k].frame].data;
+        iov[k].iov_len = bf_block_size;
+    }
+
+    int fd = fd_acquire(file_desc);
+    if (fd < 0) {
+        return BF_ERROR;
+    }
+    ssize_t n = preadv(fd, iov, count, (off_t) run[0].block_num * bf_block_size);
+    if (n < 0 && direct_fallback(file_desc, fd)) {
+        n = preadv(fd, iov, count, (off_t) run[0].block_num * bf_block_size);
+    }
+    fd_release(file_desc);
+    if (n < 0) {
+        return BF_ERROR;
+    }
+
+    for (int k = 0; k < count; k++) {
+        ssize_t got = n - (ssize_t) k * bf_block_size;
+        got = got < 0 ? 0 : (got > bf_block_size ? bf_block_size : got);
+        if (got < bf_block_size) {
+            memset(run[k].pool->frame[run[k].frame].data + got, 0, bf_block_size - got);
+        }
+        BF_COUNT(run[k].pool, file_desc, reads, 1);
+        BF_COUNT(run[k].pool, file_desc, bytes_read, got);
+    }
+    return BF_OK;
+}
+
+/*
+ * Φέρνει έως BF_BATCH block κρατώντας τα latch όλων των τμημάτων που
+ * αγγίζει, σε αύξουσα σειρά ώστε να μην υπάρχει αδιέξοδο με άλλη
+ * BF_GetBlocks. Τα block που λείπουν καρφιτσώνονται πρώτα σε πλαίσια και
+ * μετά διαβάζονται ταξινομημένα, ένα preadv για κάθε σειρά διαδοχικών
+ * αριθμών.
+ */
+static BF_ErrorCode get_batch(int file_desc, const int *block_nums, int n, BF_Block **blocks) {
+    BF_Pending pending[BF_BATCH];
+    bool bound[BF_BATCH];
+    int misses = 0;
+    uint64_t mask = 0;
+
+    for (int k = 0; k < n; k++) {
+        mask |= 1ULL << (partition_of(file_desc, block_nums[k]) - pools);
+        bound[k] = false;
+    }
+    lock_partitions(mask);
+
+    BF_ErrorCode code = BF_OK;
+    for (int k = 0; k < n && code == BF_OK; k++) {
+        BF_Pool *pool = partition_of(file_desc, block_nums[k]);
+        BF_Block *block = blocks[k];
+
+        BF_COUNT(pool, file_desc, requests, 1);
+        int i = frame_lookup(pool, file_desc, block_nums[k]);
+        if (i != BF_NONE) {
+            BF_COUNT(pool, file_desc, hits, 1);
+            policy_hit(pool, i);
+            if (!(block->pinned && block->partition == pool - pools && block->frame == i)) {
+                bind_block(pool, block, i);
+                bound[k] = true;
+            }
+            continue;
+        }
+
+        BF_COUNT(pool, file_desc, misses, 1);
+        code = obtain_frame(pool, file_desc, block_nums[k], &i);
+        if (code == BF_OK) {
+            bind_block(pool, block, i);
+            bound[k] = true;
+            pending[misses].pool = pool;
+            pending[misses].frame = i;
+            pending[misses].block_num = block_nums[k];
+            misses++;
+        }
+    }
+
+    for (int a = 1; a < misses; a++) {
+        BF_Pending p = pending[a];
+        int b = a - 1;
+        while (b >= 0 && pending[b].block_num > p.block_num) {
+            pending[b + 1] = pending[b];
+            b--;
+        }
+        pending[b + 1] = p;
+    }
+
+    for (int r = 0; r < misses && code == BF_OK;) {
+        int len = 1;
+        while (r + len < misses && pending[r + len].block_num == pending[r].block_num + len) {
+            len++;
+        }
+        code = read_run(file_desc, pending + r, len);
+        r += len;
+    }
+
+    if (code != BF_OK) {
+        for (int k = 0; k < n; k++) {
+            if (bound[k]) {
+                atomic_fetch_sub(&pools[blocks[k]->partition].frame[blocks[k]->frame].pin_count, 1);
+                blocks[k]->pinned = false;
+            }
+        }
+        for (int r = 0; r < misses; r++) {
+            policy_remove(pending[r].pool, pending[r].frame, false);
+            release_frame(pending[r].pool, pending[r].frame);
+        }
+    }
+
+    unlock_partitions(mask);
+    if (code == BF_OK) {
+        for (int r = 0; r < misses; r++) {
+            read_ahead(file_desc, pending[r].block_num);
+        }
+    }
+    return code;
+}
+
+/*
+ * Τα block_nums χωρίζονται σε ομάδες των BF_BATCH block. Αν αποτύχει
+ * κάποια ομάδα, ξεκαρφιτσώνονται και τα block των προηγούμενων.
+ */
+BF_ErrorCode BF_GetBlocks(const int file_desc, const int *block_nums, const int n, BF_Block **blocks) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+    int count = atomic_load(&file_at(file_desc)->blocks);
+    for (int k = 0; k < n; k++) {
+        if (block_nums[k] < 0 || block_nums[k] >= count) {
+            return BF_INVALID_BLOCK_NUMBER_ERROR;
+        }
+    }
+    if (file_at(file_desc)->mode == BF_FILE_MMAP) {
+        for (int k = 0; k < n; k++) {
+            map_bind(file_desc, blocks[k], block_nums[k]);
+        }
+        return BF_OK;
+    }
+
+    for (int start = 0; start < n; start += BF_BATCH) {
+        int size = n - start < BF_BATCH ? n - start : BF_BATCH;
+        BF_ErrorCode code = get_batch(file_desc, block_nums + start, size, blocks + start);
+        if (code != BF_OK) {
+            for (int k = 0; k < start; k++) {
+                BF_UnpinBlock(blocks[k]);
+            }
+            return code;
+        }
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_UnpinBlock(BF_Block *block) {
+    if (!block->pinned) {
+        return BF_OK;
+    }
+    if (!valid_file(block->file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+
+    if (block->mapped) {
+        atomic_fetch_sub(&file_at(block->file_desc)->map_pins, 1);
+    } else {
+        atomic_fetch_sub(&pools[block->partition].frame[block->frame].pin_count, 1);
+    }
+    block->pinned = false;
+    return BF_OK;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Writer: γράφει dirty πλαίσια στο παρασκήνιο                             */
+/* ---------------------------------------------------------------------- */
+
+/* Ο writer δεν γράφει πλαίσια που άλλαξαν μετά την τελευταία BF_Commit
+ * ούτε πλαίσια που θα χρειάζονταν fdatasync του ημερολογίου. */
+static int write_if_dirty(BF_Pool *pool, int i) {
+    if (!atomic_load(&pool->frame[i].dirty) || !frame_evictable(pool, i, true)) {
+        return 0;
+    }
+    return write_frame(pool, i) == BF_OK ? 1 : 0;
+}
+
+/*
+ * Γράφει έως budget dirty, μη καρφιτσωμένα πλαίσια του τμήματος με τη
+ * σειρά που θα τα διάλεγε ως θύματα η πολιτική, ώστε η αντικατάσταση να
+ * βρίσκει καθαρά πλαίσια. Καλείται με το latch του τμήματος.
+ */
+static int write_ahead(BF_Pool *pool, int budget) {
+    int written = 0;
+
+    switch (pool->policy) {
+        case LRU:
+        case TWO_Q:
+        case ARC:
+            for (int l = 0; l < 2; l++) {
+                for (int i = pool->lists[l].tail; i != BF_NONE && written < budget; i = pool->link[i].prev) {
+                    written += write_if_dirty(pool, i);
+                }
+            }
+            break;
+        case MRU:
+            for (int i = pool->lists[0].head; i != BF_NONE && written < budget; i = pool->link[i].next) {
+                written += write_if_dirty(pool, i);
+            }
+            break;
+        case CLOCK:
+            for (int step = 0; step < pool->frames && written < budget; step++) {
+                written += write_if_dirty(pool, (pool->clock_hand + step) % pool->frames);
+            }
+            break;
+        case LRU_K:
+            for (int h = 0; h < pool->heap_size && written < budget; h++) {
+                written += write_if_dirty(pool, pool->heap[h]);
+            }
+            break;
+    }
+    return written;
+}
+
+/*
+ * Κάθε interval_ms ελέγχει το ποσοστό των dirty πλαισίων. Πάνω από το
+ * low_watermark γράφει έως pages_per_second * interval_ms / 1000 πλαίσια,
+ * όσα χρειάζονται για να πέσει στο low_watermark. Πάνω από το
+ * high_watermark γράφει χωρίς όριο ρυθμού. Το latch κάθε τμήματος
+ * κρατιέται για το πολύ BF_WRITER_CHUNK εγγραφές κάθε φορά.
+ */
+static void * writer_main(void *arg) {
+    (void) arg;
+    int total_frames = 0;
+    for (int p = 0; p < partitions; p++) {
+        total_frames += pools[p].frames;
+    }
+
+    pthread_mutex_lock(&writer_lock);
+    while (!writer_stop) {
+        BF_WriterConfig config = writer_config;
+        pthread_mutex_unlock(&writer_lock);
+
+        int dirty = 0;
+        for (int p = 0; p < partitions; p++) {
+            dirty += atomic_load(&pools[p].dirty_frames);
+        }
+
+        int low = (int) ((long) total_frames * config.low_watermark / 100);
+        int budget = dirty > low ? dirty - low : 0;
+        if (dirty * 100L < (long) total_frames * config.high_watermark && config.pages_per_second > 0) {
+            int rate = (int) ((long) config.pages_per_second * config.interval_ms / 1000);
+            rate = rate > 0 ? rate : 1;
+            budget = budget < rate ? budget : rate;
+        }
+
+        for (int p = 0; p < partitions && budget > 0; p++) {
+            int written;
+            do {
+                pthread_mutex_lock(&pools[p].latch);
+                written = write_ahead(&pools[p], budget < BF_WRITER_CHUNK ? budget : BF_WRITER_CHUNK);
+                pthread_mutex_unlock(&pools[p].latch);
+                budget -= written;
+            } while (written > 0 && budget > 0);
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += config.interval_ms / 1000;
+        deadline.tv_nsec += (long) (config.interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&writer_lock);
+        if (!writer_stop) {
+            pthread_cond_timedwait(&writer_cond, &writer_lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&writer_lock);
+    return NULL;
+}
+
+BF_ErrorCode BF_StartWriter(const BF_WriterConfig *config) {
+    if (!bf_active || writer_running) {
+        return BF_ERROR;
+    }
+    if (config->interval_ms < 1 || config->pages_per_second < 0
+            || config->low_watermark < 0 || config->high_watermark > 100
+            || config->low_watermark > config->high_watermark) {
+        return BF_ERROR;
+    }
+
+    writer_config = *config;
+    writer_stop = false;
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        return BF_ERROR;
+    }
+    writer_running = true;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_StopWriter() {
+    if (!writer_running) {
+        return BF_ERROR;
+    }
+
+    pthread_mutex_lock(&writer_lock);
+    writer_stop = true;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_lock);
+
+    pthread_join(writer_thread, NULL);
+    writer_running = false;
+    return BF_OK;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Ημερολόγιο: δημόσιο API                                                 */
+/* ---------------------------------------------------------------------- */
+
+static void log_release() {
+    if (bf_log.fd >= 0) {
+        close(bf_log.fd);
+    }
+    free(bf_log.path);
+    free(bf_log.buffer);
+    free(bf_log.changed);
+    free(bf_log.changed_spare);
+    log_free_redo();
+    bf_log.fd = BF_NONE;
+    bf_log.path = NULL;
+    bf_log.buffer = NULL;
+    bf_log.changed = NULL;
+    bf_log.changed_spare = NULL;
+    bf_log.active = false;
+}
+
+BF_ErrorCode BF_OpenLog(const char *filename, const BF_LogConfig *config) {
+    if (!bf_active || bf_log.active || config->group_commit < 1 || config->checkpoint_bytes < 0) {
+        return BF_ERROR;
+    }
+    for (int f = 0; f < file_count; f++) {
+        if (file_at(f)->used) {
+            return BF_ERROR;
+        }
+    }
+    pthread_once(&crc_once, crc_init);
+
+    int total_frames = 0;
+    for (int p = 0; p < partitions; p++) {
+        total_frames += pools[p].frames;
+    }
+
+    bf_log.fd = open(filename, O_RDWR | O_CREAT, 0644);
+    bf_log.path = realpath(filename, NULL);
+    bf_log.buffer = malloc(BF_LOG_BUFFER);
+    bf_log.changed = malloc(sizeof (BF_Changed) * total_frames);
+    bf_log.changed_spare = malloc(sizeof (BF_Changed) * total_frames);
+    if (bf_log.fd < 0 || bf_log.path == NULL || bf_log.buffer == NULL
+            || bf_log.changed == NULL || bf_log.changed_spare == NULL) {
+        log_release();
+        return BF_ERROR;
+    }
+
+    bf_log.config = *config;
+    bf_log.buffered = 0;
+    bf_log.lsn = 0;
+    bf_log.written_lsn = 0;
+    bf_log.durable_lsn = 0;
+    bf_log.lsn_base = 0;
+    bf_log.syncing = false;
+    bf_log.pending_commits = 0;
+    bf_log.changed_count = 0;
+    memset(&bf_log.stats, 0, sizeof (bf_log.stats));
+
+    if (log_scan() != BF_OK) {
+        log_release();
+        return BF_ERROR;
+    }
+    bf_log.next_file_id = bf_log.redo_path_count;
+    bf_log.active = true;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_Commit() {
+    if (!bf_log.active) {
+        return BF_OK;
+    }
+
+    BF_ErrorCode code = BF_OK;
+    pthread_mutex_lock(&bf_log.commit_lock);
+
+    pthread_mutex_lock(&bf_log.lock);
+    BF_Changed *changed = bf_log.changed;
+    int count = bf_log.changed_count;
+    bf_log.changed = bf_log.changed_spare;
+    bf_log.changed_count = 0;
+    pthread_mutex_unlock(&bf_log.lock);
+
+    for (int k = 0; k < count; k++) {
+        BF_Pool *pool = &pools[changed[k].partition];
+        int i = changed[k].frame;
+        pthread_mutex_lock(&pool->latch);
+        atomic_store(&pool->frame[i].changed, false);
+        if (pool->frame[i].file_desc != BF_NONE && log_frame(pool, i) != BF_OK) {
+            log_note(pool, i);
+            code = BF_ERROR;
+        }
+        pthread_mutex_unlock(&pool->latch);
+    }
+
+    pthread_mutex_lock(&bf_log.lock);
+    bf_log.changed_spare = changed;
+    uint64_t number = bf_log.stats.commits + 1;
+    if (code == BF_OK) {
+        code = log_append(BF_LOG_COMMIT, BF_NONE, BF_NONE, &number, sizeof (number));
+    }
+    bf_log.stats.commits++;
+    bool sync = ++bf_log.pending_commits >= bf_log.config.group_commit;
+    if (sync) {
+        bf_log.pending_commits = 0;
+    }
+    uint64_t target = bf_log.lsn;
+    bool checkpoint = bf_log.config.checkpoint_bytes > 0
+            && bf_log.file_end + (off_t) bf_log.buffered > bf_log.config.checkpoint_bytes;
+    pthread_mutex_unlock(&bf_log.lock);
+    pthread_mutex_unlock(&bf_log.commit_lock);
+
+    if (code == BF_OK && sync) {
+        code = log_sync(target);
+    }
+    if (code == BF_OK && checkpoint) {
+        code = BF_Checkpoint();
+    }
+    return code;
+}
+
+BF_ErrorCode BF_SyncLog() {
+    if (!bf_log.active) {
+        return BF_OK;
+    }
+    pthread_mutex_lock(&bf_log.lock);
+    uint64_t target = bf_log.lsn;
+    bf_log.pending_commits = 0;
+    pthread_mutex_unlock(&bf_log.lock);
+    return log_sync(target);
+}
+
+/*
+ * Οι εγγραφές πριν από το start αφορούν σελίδες που γράφονται εδώ στα
+ * αρχεία τους ή είχαν γραφτεί ήδη, οπότε μετά το fdatasync των αρχείων
+ * δεν χρειάζονται. Οι BF_Commit περιμένουν όσο διαρκεί το checkpoint. Ένα
+ * πλαίσιο που άλλαξε μετά την τελευταία BF_Commit δεν γράφεται, οπότε αν
+ * η τελευταία εικόνα του είναι πριν από το start, το ημερολόγιο κρατιέται
+ * από την αρχή εκείνης της εικόνας.
+ */
+BF_ErrorCode BF_Checkpoint() {
+    if (!bf_log.active) {
+        return BF_ERROR;
+    }
+
+    pthread_mutex_lock(&bf_log.checkpoint_lock);
+    pthread_mutex_lock(&bf_log.commit_lock);
+
+    pthread_mutex_lock(&bf_log.lock);
+    uint64_t start = bf_log.lsn;
+    pthread_mutex_unlock(&bf_log.lock);
+
+    /* Όλες οι εικόνες γίνονται μόνιμες πριν από τα latch. */
+    BF_ErrorCode code = log_sync(start);
+    uint64_t keep = start;
+
+    for (int p = 0; p < partitions && code == BF_OK; p++) {
+        BF_Pool *pool = &pools[p];
+        const uint64_t image = sizeof (BF_LogRecord) + (uint64_t) pool->block_size;
+        pthread_mutex_lock(&pool->latch);
+        for (int i = 0; i < pool->frames; i++) {
+            BF_Frame *frame = &pool->frame[i];
+            if (frame->file_desc == BF_NONE || !atomic_load(&frame->dirty)) {
+                continue;
+            }
+            if (atomic_load(&frame->changed)) {
+                if (frame->lsn != 0 && frame->lsn - image < keep) {
+                    keep = frame->lsn - image;
+                }
+                continue;
+            }
+            if (write_frame(pool, i) != BF_OK) {
+                code = BF_ERROR;
+            }
+        }
+        pthread_mutex_unlock(&pool->latch);
+    }
+
+    pthread_mutex_lock(&files_lock);
+    for (int f = 0; f < file_count && code == BF_OK; f++) {
+        BF_File *file = file_at(f);
+        if (file->used && atomic_exchange(&file->needs_sync, false)) {
+            int fd = fd_acquire(f);
+            if (fd < 0 || fdatasync(fd) != 0) {
+                code = BF_ERROR;
+            }
+            if (fd >= 0) {
+                fd_release(f);
+            }
+        }
+    }
+
+    for (int r = 0; r < bf_log.redo_count && code == BF_OK; r++) {
+        if (bf_log.redo[r].file_id != BF_NONE) {
+            code = log_redo(bf_log.redo_paths[bf_log.redo[r].file_id], BF_NONE);
+        }
+    }
+    if (code == BF_OK) {
+        log_free_redo();
+    }
+
+    if (code == BF_OK) {
+        pthread_mutex_lock(&bf_log.lock);
+        while (bf_log.syncing) {
+            pthread_cond_wait(&bf_log.synced, &bf_log.lock);
+        }
+        code = log_rewrite(keep);
+        if (code == BF_OK) {
+            bf_log.stats.checkpoints++;
+        }
+        pthread_mutex_unlock(&bf_log.lock);
+    }
+    pthread_mutex_unlock(&files_lock);
+
+    pthread_mutex_unlock(&bf_log.commit_lock);
+    pthread_mutex_unlock(&bf_log.checkpoint_lock);
+    return code;
+}
+
+int BF_LogActive() {
+    return bf_log.active ? 1 : 0;
+}
+
+BF_ErrorCode BF_GetLogStats(BF_LogStats *stats) {
+    if (!bf_log.active) {
+        return BF_ERROR;
+    }
+    pthread_mutex_lock(&bf_log.lock);
+    *stats = bf_log.stats;
+    pthread_mutex_unlock(&bf_log.lock);
+    return BF_OK;
+}
+
+/*
+ * Στο κλείσιμο οι αλλαγές που απομένουν επικυρώνονται, όλες οι σελίδες
+ * γίνονται μόνιμες στα αρχεία τους και το ημερολόγιο αδειάζει. Αν αποτύχει
+ * το checkpoint, το ημερολόγιο μένει ως έχει για την ανάκτηση.
+ */
+static BF_ErrorCode log_close() {
+    BF_ErrorCode code = BF_Commit();
+    if (code == BF_OK) {
+        code = BF_Checkpoint();
+    }
+    if (code == BF_OK && (ftruncate(bf_log.fd, 0) != 0 || fdatasync(bf_log.fd) != 0)) {
+        code = BF_ERROR;
+    }
+    log_release();
+    return code;
+}
+
+BF_ErrorCode BF_SetDescriptorLimit(const int limit) {
+    if (limit < 1) {
+        return BF_ERROR;
+    }
+    pthread_mutex_lock(&fd_lock);
+    fd_limit = limit;
+    fd_trim();
+    pthread_mutex_unlock(&fd_lock);
+    return BF_OK;
+}
+
+BF_ErrorCode BF_GetStats(const int file_desc, BF_Stats *stats) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+
+    memset(stats, 0, sizeof (BF_Stats));
+    stats->policy = pools[0].policy;
+    for (int p = 0; p < partitions; p++) {
+        pthread_mutex_lock(&pools[p].latch);
+        stats_add(stats, file_stats_of(&pools[p], file_desc));
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_ResetStats(const int file_desc) {
+    if (!valid_file(file_desc)) {
+        return BF_INVALID_FILE_ERROR;
+    }
+
+    for (int p = 0; p < partitions; p++) {
+        pthread_mutex_lock(&pools[p].latch);
+        memset(file_stats_of(&pools[p], file_desc), 0, sizeof (BF_Stats));
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_GetGlobalStats(BF_Stats *stats) {
+    if (!bf_active) {
+        return BF_ERROR;
+    }
+
+    memset(stats, 0, sizeof (BF_Stats));
+    stats->policy = pools[0].policy;
+    for (int p = 0; p < partitions; p++) {
+        pthread_mutex_lock(&pools[p].latch);
+        stats_add(stats, &pools[p].total);
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_GetPolicyStats(const ReplacementAlgorithm repl_alg, BF_Stats *stats) {
+    if (repl_alg < LRU || repl_alg > LRU_K) {
+        return BF_ERROR;
+    }
+
+    memset(stats, 0, sizeof (BF_Stats));
+    pthread_mutex_lock(&stats_lock);
+    stats_add(stats, &policy_stats[repl_alg]);
+    pthread_mutex_unlock(&stats_lock);
+    stats->policy = repl_alg;
+
+    if (bf_active && pools[0].policy == repl_alg) {
+        for (int p = 0; p < partitions; p++) {
+            pthread_mutex_lock(&pools[p].latch);
+            stats_add(stats, &pools[p].total);
+            pthread_mutex_unlock(&pools[p].latch);
+        }
+    }
+    return BF_OK;
+}
+
+void BF_ResetGlobalStats() {
+    pthread_mutex_lock(&stats_lock);
+    memset(policy_stats, 0, sizeof (policy_stats));
+    pthread_mutex_unlock(&stats_lock);
+
+    for (int p = 0; p < partitions; p++) {
+        pthread_mutex_lock(&pools[p].latch);
+        memset(&pools[p].total, 0, sizeof (BF_Stats));
+        for (int c = 0; c < BF_FILE_CHUNKS && pools[p].file_stats[c] != NULL; c++) {
+            memset(pools[p].file_stats[c], 0, BF_FILE_CHUNK * sizeof (BF_Stats));
+        }
+        pthread_mutex_unlock(&pools[p].latch);
+    }
+}
+
+void BF_PrintStats(const BF_Stats *stats) {
+    static const char *names[] = {"LRU", "MRU", "CLOCK", "2Q", "ARC", "LRU-K"};
+    double hit_ratio = stats->requests > 0 ? (double) stats->hits / stats->requests : 0.0;
+
+    printf("Replacement policy         : %s \n", names[stats->policy]);
+    printf("Page requests              : %llu \n", stats->requests);
+    printf("Pool hits                  : %llu \n", stats->hits);
+    printf("Pool misses                : %llu \n", stats->misses);
+    printf("Hit ratio                  : %.4f \n", hit_ratio);
+    printf("Dirty evictions            : %llu \n", stats->dirty_evictions);
+    printf("Clean evictions            : %llu \n", stats->clean_evictions);
+    printf("Physical reads             : %llu \n", stats->reads);
+    printf("Physical writes            : %llu \n", stats->writes);
+    printf("Bytes read                 : %llu \n", stats->bytes_read);
+    printf("Bytes written              : %llu \n", stats->bytes_written);
+}
+
+void BF_PrintError(BF_ErrorCode err) {
+    switch (err) {
+        case BF_OK:
+            break;
+        case BF_OPEN_FILES_LIMIT_ERROR:
+            fprintf(stderr, "BF Error: Reached the maximum number of open files\n");
+            break;
+        case BF_INVALID_FILE_ERROR:
+            fprintf(stderr, "BF Error: Invalid file descriptor\n");
+            break;
+        case BF_ACTIVE_ERROR:
+            fprintf(stderr, "BF Error: BF is already active\n");
+            break;
+        case BF_FILE_ALREADY_EXISTS:
+            fprintf(stderr, "BF Error: File already exists\n");
+            break;
+        case BF_FULL_MEMORY_ERROR:
+            fprintf(stderr, "BF Error: BF memory is full\n");
+            break;
+        case BF_INVALID_BLOCK_NUMBER_ERROR:
+            fprintf(stderr, "BF Error: Invalid block number\n");
+            break;
+        case BF_AVAILABLE_PIN_BLOCKS_ERROR:
+            fprintf(stderr, "BF Error: There are pinned blocks of the file in memory\n");
+            break;
+        case BF_ERROR:
+        default:
+            fprintf(stderr, "BF Error\n");
+            break;
+    }
+}
+
+BF_ErrorCode BF_Close() {
+    if (!bf_active) {
+        return BF_ERROR;
+    }
+
+    BF_StopWriter();
+
+    BF_ErrorCode result = BF_OK;
+    if (bf_log.active && log_close() != BF_OK) {
+        result = BF_ERROR;
+    }
+    for (int p = 0; p < partitions; p++) {
+        BF_Pool *pool = &pools[p];
+        pthread_mutex_lock(&pool->latch);
+        for (int i = 0; i < pool->frames; i++) {
+            if (pool->frame[i].file_desc == BF_NONE) {
+                continue;
+            }
+            if (atomic_load(&pool->frame[i].pin_count) > 0) {
+                result = BF_AVAILABLE_PIN_BLOCKS_ERROR;
+            }
+            if (atomic_load(&pool->frame[i].dirty) && write_frame(pool, i) != BF_OK) {
+                result = BF_ERROR;
+            }
+        }
+        pthread_mutex_unlock(&pool->latch);
+        pthread_mutex_lock(&stats_lock);
+        stats_add(&policy_stats[pool->policy], &pool->total);
+        pthread_mutex_unlock(&stats_lock);
+        pool_free(pool);
+    }
+
+    for (int f = 0; f < file_count; f++) {
+        BF_File *file = file_at(f);
+        if (file->used) {
+            if (file->mode == BF_FILE_MMAP) {
+                if (atomic_load(&file->map_pins) > 0) {
+                    result = BF_AVAILABLE_PIN_BLOCKS_ERROR;
+                }
+                munmap(atomic_load(&file->map), file->map_size);
+            }
+            fd_close(f);
+            free(file->path);
+        }
+        pthread_mutex_destroy(&file->alloc_lock);
+        pthread_mutex_destroy(&file->ra_lock);
+    }
+    for (int c = 0; c < BF_FILE_CHUNKS; c++) {
+        free(file_chunks[c]);
+        file_chunks[c] = NULL;
+    }
+    file_count = 0;
+    free_files = BF_NONE;
+
+    free(pools);
+    pools = NULL;
+    partitions = 0;
+    bf_active = false;
+    return result;
+}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bf.h"
+#include "bloom_filter.h"
+
+static int bl_errors = 0;
+
+#define CALL_BF(call, printError, error_code)       \
+{                           \
+  BF_ErrorCode code = call; \
+  if (code != BF_OK) {         \
+    if (printError) {\
+        bl_errors++; \
+        BF_PrintError(code);    \
+        fprintf(stderr, "code: %d \n", code); \
+    }\
+    return error_code;\
+  } \
+}
+
+struct Header {
+    char prefix[3];
+    BL_info info;
+};
+
+/* Bits μιας γραμμής και μέγιστο πλήθος θέσεων ανά κλειδί. */
+#define BL_LINE_BITS (BL_LINE_BYTES * 8)
+#define BL_MAX_HASHES 16
+
+static char BL_PREFIX[3] = "BL";
+static int BL_ERROR = -1;
+
+static void assignMagicWord(struct Header * header) {
+    strncpy(header->prefix, BL_PREFIX, strlen(BL_PREFIX) + 1);
+}
+
+static double power(double x, long long n) {
+    double result = 1;
+    for (; n > 0; n >>= 1, x *= x) {
+        if (n & 1) {
+            result *= x;
+        }
+    }
+    return result;
+}
+
+/*
+ * Πιθανότητα λάθους θετικού όταν κάθε κλειδί πιάνει bits_per_key bits και
+ * hashes θέσεις μέσα σε μία γραμμή. Οι γραμμές δεν γεμίζουν ομοιόμορφα:
+ * το πλήθος κλειδιών μιας γραμμής ακολουθεί κατανομή Poisson με μέσο όρο
+ * lambda, οπότε η πιθανότητα είναι ο μέσος όρος της πιθανότητας μιας
+ * γραμμής με j κλειδιά. Τα βάρη της Poisson υπολογίζονται από την κορυφή
+ * της προς τα έξω και κανονικοποιούνται στο τέλος.
+ */
+static double lineFpRate(double bits_per_key, int hashes) {
+    const double lambda = BL_LINE_BITS / bits_per_key;
+    const double keep = power(1.0 - 1.0 / BL_LINE_BITS, hashes);
+    const long long mode = (long long) lambda;
+    double weights = 0, rate = 0;
+
+    double weight = 1;
+    for (long long j = mode; weight > 1e-12; j++) {
+        weights += weight;
+        rate += weight * power(1.0 - power(keep, j), hashes);
+        weight *= lambda / (j + 1);
+    }
+    weight = 1;
+    for (long long j = mode - 1; j >= 0 && weight > 1e-12; j--) {
+        weight *= (j + 1) / lambda;
+        weights += weight;
+        rate += weight * power(1.0 - power(keep, j), hashes);
+    }
+    return rate / weights;
+}
+
+/* Τα λιγότερα bits ανά κλειδί, σε βήματα του μισού bit, και οι θέσεις
+ * ανά κλειδί που δίνουν πιθανότητα λάθους θετικού το πολύ fp_rate. */
+static void assignShape(struct Header * header, int expected, double fp_rate) {
+    double bits_per_key = 1;
+    int hashes = 1;
+
+    for (; bits_per_key < 64; bits_per_key += 0.5) {
+        double best = 1;
+        for (int k = 1; k <= BL_MAX_HASHES; k++) {
+            double rate = lineFpRate(bits_per_key, k);
+            if (rate < best) {
+                best = rate;
+                hashes = k;
+            }
+        }
+        if (best <= fp_rate) {
+            break;
+        }
+    }
+
+    long long lines = ((long long) expected * bits_per_key + BL_LINE_BITS - 1) / BL_LINE_BITS;
+    header->info.lines = lines > 0 ? (int) lines : 1;
+    header->info.hashes = hashes;
+}
+
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
+    BF_Block *block = NULL;
+    BF_Block_InitInPlace(handle, &block);
+    return block;
+}
+
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, BL_ERROR);
+    return BF_OK;
+}
+
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, BL_ERROR);
+    return BF_OK;
+}
+
+/*
+ * Το κλειδί key του φίλτρου filter: τα υψηλά 32 bit του hash διαλέγουν
+ * την γραμμή, που βρίσκεται στο block που επιστρέφεται και στην θέση
+ * *line μέσα του, και ένα δεύτερο hash δίνει τα a και b των θέσεων
+ * a + i * b μέσα στην γραμμή.
+ */
+static int locate(struct Header * header, int filter, int key, int * line, uint32_t * a, uint32_t * b) {
+    const int per_block = header->info.block_size / BL_LINE_BYTES;
+    const uint64_t hash = mix((uint32_t) key);
+    const uint64_t second = mix(hash);
+    long long global = (long long) filter * header->info.lines
+            + (long long) (((hash >> 32) * (uint64_t) header->info.lines) >> 32);
+
+    *line = (int) (global % per_block);
+    *a = (uint32_t) second;
+    *b = (uint32_t) (second >> 32) | 1;
+    return 1 + (int) (global / per_block);
+}
+
+int BL_CreateFile(char *fileName, int filters, int expected, double fp_rate) {
+    const int METHOD_ERROR_CODE = BL_ERROR;
+    struct Header header = {0};
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    if (filters < 1 || expected < 0 || !(fp_rate > 0 && fp_rate < 1)) {
+        fprintf(stderr, "ERROR: Invalid bloom filter: filters %d, expected %d, fp rate %f \n", filters, expected, fp_rate);
+        return METHOD_ERROR_CODE;
+    }
+
+    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    assignMagicWord(&header);
+    header.info.block_size = block_size;
+    header.info.filters = filters;
+    assignShape(&header, expected, fp_rate);
+
+    CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy(data, &header, sizeof (struct Header));
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    const int per_block = block_size / BL_LINE_BYTES;
+    long long blocks = ((long long) filters * header.info.lines + per_block - 1) / per_block;
+    for (long long b = 0; b < blocks; b++) {
+        CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
+        memset(BF_Block_GetData(block), 0, block_size);
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+    }
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    return 0;
+}
+
+BL_info* BL_OpenFile(char *fileName) {
+    static BL_info * METHOD_ERROR_CODE = NULL;
+    struct Header * header = calloc(1, sizeof (struct Header));
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy((void*) header, data, sizeof (struct Header));
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+
+    header->info.fd = fd1;
+
+    if (strncmp(header->prefix, "BL", 2) != 0) {
+        fprintf(stderr, "ERROR: Invalid MAGIC word :%s \n", header->prefix); \
+        return NULL;
+    }
+
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    return (BL_info*) header;
+}
+
+int BL_CloseFile(BL_info* bl_info) {
+    const int METHOD_ERROR_CODE = BL_ERROR;
+    struct Header * header = (struct Header *) bl_info;
+
+    CALL_BF(BF_CloseFile(header->info.fd), true, METHOD_ERROR_CODE);
+    free(header);
+    return 0;
+}
+
+int BL_Add(BL_info* bl_info, int filter, int key) {
+    const int METHOD_ERROR_CODE = BL_ERROR;
+    struct Header * header = (struct Header *) bl_info;
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int line;
+    uint32_t a, b;
+
+    int block_num = locate(header, filter, key, &line, &a, &b);
+    CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, METHOD_ERROR_CODE);
+    unsigned char * bits = (unsigned char *) BF_Block_GetData(block) + line * BL_LINE_BYTES;
+
+    bool changed = false;
+    for (int i = 0; i < header->info.hashes; i++) {
+        uint32_t bit = (a + i * b) % BL_LINE_BITS;
+        unsigned char mask = 1u << (bit % 8);
+        changed |= (bits[bit / 8] & mask) == 0;
+        bits[bit / 8] |= mask;
+    }
+
+    if (changed) {
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+    } else {
+        CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+    }
+    return 0;
+}
+
+int BL_MayContain(BL_info* bl_info, int filter, int key) {
+    const int METHOD_ERROR_CODE = BL_ERROR;
+    struct Header * header = (struct Header *) bl_info;
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int line;
+    uint32_t a, b;
+
+    int block_num = locate(header, filter, key, &line, &a, &b);
+    CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, METHOD_ERROR_CODE);
+    const unsigned char * bits = (const unsigned char *) BF_Block_GetData(block) + line * BL_LINE_BYTES;
+
+    int found = 1;
+    for (int i = 0; i < header->info.hashes && found; i++) {
+        uint32_t bit = (a + i * b) % BL_LINE_BITS;
+        found = (bits[bit / 8] >> (bit % 8)) & 1;
+    }
+
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+    return found;
+}
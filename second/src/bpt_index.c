@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "bf.h"
+#include "bpt_index.h"
+#include "record.h"
+
+static int bpt_errors = 0;
+
+#define CALL_BF(call, printError, error_code)       \
+{                           \
+  BF_ErrorCode code = call; \
+  if (code != BF_OK) {         \
+    if (printError) {\
+        bpt_errors++; \
+        BF_PrintError(code);    \
+        fprintf(stderr, "code: %d \n", code); \
+    }\
+    return error_code;\
+  } \
+}
+
+struct Header {
+    char prefix[3];
+    BPT_info info;
+};
+
+/*
+ * Κάθε κόμβος ξεκινάει με την BPT_node. Ένα φύλλο έχει μετά count εγγραφές
+ * ταξινομημένες κατά id και στο next τον αριθμό του επόμενου φύλλου (-1
+ * στο τελευταίο). Ένας εσωτερικός κόμβος έχει inner_capacity θέσεις για
+ * κλειδιά και μετά inner_capacity + 1 θέσεις για παιδιά: το παιδί i έχει
+ * id από keys[i - 1] έως keys[i]. Με ίσα id ένα κλειδί μπορεί να υπάρχει
+ * και στα δύο παιδιά γύρω του, οπότε οι αναζητήσεις κατεβαίνουν στο πιο
+ * αριστερό και συνεχίζουν στα επόμενα φύλλα.
+ */
+typedef struct {
+    int leaf;
+    int count;
+    int next;
+} BPT_node;
+
+/* Μέγιστο ύψος του δέντρου, για τον δρόμο από την ρίζα στις εισαγωγές. */
+#define BPT_MAX_HEIGHT 32
+
+/* Μέγεθος και στοίχιση του buffer της BPT_BulkLoad. */
+#define BPT_BULK_BYTES (1 << 20)
+#define BPT_BULK_ALIGN 4096
+
+static char BPT_PREFIX[3] = "BP";
+static int BPT_ERROR = -1;
+
+static void assignMagicWord(struct Header * header) {
+    strncpy(header->prefix, BPT_PREFIX, strlen(BPT_PREFIX) + 1);
+}
+
+static void assignBlockSize(struct Header * header, int block_size) {
+    header->info.block_size = block_size;
+}
+
+static void assignCapacities(struct Header * header) {
+    header->info.leaf_capacity = (header->info.block_size - sizeof (BPT_node)) / sizeof (Record);
+    header->info.inner_capacity = (header->info.block_size - sizeof (BPT_node) - sizeof (int)) / (2 * sizeof (int));
+}
+
+static void assignRoot(struct Header * header) {
+    header->info.root = -1;
+    header->info.height = 0;
+}
+
+static BPT_node * node(char * data) {
+    return (BPT_node *) data;
+}
+
+static Record * leafRecords(char * data) {
+    return (Record *) (data + sizeof (BPT_node));
+}
+
+static int * innerKeys(char * data) {
+    return (int *) (data + sizeof (BPT_node));
+}
+
+static int * innerChildren(struct Header * header, char * data) {
+    return innerKeys(data) + header->info.inner_capacity;
+}
+
+/* Η πρώτη θέση με κλειδί >= value (upper false) ή > value (upper true). */
+static int keyBound(const int * keys, int count, int value, bool upper) {
+    int left = 0, right = count;
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (keys[mid] < value || (upper && keys[mid] == value)) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+static int recordBound(const Record * records, int count, int value, bool upper) {
+    int left = 0, right = count;
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (records[mid].id < value || (upper && records[mid].id == value)) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
+    BF_Block *block = NULL;
+    BF_Block_InitInPlace(handle, &block);
+    return block;
+}
+
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, BPT_ERROR);
+    return BF_OK;
+}
+
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, BPT_ERROR);
+    return BF_OK;
+}
+
+/* Δεσμεύει έναν νέο κόμβο, καρφιτσωμένο και μηδενισμένο. */
+static int allocateNode(struct Header * header, BF_Block * block, int * block_num, bool leaf) {
+    CALL_BF(BF_AllocateBlockEx(header->info.fd, block, block_num), true, BPT_ERROR);
+    char * data = BF_Block_GetData(block);
+    memset(data, 0, header->info.block_size);
+    node(data)->leaf = leaf;
+    node(data)->next = -1;
+    header->info.nodes++;
+    return BF_OK;
+}
+
+/* Με ενεργό ημερολόγιο η επικεφαλίδα γράφεται στο block 0 μετά από κάθε
+ * εισαγωγή, ώστε η εισαγωγή να καταγράφεται ολόκληρη στο BF_Commit. */
+static int commitInsert(struct Header * header) {
+    if (!BF_LogActive()) {
+        return BF_OK;
+    }
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(header->info.fd, 0, block), true, BPT_ERROR);
+    memcpy(BF_Block_GetData(block), (void*) header, sizeof (struct Header));
+    CALL_BF(flushBlock(block), true, BPT_ERROR);
+    CALL_BF(BF_Commit(), true, BPT_ERROR);
+    return BF_OK;
+}
+
+int BPT_CreateFile(char *fileName) {
+    const int METHOD_ERROR_CODE = BPT_ERROR;
+    struct Header header = {0};
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    assignMagicWord(&header);
+    assignBlockSize(&header, block_size);
+    assignCapacities(&header);
+    assignRoot(&header);
+
+    CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
+
+    char * data = BF_Block_GetData(block);
+    memcpy(data, &header, sizeof (struct Header));
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    return 0;
+}
+
+BPT_info* BPT_OpenFile(char *fileName) {
+    static BPT_info * METHOD_ERROR_CODE = NULL;
+    struct Header * header = calloc(1, sizeof (struct Header));
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy((void*) header, data, sizeof (struct Header));
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+
+    header->info.fd = fd1;
+
+    fprintf(stderr, "BPT File opened: fd:%d, leaf capacity: %d, inner capacity: %d \n",
+            header->info.fd, header->info.leaf_capacity, header->info.inner_capacity); \
+
+    if (strncmp(header->prefix, "BP", 2) != 0) {
+        fprintf(stderr, "ERROR: Invalid MAGIC word :%s \n", header->prefix); \
+        return NULL;
+    }
+
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    return (BPT_info*) header;
+}
+
+int BPT_CloseFile(BPT_info* bpt_info) {
+    const int METHOD_ERROR_CODE = BPT_ERROR;
+    struct Header * header = (struct Header *) bpt_info;
+    int fd1 = header->info.fd;
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy(data, (void*) header, sizeof (struct Header));
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    free(header);
+
+    printf("\nBPT File closed, BPT_ERRORS: %d \n", bpt_errors); \
+
+    return 0;
+}
+
+/* Εισάγει το κλειδί key με δεξί παιδί το right στους κόμβους του path,
+ * από τον πατέρα του κόμβου που χωρίστηκε προς την ρίζα. Το slots[i] είναι
+ * η θέση του παιδιού από το οποίο κατέβηκε η εισαγωγή στον κόμβο path[i]:
+ * το κλειδί μπαίνει εκεί και το right αμέσως μετά, χωρίς αναζήτηση, γιατί
+ * με ίσα id η αναζήτηση μπορεί να βάλει το right δίπλα σε άλλο παιδί από
+ * αυτό που χωρίστηκε και να χαλάσει την σειρά των φύλλων. Όταν χωρίζεται
+ * και η ρίζα δημιουργείται νέα ρίζα και το δέντρο ψηλώνει. */
+static int insertParent(struct Header * header, const int * path, const int * slots, int depth, int key, int right) {
+    const int capacity = header->info.inner_capacity;
+    BF_BlockHandle left_handle, right_handle;
+    BF_Block *left = allocateMemoryBlock(&left_handle);
+    BF_Block *sibling = allocateMemoryBlock(&right_handle);
+
+    while (depth > 0) {
+        depth--;
+        CALL_BF(BF_GetBlock(header->info.fd, path[depth], left), true, BPT_ERROR);
+        char * data = BF_Block_GetData(left);
+        int * keys = innerKeys(data);
+        int * children = innerChildren(header, data);
+        const int count = node(data)->count;
+        const int pos = slots[depth];
+
+        if (count < capacity) {
+            memmove(keys + pos + 1, keys + pos, (count - pos) * sizeof (int));
+            memmove(children + pos + 2, children + pos + 1, (count - pos) * sizeof (int));
+            keys[pos] = key;
+            children[pos + 1] = right;
+            node(data)->count++;
+            CALL_BF(flushBlock(left), true, BPT_ERROR);
+            return BF_OK;
+        }
+
+        /* Ο κόμβος χωρίζεται: τα capacity + 1 κλειδιά μοιράζονται στα δύο
+         * και το μεσαίο ανεβαίνει στον πατέρα. */
+        int all_keys[capacity + 1], all_children[capacity + 2];
+        memcpy(all_keys, keys, pos * sizeof (int));
+        all_keys[pos] = key;
+        memcpy(all_keys + pos + 1, keys + pos, (count - pos) * sizeof (int));
+        memcpy(all_children, children, (pos + 1) * sizeof (int));
+        all_children[pos + 1] = right;
+        memcpy(all_children + pos + 2, children + pos + 1, (count - pos) * sizeof (int));
+
+        const int mid = (capacity + 1) / 2;
+        int sibling_num;
+        if (allocateNode(header, sibling, &sibling_num, false) != BF_OK) {
+            dumpBlock(left);
+            return BPT_ERROR;
+        }
+        char * sibling_data = BF_Block_GetData(sibling);
+
+        node(data)->count = mid;
+        memcpy(keys, all_keys, mid * sizeof (int));
+        memcpy(children, all_children, (mid + 1) * sizeof (int));
+        node(sibling_data)->count = capacity - mid;
+        memcpy(innerKeys(sibling_data), all_keys + mid + 1, (capacity - mid) * sizeof (int));
+        memcpy(innerChildren(header, sibling_data), all_children + mid + 1, (capacity - mid + 1) * sizeof (int));
+
+        CALL_BF(flushBlock(left), true, BPT_ERROR);
+        CALL_BF(flushBlock(sibling), true, BPT_ERROR);
+        key = all_keys[mid];
+        right = sibling_num;
+    }
+
+    int root_num;
+    CALL_BF(allocateNode(header, left, &root_num, false), false, BPT_ERROR);
+    char * data = BF_Block_GetData(left);
+    node(data)->count = 1;
+    innerKeys(data)[0] = key;
+    innerChildren(header, data)[0] = header->info.root;
+    innerChildren(header, data)[1] = right;
+    CALL_BF(flushBlock(left), true, BPT_ERROR);
+
+    header->info.root = root_num;
+    header->info.height++;
+    return BF_OK;
+}
+
+/* Εισαγωγή χωρίς εκτύπωση. Επιστρέφει το block της εγγραφής ή -1. */
+static int insertRecord(struct Header * header, const Record * record) {
+    const int capacity = header->info.leaf_capacity;
+    BF_BlockHandle handle, sibling_handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    BF_Block *sibling = allocateMemoryBlock(&sibling_handle);
+    int path[BPT_MAX_HEIGHT];
+    int slots[BPT_MAX_HEIGHT];
+    int depth = 0;
+
+    if (header->info.root == -1) {
+        int root_num;
+        CALL_BF(allocateNode(header, block, &root_num, true), false, BPT_ERROR);
+        char * data = BF_Block_GetData(block);
+        leafRecords(data)[0] = *record;
+        node(data)->count = 1;
+        CALL_BF(flushBlock(block), true, BPT_ERROR);
+        header->info.root = root_num;
+        header->info.height = 1;
+        return root_num;
+    }
+
+    int block_num = header->info.root;
+    for (int level = header->info.height; level > 1; level--) {
+        CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, BPT_ERROR);
+        char * data = BF_Block_GetData(block);
+        const int slot = keyBound(innerKeys(data), node(data)->count, record->id, true);
+        int child = innerChildren(header, data)[slot];
+        path[depth] = block_num;
+        slots[depth++] = slot;
+        CALL_BF(dumpBlock(block), true, BPT_ERROR);
+        block_num = child;
+    }
+
+    CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, BPT_ERROR);
+    char * data = BF_Block_GetData(block);
+    Record * records = leafRecords(data);
+    const int count = node(data)->count;
+    const int pos = recordBound(records, count, record->id, true);
+
+    if (count < capacity) {
+        memmove(records + pos + 1, records + pos, (count - pos) * sizeof (Record));
+        records[pos] = *record;
+        node(data)->count++;
+        CALL_BF(flushBlock(block), true, BPT_ERROR);
+        return block_num;
+    }
+
+    /* Το φύλλο χωρίζεται: το αριστερό κρατάει τις πρώτες (capacity + 1) / 2
+     * εγγραφές και το νέο δεξί τις υπόλοιπες. */
+    int sibling_num;
+    if (allocateNode(header, sibling, &sibling_num, true) != BF_OK) {
+        dumpBlock(block);
+        return BPT_ERROR;
+    }
+    char * sibling_data = BF_Block_GetData(sibling);
+    Record * sibling_records = leafRecords(sibling_data);
+    const int mid = (capacity + 1) / 2;
+    int result_num;
+
+    if (pos < mid) {
+        memcpy(sibling_records, records + mid - 1, (capacity - mid + 1) * sizeof (Record));
+        memmove(records + pos + 1, records + pos, (mid - 1 - pos) * sizeof (Record));
+        records[pos] = *record;
+        result_num = block_num;
+    } else {
+        memcpy(sibling_records, records + mid, (pos - mid) * sizeof (Record));
+        sibling_records[pos - mid] = *record;
+        memcpy(sibling_records + pos - mid + 1, records + pos, (capacity - pos) * sizeof (Record));
+        result_num = sibling_num;
+    }
+    node(data)->count = mid;
+    node(sibling_data)->count = capacity + 1 - mid;
+    node(sibling_data)->next = node(data)->next;
+    node(data)->next = sibling_num;
+    const int key = sibling_records[0].id;
+
+    CALL_BF(flushBlock(block), true, BPT_ERROR);
+    CALL_BF(flushBlock(sibling), true, BPT_ERROR);
+    if (depth >= BPT_MAX_HEIGHT - 1 || insertParent(header, path, slots, depth, key, sibling_num) != BF_OK) {
+        return BPT_ERROR;
+    }
+    return result_num;
+}
+
+int BPT_InsertEntry(BPT_info* bpt_info, Record record) {
+    const int METHOD_ERROR_CODE = BPT_ERROR;
+    struct Header * header = (struct Header *) bpt_info;
+
+    int block_num = insertRecord(header, &record);
+    if (block_num < 0) {
+        return METHOD_ERROR_CODE;
+    }
+
+    printf("Inserted: ");
+    printRecord(record);
+
+    header->info.records++;
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
+
+    return block_num;
+}
+
+/* Γράφει στο τέλος του αρχείου τους count κόμβους του buffer. Ο πρώτος
+ * πρέπει να πάρει τον αριθμό expected, που έχουν ήδη χρησιμοποιήσει οι
+ * δείκτες των κόμβων. */
+static int appendNodes(struct Header * header, const char * buffer, int count, int expected) {
+    int first;
+    CALL_BF(BF_AppendBlocks(header->info.fd, buffer, count, &first), true, BPT_ERROR);
+    header->info.nodes += count;
+    return first == expected ? BF_OK : BPT_ERROR;
+}
+
+int BPT_BulkLoad(BPT_info* bpt_info, const Record *records, size_t n) {
+    const int METHOD_ERROR_CODE = BPT_ERROR;
+    struct Header * header = (struct Header *) bpt_info;
+    const size_t block_size = header->info.block_size;
+
+    if (header->info.root != -1) {
+        for (size_t k = 0; k < n; k++) {
+            if (insertRecord(header, &records[k]) < 0) {
+                return METHOD_ERROR_CODE;
+            }
+            header->info.records++;
+        }
+        CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
+        return 0;
+    }
+    for (size_t k = 1; k < n; k++) {
+        if (records[k - 1].id > records[k].id) {
+            fprintf(stderr, "ERROR: BPT_BulkLoad input is not sorted at %zu \n", k);
+            return METHOD_ERROR_CODE;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Για κάθε κόμβο του τρέχοντος επιπέδου το μικρότερο id του και ο
+     * αριθμός του block του. */
+    const int leaf_capacity = header->info.leaf_capacity;
+    int count = (int) ((n + leaf_capacity - 1) / leaf_capacity);
+    int * keys = malloc(sizeof (int) * count);
+    int * blocks = malloc(sizeof (int) * count);
+    size_t batch = BPT_BULK_BYTES / block_size > 0 ? BPT_BULK_BYTES / block_size : 1;
+    char * buffer = NULL;
+    int next_block;
+    int result = BF_GetBlockCounter(header->info.fd, &next_block);
+
+    if (keys == NULL || blocks == NULL || posix_memalign((void **) &buffer, BPT_BULK_ALIGN, batch * block_size) != 0) {
+        result = BPT_ERROR;
+    }
+
+    /* Φύλλα. */
+    for (int leaf = 0; leaf < count && result == BF_OK; ) {
+        int filled = 0;
+        memset(buffer, 0, batch * block_size);
+        for (; filled < (int) batch && leaf < count; filled++, leaf++) {
+            char * data = buffer + filled * block_size;
+            size_t first = (size_t) leaf * leaf_capacity;
+            int in_leaf = n - first < (size_t) leaf_capacity ? (int) (n - first) : leaf_capacity;
+            node(data)->leaf = true;
+            node(data)->count = in_leaf;
+            node(data)->next = leaf + 1 < count ? next_block + leaf + 1 : -1;
+            memcpy(leafRecords(data), records + first, in_leaf * sizeof (Record));
+            keys[leaf] = records[first].id;
+            blocks[leaf] = next_block + leaf;
+        }
+        result = appendNodes(header, buffer, filled, next_block + leaf - filled);
+    }
+    next_block += count;
+    header->info.height = 1;
+
+    /* Εσωτερικά επίπεδα: τα παιδιά μοιράζονται ομοιόμορφα, ώστε κάθε
+     * κόμβος να έχει τουλάχιστον δύο. */
+    const int fan_out = header->info.inner_capacity + 1;
+    while (count > 1 && result == BF_OK) {
+        int parents = (count + fan_out - 1) / fan_out;
+        int child = 0;
+        for (int parent = 0; parent < parents && result == BF_OK; ) {
+            int filled = 0;
+            memset(buffer, 0, batch * block_size);
+            for (; filled < (int) batch && parent < parents; filled++, parent++) {
+                char * data = buffer + filled * block_size;
+                int children = count / parents + (parent < count % parents ? 1 : 0);
+                node(data)->leaf = false;
+                node(data)->count = children - 1;
+                node(data)->next = -1;
+                for (int c = 0; c < children; c++) {
+                    innerChildren(header, data)[c] = blocks[child + c];
+                    if (c > 0) {
+                        innerKeys(data)[c - 1] = keys[child + c];
+                    }
+                }
+                keys[parent] = keys[child];
+                blocks[parent] = next_block + parent;
+                child += children;
+            }
+            result = appendNodes(header, buffer, filled, next_block + parent - filled);
+        }
+        next_block += parents;
+        count = parents;
+        header->info.height++;
+    }
+
+    if (result == BF_OK) {
+        header->info.root = blocks[0];
+        header->info.records += n;
+    }
+    free(buffer);
+    free(blocks);
+    free(keys);
+    CALL_BF(result, false, METHOD_ERROR_CODE);
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
+    return 0;
+}
+
+/*
+ * Η σάρωση κατεβαίνει από την ρίζα στο πιο αριστερό φύλλο που μπορεί να
+ * έχει id >= low και ακολουθεί τα επόμενα φύλλα έως το πρώτο id > high.
+ * Μόνο το τρέχον φύλλο μένει καρφιτσωμένο.
+ */
+struct BPT_Scan {
+    struct Header * header;
+    int high;
+    int slot;
+    int blocks_read;
+    bool pinned;
+    bool done;
+    bool error;
+    BF_BlockHandle handle;
+    BF_Block *block;
+};
+
+BPT_Scan* BPT_ScanOpenRange(BPT_info* bpt_info, int low, int high) {
+    struct Header * header = (struct Header *) bpt_info;
+    BPT_Scan * scan = calloc(1, sizeof (BPT_Scan));
+    if (scan == NULL) {
+        return NULL;
+    }
+
+    scan->header = header;
+    scan->high = high;
+    scan->block = allocateMemoryBlock(&scan->handle);
+    scan->done = header->info.root == -1 || low > high;
+
+    int block_num = header->info.root;
+    for (int level = header->info.height; level > 0 && !scan->done; level--) {
+        if (BF_GetBlock(header->info.fd, block_num, scan->block) != BF_OK) {
+            free(scan);
+            return NULL;
+        }
+        scan->pinned = true;
+        scan->blocks_read++;
+        char * data = BF_Block_GetData(scan->block);
+        if (node(data)->leaf) {
+            scan->slot = recordBound(leafRecords(data), node(data)->count, low, false);
+            break;
+        }
+        block_num = innerChildren(header, data)[keyBound(innerKeys(data), node(data)->count, low, false)];
+        scan->pinned = false;
+        if (dumpBlock(scan->block) != BF_OK) {
+            free(scan);
+            return NULL;
+        }
+    }
+    return scan;
+}
+
+const Record* BPT_ScanNext(BPT_Scan* scan) {
+    while (!scan->done && !scan->error) {
+        char * data = BF_Block_GetData(scan->block);
+        if (scan->slot < node(data)->count) {
+            const Record * record = &leafRecords(data)[scan->slot++];
+            if (record->id <= scan->high) {
+                return record;
+            }
+            scan->done = true;
+            break;
+        }
+
+        int next = node(data)->next;
+        scan->pinned = false;
+        if (dumpBlock(scan->block) != BF_OK) {
+            scan->error = true;
+            break;
+        }
+        if (next == -1) {
+            scan->done = true;
+            break;
+        }
+        if (BF_GetBlock(scan->header->info.fd, next, scan->block) != BF_OK) {
+            scan->error = true;
+            break;
+        }
+        scan->pinned = true;
+        scan->blocks_read++;
+        scan->slot = 0;
+    }
+    return NULL;
+}
+
+int BPT_ScanClose(BPT_Scan* scan) {
+    if (scan->pinned && dumpBlock(scan->block) != BF_OK) {
+        scan->error = true;
+    }
+
+    int blocks = scan->error ? BPT_ERROR : scan->blocks_read;
+    free(scan);
+    return blocks;
+}
+
+int BPT_GetAllEntries(BPT_info* bpt_info, int value) {
+    BPT_Scan * scan = BPT_ScanOpenRange(bpt_info, value, value);
+    if (scan == NULL) {
+        return BPT_ERROR;
+    }
+
+    const Record * record;
+    while ((record = BPT_ScanNext(scan)) != NULL) {
+        printRecord(*record);
+    }
+    return BPT_ScanClose(scan);
+}
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bf.h"
+#include "dictionary.h"
+#include "record.h"
+
+static int dc_errors = 0;
+
+#define CALL_BF(call, printError, error_code)       \
+{                           \
+  BF_ErrorCode code = call; \
+  if (code != BF_OK) {         \
+    if (printError) {\
+        dc_errors++; \
+        BF_PrintError(code);    \
+        fprintf(stderr, "code: %d \n", code); \
+    }\
+    return error_code;\
+  } \
+}
+
+#define DC_ATTRIBUTES 3
+
+/* Στο block 0 αποθηκεύονται τα πρώτα DC_HEADER_BYTES. Οι τιμές κάθε
+ * πεδίου κρατιούνται στην μνήμη σε σειρά κωδικού όσο το λεξικό είναι
+ * ανοιχτό, μαζί με έναν πίνακα κατακερματισμού από την τιμή στον κωδικό
+ * της (κωδικός + 1, 0 για κενή θέση) με γραμμική διερεύνηση. Ο πίνακας
+ * έχει πάντα τουλάχιστον διπλάσιες θέσεις από τις τιμές. */
+struct Header {
+    char prefix[3];
+    DC_info info;
+    int counts[DC_ATTRIBUTES];
+    int capacity[DC_ATTRIBUTES];
+    char (*values[DC_ATTRIBUTES])[DC_VALUE_SIZE];
+    int slot_count[DC_ATTRIBUTES];
+    int * slots[DC_ATTRIBUTES];
+};
+
+#define DC_HEADER_BYTES offsetof(struct Header, counts)
+
+/* Οι τιμές γράφονται με την σειρά που προστέθηκαν από το block 1 και μετά.
+ * Το attribute μιας θέσης που δεν έχει γραφτεί είναι 0 (ID), αφού η
+ * BF_AllocateBlock μηδενίζει το block. */
+typedef struct {
+    int attribute;
+    char value[DC_VALUE_SIZE];
+} DC_entry;
+
+static char DC_PREFIX[3] = "DC";
+static int DC_ERROR = -1;
+
+static void assignMagicWord(struct Header * header) {
+    strncpy(header->prefix, DC_PREFIX, strlen(DC_PREFIX) + 1);
+}
+
+static int entriesPerBlock(struct Header * header) {
+    return header->info.block_size / sizeof (DC_entry);
+}
+
+/* Θέση του πεδίου attribute στους πίνακες της επικεφαλίδας, ή -1. */
+static int attributeIndex(Record_Attribute attribute) {
+    return (attribute >= NAME && attribute <= CITY) ? (int) (attribute - NAME) : -1;
+}
+
+/* Οι τιμές συγκρίνονται ως DC_VALUE_SIZE bytes συμπληρωμένα με '\0'. Το
+ * size είναι το μέγεθος του πεδίου από το οποίο προέρχεται η τιμή, αφού
+ * ένα γεμάτο πεδίο της Record δεν τελειώνει σε '\0'. */
+static void normalize(char key[DC_VALUE_SIZE], const char * value, size_t size) {
+    memset(key, 0, DC_VALUE_SIZE);
+    memcpy(key, value, strnlen(value, size < DC_VALUE_SIZE ? size : DC_VALUE_SIZE));
+}
+
+static unsigned int hashValue(const char key[DC_VALUE_SIZE]) {
+    unsigned int hash = 5381;
+
+    for (int k = 0; k < DC_VALUE_SIZE; k++) {
+        hash = ((hash << 5) + hash) + (unsigned char) key[k]; /* hash * 33 + c */
+    }
+    return hash;
+}
+
+/* Θέση του πίνακα κατακερματισμού με την τιμή key ή, αν δεν υπάρχει, η
+ * κενή θέση όπου θα μπει. */
+static int findSlot(struct Header * header, int index, const char key[DC_VALUE_SIZE]) {
+    const int mask = header->slot_count[index] - 1;
+    int slot = (int) (hashValue(key) & (unsigned int) mask);
+
+    while (header->slots[index][slot] != 0
+            && memcmp(header->values[index][header->slots[index][slot] - 1], key, DC_VALUE_SIZE) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int find(struct Header * header, int index, const char key[DC_VALUE_SIZE]) {
+    if (header->counts[index] == 0) {
+        return -1;
+    }
+    return header->slots[index][findSlot(header, index, key)] - 1;
+}
+
+/* Ξαναχτίζει τον πίνακα κατακερματισμού του πεδίου με slot_count θέσεις. */
+static int rehash(struct Header * header, int index, int slot_count) {
+    int * slots = calloc((size_t) slot_count, sizeof (int));
+    if (slots == NULL) {
+        return DC_ERROR;
+    }
+    free(header->slots[index]);
+    header->slots[index] = slots;
+    header->slot_count[index] = slot_count;
+    for (int code = 0; code < header->counts[index]; code++) {
+        slots[findSlot(header, index, header->values[index][code])] = code + 1;
+    }
+    return 0;
+}
+
+/* Προσθέτει την τιμή στην μνήμη και επιστρέφει τον κωδικό της. */
+static int remember(struct Header * header, int index, const char key[DC_VALUE_SIZE]) {
+    if (header->counts[index] == header->capacity[index]) {
+        int capacity = header->capacity[index] ? 2 * header->capacity[index] : 16;
+        void * values = realloc(header->values[index], (size_t) capacity * DC_VALUE_SIZE);
+        if (values == NULL) {
+            return DC_ERROR;
+        }
+        header->values[index] = values;
+        header->capacity[index] = capacity;
+    }
+    if (header->slot_count[index] < 2 * header->capacity[index]
+            && rehash(header, index, 2 * header->capacity[index]) < 0) {
+        return DC_ERROR;
+    }
+    const int code = header->counts[index];
+    memcpy(header->values[index][code], key, DC_VALUE_SIZE);
+    header->slots[index][findSlot(header, index, key)] = code + 1;
+    return header->counts[index]++;
+}
+
+/* Αφαιρεί την τελευταία τιμή που πρόσθεσε η remember. Καμία άλλη τιμή δεν
+ * πέρασε από την θέση της στην διερεύνηση, οπότε αρκεί να αδειάσει. */
+static void forget(struct Header * header, int index) {
+    const int code = header->counts[index] - 1;
+    header->slots[index][findSlot(header, index, header->values[index][code])] = 0;
+    header->counts[index] = code;
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
+    BF_Block *block = NULL;
+    BF_Block_InitInPlace(handle, &block);
+    return block;
+}
+
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, DC_ERROR);
+    return BF_OK;
+}
+
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, DC_ERROR);
+    return BF_OK;
+}
+
+/* Γράφει την νέα τιμή στο αρχείο, σε νέο block αν το τελευταίο γέμισε. */
+static int append(struct Header * header, int index, const char key[DC_VALUE_SIZE]) {
+    const int per_block = entriesPerBlock(header);
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    if (header->info.entries % per_block == 0) {
+        CALL_BF(BF_AllocateBlock(header->info.fd, block), true, DC_ERROR);
+    } else {
+        CALL_BF(BF_GetBlock(header->info.fd, 1 + header->info.entries / per_block, block), true, DC_ERROR);
+    }
+
+    DC_entry * entry = (DC_entry *) BF_Block_GetData(block) + header->info.entries % per_block;
+    entry->attribute = NAME + index;
+    memcpy(entry->value, key, DC_VALUE_SIZE);
+    CALL_BF(flushBlock(block), true, DC_ERROR);
+
+    header->info.entries++;
+    return BF_OK;
+}
+
+static int encode(struct Header * header, Record_Attribute attribute, const char * value, size_t size) {
+    const int index = attributeIndex(attribute);
+    char key[DC_VALUE_SIZE];
+
+    if (index < 0) {
+        return DC_ERROR;
+    }
+    normalize(key, value, size);
+
+    int code = find(header, index, key);
+    if (code >= 0) {
+        return code;
+    }
+    if (header->counts[index] == DC_MAX_CODES) {
+        fprintf(stderr, "ERROR: Dictionary full for attribute %d \n", attribute);
+        return DC_ERROR;
+    }
+    code = remember(header, index, key);
+    if (code < 0) {
+        return DC_ERROR;
+    }
+    if (append(header, index, key) != BF_OK) {
+        forget(header, index);
+        return DC_ERROR;
+    }
+    return code;
+}
+
+int DC_CreateFile(char *fileName) {
+    const int METHOD_ERROR_CODE = DC_ERROR;
+    struct Header header = {0};
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    assignMagicWord(&header);
+    header.info.block_size = block_size;
+
+    CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy(data, &header, DC_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    return 0;
+}
+
+DC_info* DC_OpenFile(char *fileName) {
+    static DC_info * METHOD_ERROR_CODE = NULL;
+    struct Header * header = calloc(1, sizeof (struct Header));
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+    int blocks;
+
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy((void*) header, data, DC_HEADER_BYTES);
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+
+    header->info.fd = fd1;
+    header->info.entries = 0;
+
+    if (strncmp(header->prefix, "DC", 2) != 0) {
+        fprintf(stderr, "ERROR: Invalid MAGIC word :%s \n", header->prefix); \
+        return NULL;
+    }
+
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    /* Οι κωδικοί προκύπτουν από την σειρά των τιμών στο αρχείο. */
+    CALL_BF(BF_GetBlockCounter(fd1, &blocks), true, METHOD_ERROR_CODE);
+    for (int b = 1; b < blocks; b++) {
+        CALL_BF(BF_GetBlock(fd1, b, block), true, METHOD_ERROR_CODE);
+        const DC_entry * entries = (const DC_entry *) BF_Block_GetData(block);
+        for (int k = 0; k < entriesPerBlock(header); k++) {
+            const int index = attributeIndex(entries[k].attribute);
+            if (index < 0) {
+                break;
+            }
+            if (remember(header, index, entries[k].value) < 0) {
+                dumpBlock(block);
+                return NULL;
+            }
+            header->info.entries++;
+        }
+        CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+    }
+
+    return (DC_info*) header;
+}
+
+int DC_CloseFile(DC_info* dc_info) {
+    const int METHOD_ERROR_CODE = DC_ERROR;
+    struct Header * header = (struct Header *) dc_info;
+
+    CALL_BF(BF_CloseFile(header->info.fd), true, METHOD_ERROR_CODE);
+    for (int k = 0; k < DC_ATTRIBUTES; k++) {
+        free(header->values[k]);
+        free(header->slots[k]);
+    }
+    free(header);
+    return 0;
+}
+
+int DC_Encode(DC_info* dc_info, Record_Attribute attribute, const char *value) {
+    return encode((struct Header *) dc_info, attribute, value, DC_VALUE_SIZE);
+}
+
+int DC_Lookup(DC_info* dc_info, Record_Attribute attribute, const char *value) {
+    struct Header * header = (struct Header *) dc_info;
+    const int index = attributeIndex(attribute);
+    char key[DC_VALUE_SIZE];
+
+    if (index < 0 || strnlen(value, DC_VALUE_SIZE + 1) > DC_VALUE_SIZE) {
+        return DC_ERROR;
+    }
+    normalize(key, value, DC_VALUE_SIZE);
+    return find(header, index, key);
+}
+
+const char* DC_Decode(DC_info* dc_info, Record_Attribute attribute, int code) {
+    struct Header * header = (struct Header *) dc_info;
+    const int index = attributeIndex(attribute);
+
+    if (index < 0 || code < 0 || code >= header->counts[index]) {
+        return NULL;
+    }
+    return header->values[index][code];
+}
+
+int DC_EncodeRecord(DC_info* dc_info, const Record *record, DC_tuple *tuple) {
+    struct Header * header = (struct Header *) dc_info;
+    int name = encode(header, NAME, record->name, sizeof (record->name));
+    int surname = encode(header, SURNAME, record->surname, sizeof (record->surname));
+    int city = encode(header, CITY, record->city, sizeof (record->city));
+
+    if (name < 0 || surname < 0 || city < 0) {
+        return DC_ERROR;
+    }
+
+    memset(tuple, 0, sizeof (DC_tuple));
+    tuple->id = record->id;
+    tuple->name = (unsigned short) name;
+    tuple->surname = (unsigned short) surname;
+    tuple->city = (unsigned short) city;
+    memcpy(tuple->record, record->record, sizeof (tuple->record));
+    return 0;
+}
+
+void DC_DecodeRecord(DC_info* dc_info, const DC_tuple *tuple, Record *record) {
+    struct Header * header = (struct Header *) dc_info;
+
+    memset(record, 0, sizeof (Record));
+    record->id = tuple->id;
+    memcpy(record->record, tuple->record, sizeof (record->record));
+    memcpy(record->name, header->values[NAME - NAME][tuple->name], sizeof (record->name));
+    memcpy(record->surname, header->values[SURNAME - NAME][tuple->surname], sizeof (record->surname));
+    memcpy(record->city, header->values[CITY - NAME][tuple->city], sizeof (record->city));
+}
+
+int DC_Code(const DC_tuple *tuple, Record_Attribute attribute) {
+    switch (attribute) {
+        case NAME:
+            return tuple->name;
+        case SURNAME:
+            return tuple->surname;
+        case CITY:
+            return tuple->city;
+        default:
+            return DC_ERROR;
+    }
+}
@@ -3,9 +3,18 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "bf.h"
 #include "hp_file.h"
+#include "bloom_filter.h"
+#include "slotted_page.h"
+#include "dictionary.h"
 #include "record.h"
 
 static int hp_errors = 0;
@@ -23,84 +32,486 @@ static int hp_errors = 0;
   } \
 }
 
-union Header {
-    struct {
-        char prefix[3];
-        HP_info info;
-    };
-    char block[BF_BLOCK_SIZE];
+/* Στο block 0 αποθηκεύονται τα πρώτα HP_HEADER_BYTES. Τα υπόλοιπα πεδία
+ * υπάρχουν μόνο όσο το αρχείο είναι ανοιχτό. */
+struct Header {
+    char prefix[3];
+    HP_info info;
+    int zone_fd;
+    struct HP_zone * summary;
+    int summary_count;
+    BL_info * bloom;
+    DC_info * dictionary;
 };
 
+#define HP_HEADER_BYTES offsetof(struct Header, zone_fd)
+
 typedef struct {
     int records;
     int next_block;
 } HP_block_info;
 
+/* Πλήθος block που διαβάζονται μαζί με την BF_GetBlocks στις σαρώσεις. */
+#define HP_BATCH 8
+
+/* Block ανά τμήμα (morsel) της παράλληλης σάρωσης. */
+#define HP_MORSEL 64
+
+/* Μέγεθος και στοίχιση του buffer της HP_BulkInsert. */
+#define HP_BULK_BYTES (1 << 20)
+#define HP_BULK_ALIGN 4096
+
+/* Στην μορφή PAX: bytes ανά εγγραφή και θέση της minipage ενός πεδίου που
+ * ακολουθεί πεδία συνολικού μεγέθους before. */
+#define FIELD_SIZE(field) sizeof(((Record *) 0)->field)
+#define PAX_ROW (sizeof(int) + FIELD_SIZE(record) + FIELD_SIZE(name) + FIELD_SIZE(surname) + FIELD_SIZE(city))
+#define PAX_FIELD(data, density, field, before, slot) \
+    ((data) + (density) * (sizeof(int) + (before)) + (slot) * FIELD_SIZE(field))
+#define PAX_NAME FIELD_SIZE(record)
+#define PAX_SURNAME (PAX_NAME + FIELD_SIZE(name))
+#define PAX_CITY (PAX_SURNAME + FIELD_SIZE(surname))
+
+/*
+ * Χάρτης ζωνών: για κάθε block δεδομένων b το μικρότερο και το μεγαλύτερο
+ * id του, στην θέση b - 1 ενός δεύτερου αρχείου BF με όνομα το όνομα του
+ * σωρού και την κατάληξη HP_ZONE_SUFFIX. Ένα block χωρίς εγγραφές έχει
+ * min > max.
+ */
+typedef struct HP_zone {
+    int min;
+    int max;
+} HP_zone;
+
+#define HP_ZONE_SUFFIX ".zone"
+
+/* Το προαιρετικό φίλτρο Bloom των id βρίσκεται σε αρχείο με όνομα το
+ * όνομα του σωρού και την κατάληξη HP_BLOOM_SUFFIX. */
+#define HP_BLOOM_SUFFIX ".bloom"
+
+/* Το λεξικό των αρχείων HP_LAYOUT_DICT βρίσκεται σε αρχείο με όνομα το
+ * όνομα του σωρού και την κατάληξη HP_DICT_SUFFIX. */
+#define HP_DICT_SUFFIX ".dict"
+
 static char HP_PREFIX[3] = "HP";
 static int HP_ERROR = -1;
 
-static void assignMagicWord(union Header * header) {
+static void assignMagicWord(struct Header * header) {
     strncpy(header->prefix, HP_PREFIX, strlen(HP_PREFIX) + 1);
 }
 
-static void assignDensity(union Header * header) {
-    header->info.density = (BF_BLOCK_SIZE - sizeof(HP_info))/sizeof(Record);
+static void assignBlockSize(struct Header * header, int block_size) {
+    header->info.block_size = block_size;
+}
+
+static void assignLayout(struct Header * header, int layout) {
+    header->info.layout = layout;
 }
 
-static BF_Block * allocateMemoryBlock() {
+static void assignDensity(struct Header * header) {
+    size_t row = (header->info.layout == HP_LAYOUT_PAX) ? PAX_ROW
+            : (header->info.layout == HP_LAYOUT_SLOTTED) ? SP_MAX_TUPLE
+            : (header->info.layout == HP_LAYOUT_DICT) ? sizeof(DC_tuple) : sizeof(Record);
+    header->info.density = (header->info.block_size - sizeof(HP_block_info))/row;
+}
+
+static HP_block_info * blockInfo(struct Header * header, char * data) {
+    return (HP_block_info *)(data + header->info.block_size - sizeof(HP_block_info));
+}
+
+/* Στην μορφή HP_LAYOUT_SLOTTED ο χώρος των εγγραφών και του καταλόγου
+ * θέσεων, πριν από το HP_block_info. */
+static int slottedSpace(struct Header * header) {
+    return header->info.block_size - sizeof(HP_block_info);
+}
+
+/*
+ * Στην μορφή PAX κάθε block χωρίζεται σε minipages, μία για κάθε πεδίο:
+ * πρώτα density ακέραιοι id και μετά τα πεδία record, name, surname και
+ * city κάθε εγγραφής συνεχόμενα. Μια σάρωση στο id διαβάζει μόνο την
+ * πρώτη minipage.
+ */
+static int * paxIds(char * data) {
+    return (int *) data;
+}
+
+/* Στην μορφή HP_LAYOUT_DICT κάθε block έχει density εγγραφές DC_tuple, με
+ * κωδικούς του λεξικού του σωρού στην θέση των name, surname και city. */
+static DC_tuple * dictTuples(char * data) {
+    return (DC_tuple *) data;
+}
+
+static int putRecord(struct Header * header, char * data, int slot, const Record * record) {
+    const size_t d = header->info.density;
+    if (header->info.layout == HP_LAYOUT_DICT) {
+        return DC_EncodeRecord(header->dictionary, record, &dictTuples(data)[slot]) == 0 ? BF_OK : HP_ERROR;
+    }
+    if (header->info.layout != HP_LAYOUT_PAX) {
+        memcpy(data + slot*sizeof(Record), record, sizeof(Record));
+        return BF_OK;
+    }
+    paxIds(data)[slot] = record->id;
+    memcpy(PAX_FIELD(data, d, record, 0, slot), record->record, sizeof(record->record));
+    memcpy(PAX_FIELD(data, d, name, PAX_NAME, slot), record->name, sizeof(record->name));
+    memcpy(PAX_FIELD(data, d, surname, PAX_SURNAME, slot), record->surname, sizeof(record->surname));
+    memcpy(PAX_FIELD(data, d, city, PAX_CITY, slot), record->city, sizeof(record->city));
+    return BF_OK;
+}
+
+static void getRecord(struct Header * header, char * data, int slot, Record * record) {
+    const size_t d = header->info.density;
+    if (header->info.layout == HP_LAYOUT_DICT) {
+        DC_DecodeRecord(header->dictionary, &dictTuples(data)[slot], record);
+        return;
+    }
+    record->id = paxIds(data)[slot];
+    memcpy(record->record, PAX_FIELD(data, d, record, 0, slot), sizeof(record->record));
+    memcpy(record->name, PAX_FIELD(data, d, name, PAX_NAME, slot), sizeof(record->name));
+    memcpy(record->surname, PAX_FIELD(data, d, surname, PAX_SURNAME, slot), sizeof(record->surname));
+    memcpy(record->city, PAX_FIELD(data, d, city, PAX_CITY, slot), sizeof(record->city));
+}
+
+/*
+ * Επιστρέφει την πρώτη θέση από την from και μετά με low <= id <= high, ή
+ * count αν δεν υπάρχει. Με την αφαίρεση του low η σύγκριση γίνεται μία
+ * σύγκριση χωρίς πρόσημο, που στα SIMD γίνεται προσημασμένη μετά από xor
+ * με το bit του προσήμου.
+ */
+static int nextIdScalar(const int * ids, int from, int count, int low, int high) {
+    const unsigned int span = (unsigned int) high - (unsigned int) low;
+    for (int k = from; k < count; k++) {
+        if ((unsigned int) ids[k] - (unsigned int) low <= span) {
+            return k;
+        }
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static int nextIdSse2(const int * ids, int from, int count, int low, int high) {
+    const __m128i sign = _mm_set1_epi32(INT_MIN);
+    const __m128i base = _mm_set1_epi32(low);
+    const __m128i span = _mm_set1_epi32((int) (((unsigned int) high - (unsigned int) low) ^ 0x80000000u));
+    int k = from;
+    for (; k + 4 <= count; k += 4) {
+        __m128i x = _mm_xor_si128(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) (ids + k)), base), sign);
+        int outside = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, span)));
+        if (outside != 0xF) {
+            return k + __builtin_ctz(~outside & 0xF);
+        }
+    }
+    return nextIdScalar(ids, k, count, low, high);
+}
+
+__attribute__((target("avx2")))
+static int nextIdAvx2(const int * ids, int from, int count, int low, int high) {
+    const __m256i sign = _mm256_set1_epi32(INT_MIN);
+    const __m256i base = _mm256_set1_epi32(low);
+    const __m256i span = _mm256_set1_epi32((int) (((unsigned int) high - (unsigned int) low) ^ 0x80000000u));
+    int k = from;
+    for (; k + 8 <= count; k += 8) {
+        __m256i x = _mm256_xor_si256(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) (ids + k)), base), sign);
+        int outside = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, span)));
+        if (outside != 0xFF) {
+            return k + __builtin_ctz(~outside & 0xFF);
+        }
+    }
+    return nextIdSse2(ids, k, count, low, high);
+}
+
+static int nextId(const int * ids, int from, int count, int low, int high) {
+    if (__builtin_cpu_supports("avx2")) {
+        return nextIdAvx2(ids, from, count, low, high);
+    }
+    return nextIdSse2(ids, from, count, low, high);
+}
+#else
+static int nextId(const int * ids, int from, int count, int low, int high) {
+    return nextIdScalar(ids, from, count, low, high);
+}
+#endif
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
     BF_Block *block = NULL;
-    BF_Block_Init(&block);
+    BF_Block_InitInPlace(handle, &block);
     return block;
 }
 
-static int flushBlock(BF_Block **block) {
-    BF_Block_SetDirty(*block);
-    CALL_BF(BF_UnpinBlock(*block), true, HP_ERROR);
-    BF_Block_Destroy(block);
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, HP_ERROR);
+    return BF_OK;
+}
+
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, HP_ERROR);
     return BF_OK;
 }
 
-static int dumpBlock(BF_Block **block, bool unpin) {
-    if (unpin) {
-        CALL_BF(BF_UnpinBlock(*block), true, HP_ERROR);
+static int zonesPerBlock(struct Header * header) {
+    return header->info.block_size / sizeof(HP_zone);
+}
+
+static char * sideFileName(const char * fileName, const char * suffix) {
+    char * name = malloc(strlen(fileName) + strlen(suffix) + 1);
+    if (name != NULL) {
+        strcpy(name, fileName);
+        strcat(name, suffix);
+    }
+    return name;
+}
+
+/*
+ * Για κάθε block του χάρτη κρατιέται στην μνήμη η ένωση των διαστημάτων
+ * του (summary), ώστε μια αναζήτηση να διαβάζει μόνο τα block του χάρτη
+ * που μπορεί να την αφορούν.
+ */
+static int summaryExtend(struct Header * header, int zone_block, int low, int high) {
+    if (zone_block >= header->summary_count) {
+        HP_zone * summary = realloc(header->summary, sizeof(HP_zone) * (zone_block + 1));
+        if (summary == NULL) {
+            return HP_ERROR;
+        }
+        for (int z = header->summary_count; z <= zone_block; z++) {
+            summary[z].min = INT_MAX;
+            summary[z].max = INT_MIN;
+        }
+        header->summary = summary;
+        header->summary_count = zone_block + 1;
+    }
+    HP_zone * zone = &header->summary[zone_block];
+    zone->min = (low < zone->min) ? low : zone->min;
+    zone->max = (high > zone->max) ? high : zone->max;
+    return BF_OK;
+}
+
+/* Μεγαλώνει το διάστημα του block δεδομένων block_num ώστε να περιέχει τα
+ * low..high. Το block του χάρτη γίνεται dirty μόνο αν άλλαξε. */
+static int zoneExtend(struct Header * header, int block_num, int low, int high) {
+    const int per_block = zonesPerBlock(header);
+    const int zone_block = (block_num - 1) / per_block;
+    int blocks;
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlockCounter(header->zone_fd, &blocks), true, HP_ERROR);
+    for (; blocks <= zone_block; blocks++) {
+        CALL_BF(BF_AllocateBlock(header->zone_fd, block), true, HP_ERROR);
+        HP_zone * zones = (HP_zone *) BF_Block_GetData(block);
+        for (int k = 0; k < per_block; k++) {
+            zones[k].min = INT_MAX;
+            zones[k].max = INT_MIN;
+        }
+        CALL_BF(flushBlock(block), true, HP_ERROR);
+    }
+
+    CALL_BF(summaryExtend(header, zone_block, low, high), true, HP_ERROR);
+    CALL_BF(BF_GetBlock(header->zone_fd, zone_block, block), true, HP_ERROR);
+    HP_zone * zone = (HP_zone *) BF_Block_GetData(block) + (block_num - 1) % per_block;
+    if (low >= zone->min && high <= zone->max) {
+        return dumpBlock(block);
+    }
+    zone->min = (low < zone->min) ? low : zone->min;
+    zone->max = (high > zone->max) ? high : zone->max;
+    return flushBlock(block);
+}
+
+/* Διάστημα των id ενός block δεδομένων. */
+static void blockRange(struct Header * header, char * data, int * low, int * high) {
+    const int records = blockInfo(header, data)->records;
+    *low = INT_MAX;
+    *high = INT_MIN;
+    for (int k = 0; k < records; k++) {
+        int id = (header->info.layout == HP_LAYOUT_PAX) ? paxIds(data)[k]
+                : (header->info.layout == HP_LAYOUT_SLOTTED) ? SP_Id(data, slottedSpace(header), k)
+                : (header->info.layout == HP_LAYOUT_DICT) ? dictTuples(data)[k].id
+                : ((Record *) (data + k*sizeof(Record)))->id;
+        *low = (id < *low) ? id : *low;
+        *high = (id > *high) ? id : *high;
+    }
+}
+
+/* Ανοίγει τον χάρτη ζωνών, ή τον φτιάχνει διαβάζοντας όλο τον σωρό αν δεν
+ * υπάρχει, π.χ. σε αρχεία παλαιότερα από τους χάρτες. */
+static int zoneOpen(struct Header * header, const char * fileName) {
+    char * name = sideFileName(fileName, HP_ZONE_SUFFIX);
+    if (name == NULL) {
+        return HP_ERROR;
+    }
+    bool build = access(name, F_OK) != 0;
+    if (build && BF_CreateFile(name) != BF_OK) {
+        free(name);
+        return HP_ERROR;
+    }
+    BF_ErrorCode result = BF_OpenFile(name, &header->zone_fd);
+    free(name);
+    CALL_BF(result, true, HP_ERROR);
+
+    int blocks;
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    if (!build) {
+        CALL_BF(BF_GetBlockCounter(header->zone_fd, &blocks), true, HP_ERROR);
+        for (int z = 0; z < blocks; z++) {
+            CALL_BF(BF_GetBlock(header->zone_fd, z, block), true, HP_ERROR);
+            HP_zone * zones = (HP_zone *) BF_Block_GetData(block);
+            for (int k = 0; k < zonesPerBlock(header); k++) {
+                if (zones[k].min <= zones[k].max && summaryExtend(header, z, zones[k].min, zones[k].max) != BF_OK) {
+                    dumpBlock(block);
+                    return HP_ERROR;
+                }
+            }
+            CALL_BF(dumpBlock(block), true, HP_ERROR);
+        }
+        return BF_OK;
+    }
+
+    CALL_BF(BF_GetBlockCounter(header->info.fd, &blocks), true, HP_ERROR);
+    for (int b = 1; b < blocks; b++) {
+        int low, high;
+        CALL_BF(BF_GetBlock(header->info.fd, b, block), true, HP_ERROR);
+        blockRange(header, BF_Block_GetData(block), &low, &high);
+        CALL_BF(dumpBlock(block), true, HP_ERROR);
+        if (low <= high) {
+            CALL_BF(zoneExtend(header, b, low, high), true, HP_ERROR);
+        }
     }
-    BF_Block_Destroy(block);
+    return BF_OK;
+}
+
+/* Με ενεργό ημερολόγιο η επικεφαλίδα γράφεται στο block 0 μετά από κάθε
+ * εισαγωγή, ώστε η εισαγωγή να καταγράφεται ολόκληρη στο BF_Commit. */
+static int commitInsert(struct Header * header) {
+    if (!BF_LogActive()) {
+        return BF_OK;
+    }
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(header->info.fd, 0, block), true, HP_ERROR);
+    memcpy(BF_Block_GetData(block), (void*) header, HP_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, HP_ERROR);
+    CALL_BF(BF_Commit(), true, HP_ERROR);
     return BF_OK;
 }
 
 int HP_CreateFile(char *fileName) {
+    return HP_CreateFileEx(fileName, HP_LAYOUT_ROW);
+}
+
+int HP_CreateFileEx(char *fileName, int layout) {
     const int METHOD_ERROR_CODE = HP_ERROR;
-    union Header header = {0};
-    BF_Block *block = allocateMemoryBlock();
+    struct Header header = {0};
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
+    int block_size;
+
+    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    /* Ένας χάρτης ζωνών, ένα φίλτρο ή ένα λεξικό που έμειναν από
+     * παλαιότερο σωρό με το ίδιο όνομα δεν ισχύουν πια. */
+    const char * suffixes[] = {HP_ZONE_SUFFIX, HP_BLOOM_SUFFIX, HP_DICT_SUFFIX};
+    for (int k = 0; k < 3; k++) {
+        char * side_name = sideFileName(fileName, suffixes[k]);
+        if (side_name != NULL) {
+            unlink(side_name);
+            free(side_name);
+        }
+    }
 
     assignMagicWord(&header);
+    assignBlockSize(&header, block_size);
+    assignLayout(&header, layout);
     assignDensity(&header);
 
-    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
-    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
     CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
 
     char * data = BF_Block_GetData(block);
-    memcpy(data, &header, sizeof(union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, &header, HP_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
 
+    if (layout == HP_LAYOUT_DICT) {
+        char * name = sideFileName(fileName, HP_DICT_SUFFIX);
+        if (name == NULL) {
+            return METHOD_ERROR_CODE;
+        }
+        int result = DC_CreateFile(name);
+        free(name);
+        return result;
+    }
+
     return 0;
 }
 
+int HP_CreateFileBloom(char *fileName, int layout, int expected, double fp_rate) {
+    const int METHOD_ERROR_CODE = HP_ERROR;
+
+    if (HP_CreateFileEx(fileName, layout) != 0) {
+        return METHOD_ERROR_CODE;
+    }
+
+    char * name = sideFileName(fileName, HP_BLOOM_SUFFIX);
+    if (name == NULL) {
+        return METHOD_ERROR_CODE;
+    }
+    int result = BL_CreateFile(name, 1, expected, fp_rate);
+    free(name);
+    return result;
+}
+
+/* Ανοίγει το φίλτρο Bloom του σωρού, αν έχει. */
+static int bloomOpen(struct Header * header, const char * fileName) {
+    char * name = sideFileName(fileName, HP_BLOOM_SUFFIX);
+    if (name == NULL) {
+        return HP_ERROR;
+    }
+    int result = BF_OK;
+    if (access(name, F_OK) == 0) {
+        header->bloom = BL_OpenFile(name);
+        result = (header->bloom != NULL) ? BF_OK : HP_ERROR;
+    }
+    free(name);
+    return result;
+}
+
+/* Ανοίγει το λεξικό των αρχείων HP_LAYOUT_DICT. */
+static int dictionaryOpen(struct Header * header, const char * fileName) {
+    if (header->info.layout != HP_LAYOUT_DICT) {
+        return BF_OK;
+    }
+    char * name = sideFileName(fileName, HP_DICT_SUFFIX);
+    if (name == NULL) {
+        return HP_ERROR;
+    }
+    header->dictionary = DC_OpenFile(name);
+    free(name);
+    return (header->dictionary != NULL) ? BF_OK : HP_ERROR;
+}
+
 HP_info* HP_OpenFile(char *fileName) {
     static HP_info * METHOD_ERROR_CODE = NULL;
-    union Header * header = calloc(1, sizeof (union Header));
-    BF_Block *block = allocateMemoryBlock();
+    struct Header * header = calloc(1, sizeof (struct Header));
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
+    int block_size;
 
     CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy((void*) header, data, sizeof(union Header));
-    CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+    memcpy((void*) header, data, HP_HEADER_BYTES);
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
 
     header->info.fd = fd1;
     
@@ -111,23 +522,52 @@ HP_info* HP_OpenFile(char *fileName) {
         return NULL;
     }
     
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    if (zoneOpen(header, fileName) != BF_OK) {
+        fprintf(stderr, "ERROR: Cannot open zone map of %s \n", fileName); \
+        return NULL;
+    }
+
+    if (bloomOpen(header, fileName) != BF_OK) {
+        fprintf(stderr, "ERROR: Cannot open bloom filter of %s \n", fileName); \
+        return NULL;
+    }
+
+    if (dictionaryOpen(header, fileName) != BF_OK) {
+        fprintf(stderr, "ERROR: Cannot open dictionary of %s \n", fileName); \
+        return NULL;
+    }
+    
     return (HP_info*) header;
 }
 
 int HP_CloseFile(HP_info* hp_info) {
     const int METHOD_ERROR_CODE = HP_ERROR;
-    union Header * header = (union Header *) hp_info;
+    struct Header * header = (struct Header *) hp_info;
     int fd1 = header->info.fd;
     
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy(data, (void*) header, sizeof(union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, (void*) header, HP_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
     
+    CALL_BF(BF_CloseFile(header->zone_fd), true, METHOD_ERROR_CODE);
+    if (header->bloom != NULL) {
+        CALL_BF(BL_CloseFile(header->bloom), true, METHOD_ERROR_CODE);
+    }
+    if (header->dictionary != NULL) {
+        CALL_BF(DC_CloseFile(header->dictionary), true, METHOD_ERROR_CODE);
+    }
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
     
+    free (header->summary);
     free (header);
     
     printf("\nHP File closed, HP_ERRORS: %d \n", hp_errors); \
@@ -135,12 +575,13 @@ int HP_CloseFile(HP_info* hp_info) {
     return 0;
 }
 
-int HP_InsertEntry(HP_info* hp_info, Record record) {
-    const int METHOD_ERROR_CODE = HP_ERROR;
-    union Header * header = (union Header *) hp_info;
+/* Στις μορφές σταθερού μήκους η θέση της εγγραφής προκύπτει από το πλήθος
+ * των εγγραφών. Επιστρέφει το block της εγγραφής ή -1. */
+static int insertFixed(struct Header * header, const Record * record) {
     int fd1 = header->info.fd;
     
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     
     const int block_num = 1 + header->info.records / header->info.density;
     const int offset = header->info.records % header->info.density;
@@ -152,53 +593,713 @@ int HP_InsertEntry(HP_info* hp_info, Record record) {
             return -1;
         }
         
-        CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
-        CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
+        int new_block_num;
+        CALL_BF(BF_AllocateBlockEx(fd1, block, &new_block_num), true, HP_ERROR);
     }
     
     char * data = BF_Block_GetData(block);
-    memcpy(data + offset*sizeof(record), &record, sizeof(Record));
+    if (putRecord(header, data, offset, record) != BF_OK) {
+        dumpBlock(block);
+        return -1;
+    }
     
-    HP_block_info * info = (HP_block_info *)(data + BF_BLOCK_SIZE - sizeof(HP_block_info));
+    HP_block_info * info = blockInfo(header, data);
     info->records++;
     
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    CALL_BF(flushBlock(block), true, HP_ERROR);
+    return block_num;
+}
+
+/* Στην μορφή HP_LAYOUT_SLOTTED η εγγραφή μπαίνει στο τελευταίο block αν
+ * χωράει, αλλιώς σε νέο. Επιστρέφει το block της εγγραφής ή -1. */
+static int insertSlotted(struct Header * header, const Record * record) {
+    const int space = slottedSpace(header);
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int block_num;
+
+    CALL_BF(BF_GetBlockCounter(header->info.fd, &block_num), true, HP_ERROR);
+    block_num--;
+    if (block_num > 0) {
+        CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, HP_ERROR);
+        char * data = BF_Block_GetData(block);
+        HP_block_info * info = blockInfo(header, data);
+        if (SP_Append(data, space, info->records, record) == 0) {
+            info->records++;
+            CALL_BF(flushBlock(block), true, HP_ERROR);
+            return block_num;
+        }
+        CALL_BF(dumpBlock(block), true, HP_ERROR);
+    }
+
+    CALL_BF(BF_AllocateBlockEx(header->info.fd, block, &block_num), true, HP_ERROR);
+    char * data = BF_Block_GetData(block);
+    SP_Append(data, space, 0, record);
+    blockInfo(header, data)->records = 1;
+    CALL_BF(flushBlock(block), true, HP_ERROR);
+    return block_num;
+}
+
+int HP_InsertEntry(HP_info* hp_info, Record record) {
+    const int METHOD_ERROR_CODE = HP_ERROR;
+    struct Header * header = (struct Header *) hp_info;
+    
+    const int block_num = (header->info.layout == HP_LAYOUT_SLOTTED)
+            ? insertSlotted(header, &record) : insertFixed(header, &record);
+    if (block_num < 0) {
+        return METHOD_ERROR_CODE;
+    }
+    
+    CALL_BF(zoneExtend(header, block_num, record.id, record.id), true, METHOD_ERROR_CODE);
+    if (header->bloom != NULL) {
+        CALL_BF(BL_Add(header->bloom, 0, record.id), true, METHOD_ERROR_CODE);
+    }
     
     printf("Inserted: ");
     printRecord(record);
     
     header->info.records++;
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
     
     return block_num;
 }
 
-int HP_GetAllEntries(HP_info* hp_info, int value) {
+/* Γράφει στο τέλος του σωρού τα filled block του buffer και ενημερώνει
+ * τον χάρτη ζωνών τους. */
+static int appendBatch(struct Header * header, const char * buffer, size_t filled) {
+    int first_block;
+    CALL_BF(BF_AppendBlocks(header->info.fd, buffer, (int) filled, &first_block), true, HP_ERROR);
+    for (size_t k = 0; k < filled; k++) {
+        int low, high;
+        blockRange(header, (char *) buffer + k * header->info.block_size, &low, &high);
+        CALL_BF(zoneExtend(header, first_block + k, low, high), true, HP_ERROR);
+    }
+    return BF_OK;
+}
+
+/* Η HP_BulkInsert για την μορφή HP_LAYOUT_SLOTTED: κάθε block γεμίζει
+ * έως ότου η επόμενη εγγραφή δεν χωράει. */
+static int bulkInsertSlotted(struct Header * header, const Record * records, size_t n) {
+    const int space = slottedSpace(header);
+    const size_t block_size = header->info.block_size;
+    size_t done = 0;
+    int blocks;
+
+    /* Συμπλήρωση του τελευταίου block μέσα από την ενδιάμεση μνήμη. */
+    CALL_BF(BF_GetBlockCounter(header->info.fd, &blocks), true, HP_ERROR);
+    if (blocks > 1 && n > 0) {
+        BF_BlockHandle handle;
+        BF_Block *block = allocateMemoryBlock(&handle);
+
+        CALL_BF(BF_GetBlock(header->info.fd, blocks - 1, block), true, HP_ERROR);
+        char * data = BF_Block_GetData(block);
+        HP_block_info * info = blockInfo(header, data);
+        while (done < n && SP_Append(data, space, info->records, &records[done]) == 0) {
+            info->records++;
+            done++;
+        }
+        int low, high;
+        blockRange(header, data, &low, &high);
+        CALL_BF(flushBlock(block), true, HP_ERROR);
+        if (done > 0) {
+            CALL_BF(zoneExtend(header, blocks - 1, low, high), true, HP_ERROR);
+        }
+    }
+
+    size_t batch = (HP_BULK_BYTES > block_size) ? HP_BULK_BYTES / block_size : 1;
+    char * buffer = NULL;
+    if (done < n && posix_memalign((void **) &buffer, HP_BULK_ALIGN, batch * block_size) != 0) {
+        return HP_ERROR;
+    }
+
+    while (done < n) {
+        size_t filled = 0;
+        memset(buffer, 0, batch * block_size);
+        for (; filled < batch && done < n; filled++) {
+            char * data = buffer + filled * block_size;
+            HP_block_info * info = blockInfo(header, data);
+            while (done < n && SP_Append(data, space, info->records, &records[done]) == 0) {
+                info->records++;
+                done++;
+            }
+        }
+
+        if (appendBatch(header, buffer, filled) != BF_OK) {
+            free(buffer);
+            return HP_ERROR;
+        }
+    }
+    free(buffer);
+    return BF_OK;
+}
+
+int HP_BulkInsert(HP_info* hp_info, const Record *records, size_t n) {
     const int METHOD_ERROR_CODE = HP_ERROR;
-    union Header * header = (union Header *) hp_info;
+    struct Header * header = (struct Header *) hp_info;
     int fd1 = header->info.fd;
-    int blocks = 0;
-    bool found = false;
-    
-    BF_GetBlockCounter(fd1, &blocks);
-    
-    for (int i=1;i<blocks && !found;i++) {
-        BF_Block *block = allocateMemoryBlock();
-        CALL_BF(BF_GetBlock(fd1, i, block), true, METHOD_ERROR_CODE);
+    const size_t density = header->info.density;
+    const size_t block_size = header->info.block_size;
+    size_t done = 0;
+
+    for (size_t k = 0; k < n && header->bloom != NULL; k++) {
+        CALL_BF(BL_Add(header->bloom, 0, records[k].id), true, METHOD_ERROR_CODE);
+    }
+
+    if (header->info.layout == HP_LAYOUT_SLOTTED) {
+        CALL_BF(bulkInsertSlotted(header, records, n), false, METHOD_ERROR_CODE);
+        header->info.records += n;
+        CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
+        return 0;
+    }
+
+    /* Συμπλήρωση του τελευταίου block μέσα από την ενδιάμεση μνήμη. */
+    const size_t offset = header->info.records % density;
+    if (offset != 0 && n > 0) {
+        BF_BlockHandle handle;
+        BF_Block *block = allocateMemoryBlock(&handle);
+
+        CALL_BF(BF_GetBlock(fd1, 1 + header->info.records / density, block), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        HP_block_info * info = (HP_block_info *)(data + BF_BLOCK_SIZE - sizeof(HP_block_info));
-        
-        for (int j=0;j < info->records;j++) {
-            Record * record = (Record *) (data + j*sizeof(Record));
-            if (record->id == value) {
-                printRecord(*record);
-                found = true;
+        done = (n < density - offset) ? n : density - offset;
+        for (size_t k = 0; k < done; k++) {
+            if (putRecord(header, data, offset + k, &records[k]) != BF_OK) {
+                dumpBlock(block);
+                return METHOD_ERROR_CODE;
+            }
+        }
+        blockInfo(header, data)->records += done;
+        int low, high;
+        blockRange(header, data, &low, &high);
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+        CALL_BF(zoneExtend(header, 1 + header->info.records / density, low, high), true, METHOD_ERROR_CODE);
+    }
+
+    /* Τα υπόλοιπα block γεμίζουν σε τοπικό buffer και γράφονται μαζί. */
+    size_t blocks = (n - done + density - 1) / density;
+    size_t batch = (HP_BULK_BYTES > block_size) ? HP_BULK_BYTES / block_size : 1;
+    batch = (blocks < batch) ? blocks : batch;
+    char * buffer = NULL;
+    if (batch > 0 && posix_memalign((void **) &buffer, HP_BULK_ALIGN, batch * block_size) != 0) {
+        return METHOD_ERROR_CODE;
+    }
+
+    while (done < n) {
+        size_t filled = 0;
+        memset(buffer, 0, batch * block_size);
+        for (; filled < batch && done < n; filled++) {
+            char * data = buffer + filled * block_size;
+            size_t count = (n - done < density) ? n - done : density;
+            for (size_t k = 0; k < count; k++) {
+                if (putRecord(header, data, k, &records[done + k]) != BF_OK) {
+                    free(buffer);
+                    return METHOD_ERROR_CODE;
+                }
+            }
+            blockInfo(header, data)->records = count;
+            done += count;
+        }
+
+        if (appendBatch(header, buffer, filled) != BF_OK) {
+            free(buffer);
+            return METHOD_ERROR_CODE;
+        }
+    }
+    free(buffer);
+
+    header->info.records += n;
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
+
+    return 0;
+}
+
+/*
+ * Η σάρωση διαβάζει HP_BATCH block την φορά με την BF_GetBlocks. Κάθε block
+ * ξεκαρφιτσώνεται μόλις εξεταστούν όλες οι εγγραφές του.
+ */
+struct HP_Scan {
+    struct Header * header;
+    HP_Predicate predicate;
+    void * arg;
+    bool by_id;
+    int low;
+    int high;
+    bool by_code;
+    Record_Attribute attribute;
+    int code;
+    char value[DC_VALUE_SIZE + 1];
+    Record row;
+    int blocks;
+    int next_block;
+    int count;
+    int current;
+    int slot;
+    int blocks_read;
+    bool error;
+    BF_BlockHandle handles[HP_BATCH];
+    BF_Block *batch[HP_BATCH];
+    BF_BlockHandle zone_handle;
+    BF_Block *zone;
+    int zone_block;
+    int zone_blocks;
+};
+
+HP_Scan* HP_ScanOpenRange(HP_info* hp_info, int low, int high) {
+    HP_Scan * scan = HP_ScanOpen(hp_info, NULL, NULL);
+    if (scan != NULL) {
+        scan->by_id = true;
+        scan->low = low;
+        scan->high = high;
+    }
+
+    /* Μια αναζήτηση ισότητας που το φίλτρο απορρίπτει δεν διαβάζει κανένα
+     * block δεδομένων. */
+    if (scan != NULL && low == high && scan->header->bloom != NULL) {
+        int found = BL_MayContain(scan->header->bloom, 0, low);
+        scan->blocks_read++;
+        if (found < 0) {
+            scan->error = true;
+        } else if (found == 0) {
+            scan->next_block = scan->blocks;
+        }
+    }
+    return scan;
+}
+
+/* Το κατηγόρημα της HP_ScanOpenEquals στις μορφές χωρίς λεξικό. */
+static int equalsPredicate(const Record * record, void * arg) {
+    const HP_Scan * scan = arg;
+    const char * field = (scan->attribute == NAME) ? record->name
+            : (scan->attribute == SURNAME) ? record->surname : record->city;
+    const size_t size = (scan->attribute == NAME) ? sizeof(record->name)
+            : (scan->attribute == SURNAME) ? sizeof(record->surname) : sizeof(record->city);
+    return strlen(scan->value) <= size && strncmp(field, scan->value, size) == 0;
+}
+
+HP_Scan* HP_ScanOpenEquals(HP_info* hp_info, Record_Attribute attribute, const char *value) {
+    static HP_Scan * METHOD_ERROR_CODE = NULL;
+
+    if (attribute != NAME && attribute != SURNAME && attribute != CITY) {
+        fprintf(stderr, "ERROR: Invalid attribute for equality scan :%d \n", attribute);
+        return METHOD_ERROR_CODE;
+    }
+
+    HP_Scan * scan = HP_ScanOpen(hp_info, NULL, NULL);
+    if (scan == NULL) {
+        return METHOD_ERROR_CODE;
+    }
+    scan->attribute = attribute;
+    strncpy(scan->value, value, DC_VALUE_SIZE);
+
+    /* Καμία εγγραφή δεν έχει τιμή μεγαλύτερη από το πεδίο. */
+    if (strnlen(value, DC_VALUE_SIZE + 1) > DC_VALUE_SIZE) {
+        scan->next_block = scan->blocks;
+    }
+
+    if (scan->header->info.layout != HP_LAYOUT_DICT) {
+        scan->predicate = equalsPredicate;
+        scan->arg = scan;
+        return scan;
+    }
+
+    /* Η τιμή μετατρέπεται μία φορά στον κωδικό της. Μια τιμή που δεν
+     * υπάρχει στο λεξικό δεν υπάρχει σε καμία εγγραφή. */
+    scan->by_code = true;
+    scan->code = DC_Lookup(scan->header->dictionary, attribute, value);
+    if (scan->code < 0) {
+        scan->next_block = scan->blocks;
+    }
+    return scan;
+}
+
+HP_Scan* HP_ScanOpen(HP_info* hp_info, HP_Predicate predicate, void *arg) {
+    static HP_Scan * METHOD_ERROR_CODE = NULL;
+    HP_Scan * scan = calloc(1, sizeof (HP_Scan));
+    if (scan == NULL) {
+        return METHOD_ERROR_CODE;
+    }
+
+    scan->header = (struct Header *) hp_info;
+    scan->predicate = predicate;
+    scan->arg = arg;
+    scan->next_block = 1;
+    for (int k = 0; k < HP_BATCH; k++) {
+        scan->batch[k] = allocateMemoryBlock(&scan->handles[k]);
+    }
+    scan->zone = allocateMemoryBlock(&scan->zone_handle);
+    scan->zone_block = -1;
+
+    BF_ErrorCode result = BF_GetBlockCounter(scan->header->info.fd, &scan->blocks);
+    if (result == BF_OK) {
+        result = BF_GetBlockCounter(scan->header->zone_fd, &scan->zone_blocks);
+    }
+    if (result != BF_OK) {
+        free(scan);
+    }
+    CALL_BF(result, true, METHOD_ERROR_CODE);
+    return scan;
+}
+
+/* Ελέγχει στον χάρτη ζωνών αν το block_num μπορεί να έχει id στο
+ * διάστημα της σάρωσης. Επιστρέφει στο skip 0 αν μπορεί, αλλιώς πόσα block
+ * μπορούν να παραλειφθούν. Το block του χάρτη μένει καρφιτσωμένο όσο η
+ * σάρωση βρίσκεται μέσα στα block δεδομένων που καλύπτει. */
+static int zoneCheck(HP_Scan * scan, int block_num, int * skip) {
+    struct Header * header = scan->header;
+    const int per_block = zonesPerBlock(header);
+    const int zone_block = (block_num - 1) / per_block;
+
+    *skip = 0;
+    if (zone_block >= scan->zone_blocks || zone_block >= header->summary_count) {
+        return BF_OK;
+    }
+    if (header->summary[zone_block].min > scan->high || header->summary[zone_block].max < scan->low) {
+        *skip = (zone_block + 1) * per_block + 1 - block_num;
+        return BF_OK;
+    }
+    if (zone_block != scan->zone_block) {
+        if (scan->zone_block >= 0) {
+            CALL_BF(dumpBlock(scan->zone), true, HP_ERROR);
+            scan->zone_block = -1;
+        }
+        CALL_BF(BF_GetBlock(header->zone_fd, zone_block, scan->zone), true, HP_ERROR);
+        scan->zone_block = zone_block;
+        scan->blocks_read++;
+    }
+
+    HP_zone * zone = (HP_zone *) BF_Block_GetData(scan->zone) + (block_num - 1) % per_block;
+    *skip = (zone->min <= scan->high && zone->max >= scan->low) ? 0 : 1;
+    return BF_OK;
+}
+
+static int fetchBatch(HP_Scan * scan) {
+    int block_nums[HP_BATCH];
+    int n = 0;
+
+    while (n < HP_BATCH && scan->next_block < scan->blocks) {
+        int skip = 0;
+        if (scan->by_id && zoneCheck(scan, scan->next_block, &skip) != BF_OK) {
+            return HP_ERROR;
+        }
+        if (skip == 0) {
+            block_nums[n++] = scan->next_block;
+            skip = 1;
+        }
+        scan->next_block += skip;
+    }
+
+    if (n > 0) {
+        CALL_BF(BF_GetBlocks(scan->header->info.fd, block_nums, n, scan->batch), true, HP_ERROR);
+    }
+
+    scan->blocks_read += n;
+    scan->count = n;
+    scan->current = 0;
+    scan->slot = 0;
+    return BF_OK;
+}
+
+/* Στην μορφή PAX οι εγγραφές ανασυντίθενται στο scan->row, και στις
+ * σαρώσεις στο id μόνο όσες ταιριάζουν. */
+static const Record * nextPax(HP_Scan * scan, char * data, int records) {
+    while (scan->slot < records) {
+        int slot = scan->by_id ? nextId(paxIds(data), scan->slot, records, scan->low, scan->high) : scan->slot;
+        if (slot == records) {
+            break;
+        }
+        scan->slot = slot + 1;
+        getRecord(scan->header, data, slot, &scan->row);
+        if (scan->by_id || scan->predicate == NULL || scan->predicate(&scan->row, scan->arg)) {
+            return &scan->row;
+        }
+    }
+    scan->slot = records;
+    return NULL;
+}
+
+/* Στην μορφή HP_LAYOUT_SLOTTED οι εγγραφές ανασυντίθενται στο scan->row,
+ * και στις σαρώσεις στο id μόνο όσες ταιριάζουν. */
+static const Record * nextSlotted(HP_Scan * scan, char * data, int records) {
+    const int space = slottedSpace(scan->header);
+    while (scan->slot < records) {
+        int slot = scan->slot++;
+        if (scan->by_id) {
+            int id = SP_Id(data, space, slot);
+            if (id < scan->low || id > scan->high) {
+                continue;
+            }
+        }
+        SP_Get(data, space, slot, &scan->row);
+        if (scan->by_id || scan->predicate == NULL || scan->predicate(&scan->row, scan->arg)) {
+            return &scan->row;
+        }
+    }
+    return NULL;
+}
+
+/* Στην μορφή HP_LAYOUT_DICT οι σαρώσεις στο id και στον κωδικό ενός πεδίου
+ * εξετάζουν τις κωδικοποιημένες εγγραφές, και στο scan->row ανασυντίθενται
+ * μόνο όσες ταιριάζουν. */
+static const Record * nextDict(HP_Scan * scan, char * data, int records) {
+    const DC_tuple * tuples = dictTuples(data);
+    while (scan->slot < records) {
+        const DC_tuple * tuple = &tuples[scan->slot++];
+        if (scan->by_id ? tuple->id < scan->low || tuple->id > scan->high
+                : scan->by_code && DC_Code(tuple, scan->attribute) != scan->code) {
+            continue;
+        }
+        DC_DecodeRecord(scan->header->dictionary, tuple, &scan->row);
+        if (scan->by_id || scan->by_code || scan->predicate == NULL || scan->predicate(&scan->row, scan->arg)) {
+            return &scan->row;
+        }
+    }
+    return NULL;
+}
+
+const Record* HP_ScanNext(HP_Scan* scan) {
+    while (!scan->error) {
+        if (scan->current < scan->count) {
+            char * data = BF_Block_GetData(scan->batch[scan->current]);
+            HP_block_info * info = blockInfo(scan->header, data);
+
+            if (scan->header->info.layout == HP_LAYOUT_PAX) {
+                const Record * record = nextPax(scan, data, info->records);
+                if (record != NULL) {
+                    return record;
+                }
+            }
+
+            if (scan->header->info.layout == HP_LAYOUT_SLOTTED) {
+                const Record * record = nextSlotted(scan, data, info->records);
+                if (record != NULL) {
+                    return record;
+                }
+            }
+
+            if (scan->header->info.layout == HP_LAYOUT_DICT) {
+                const Record * record = nextDict(scan, data, info->records);
+                if (record != NULL) {
+                    return record;
+                }
+            }
+
+            while (scan->slot < info->records) {
+                const Record * record = (const Record *) (data + scan->slot*sizeof(Record));
+                scan->slot++;
+                if (scan->by_id ? record->id >= scan->low && record->id <= scan->high
+                        : scan->predicate == NULL || scan->predicate(record, scan->arg)) {
+                    return record;
+                }
+            }
+
+            scan->slot = 0;
+            if (dumpBlock(scan->batch[scan->current++]) != BF_OK) {
+                scan->error = true;
+            }
+            continue;
+        }
+
+        if (scan->next_block >= scan->blocks) {
+            break;
+        }
+        if (fetchBatch(scan) != BF_OK) {
+            scan->error = true;
+        }
+    }
+    return NULL;
+}
+
+int HP_ScanClose(HP_Scan* scan) {
+    while (scan->current < scan->count) {
+        if (dumpBlock(scan->batch[scan->current++]) != BF_OK) {
+            scan->error = true;
+        }
+    }
+    if (scan->zone_block >= 0 && dumpBlock(scan->zone) != BF_OK) {
+        scan->error = true;
+    }
+
+    int blocks = scan->error ? HP_ERROR : scan->blocks_read;
+    free(scan);
+    return blocks;
+}
+
+int HP_ScanEach(HP_info* hp_info, HP_Predicate predicate, void *predicate_arg,
+        HP_Callback callback, void *callback_arg) {
+    HP_Scan * scan = HP_ScanOpen(hp_info, predicate, predicate_arg);
+    if (scan == NULL) {
+        return HP_ERROR;
+    }
+
+    const Record * record;
+    while ((record = HP_ScanNext(scan)) != NULL) {
+        if (callback(record, callback_arg)) {
+            break;
+        }
+    }
+    return HP_ScanClose(scan);
+}
+
+/*
+ * Παράλληλη σάρωση: τα block δεδομένων χωρίζονται σε τμήματα των HP_MORSEL
+ * block και κάθε νήμα παίρνει αρχικά μια συνεχόμενη σειρά τμημάτων. Η σειρά
+ * κρατιέται σε μία ατομική λέξη (πρώτο τμήμα στα χαμηλά 32 bit, τέλος στα
+ * υψηλά), ώστε ο ιδιοκτήτης να παίρνει τμήματα από την αρχή και όποιος
+ * τελειώσει να κλέβει από το τέλος των άλλων με compare-and-swap. Κάθε
+ * νήμα σαρώνει με το δικό του HP_Scan, οπότε κρατάει καρφιτσωμένα το πολύ
+ * HP_BATCH block δεδομένων και ένα του χάρτη ζωνών.
+ */
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;
+} HP_Morsels;
+
+struct HP_Parallel {
+    HP_info * info;
+    HP_Predicate predicate;
+    void * predicate_arg;
+    HP_Callback callback;
+    void * callback_arg;
+    int blocks;
+    int workers;
+    HP_Morsels * morsels;
+    atomic_bool stop;
+    atomic_bool error;
+    atomic_int blocks_read;
+};
+
+struct HP_Worker {
+    struct HP_Parallel * parallel;
+    int id;
+    pthread_t thread;
+};
+
+static uint64_t morselRange(uint32_t first, uint32_t end) {
+    return (uint64_t) end << 32 | first;
+}
+
+/* Παίρνει ένα τμήμα από την αρχή (owner) ή από το τέλος της σειράς.
+ * Επιστρέφει -1 αν η σειρά είναι άδεια. */
+static int takeMorsel(HP_Morsels * morsels, bool owner) {
+    uint64_t range = atomic_load(&morsels->range);
+    for (;;) {
+        uint32_t first = (uint32_t) range, end = (uint32_t) (range >> 32);
+        if (first >= end) {
+            return -1;
+        }
+        uint64_t next = owner ? morselRange(first + 1, end) : morselRange(first, end - 1);
+        if (atomic_compare_exchange_weak(&morsels->range, &range, next)) {
+            return owner ? (int) first : (int) end - 1;
+        }
+    }
+}
+
+static void * scanWorker(void * arg) {
+    struct HP_Worker * worker = arg;
+    struct HP_Parallel * parallel = worker->parallel;
+
+    HP_Scan * scan = HP_ScanOpen(parallel->info, parallel->predicate, parallel->predicate_arg);
+    if (scan == NULL) {
+        atomic_store(&parallel->error, true);
+        return NULL;
+    }
+
+    for (int k = 0; k < parallel->workers && !atomic_load_explicit(&parallel->stop, memory_order_relaxed); ) {
+        int victim = (worker->id + k) % parallel->workers;
+        int morsel = takeMorsel(&parallel->morsels[victim], k == 0);
+        if (morsel < 0) {
+            k++;
+            continue;
+        }
+
+        int first = 1 + morsel * HP_MORSEL;
+        scan->next_block = first;
+        scan->blocks = first + HP_MORSEL < parallel->blocks ? first + HP_MORSEL : parallel->blocks;
+
+        const Record * record;
+        while ((record = HP_ScanNext(scan)) != NULL) {
+            if (parallel->callback(record, parallel->callback_arg)) {
+                atomic_store(&parallel->stop, true);
+            }
+            if (atomic_load_explicit(&parallel->stop, memory_order_relaxed)) {
                 break;
             }
         }
-        
-        CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
     }
-    
-    return blocks-1;
+
+    int blocks = HP_ScanClose(scan);
+    if (blocks < 0) {
+        atomic_store(&parallel->error, true);
+        atomic_store(&parallel->stop, true);
+    } else {
+        atomic_fetch_add(&parallel->blocks_read, blocks);
+    }
+    return NULL;
 }
 
+int HP_ScanParallel(HP_info* hp_info, HP_Predicate predicate, void *predicate_arg,
+        HP_Callback callback, void *callback_arg, int threads) {
+    struct Header * header = (struct Header *) hp_info;
+    struct HP_Parallel parallel = {hp_info, predicate, predicate_arg, callback, callback_arg};
+
+    CALL_BF(BF_GetBlockCounter(header->info.fd, &parallel.blocks), true, HP_ERROR);
+    int morsels = (parallel.blocks - 1 + HP_MORSEL - 1) / HP_MORSEL;
+    if (threads <= 0) {
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > morsels) {
+        threads = morsels;
+    }
+    if (threads <= 1) {
+        return HP_ScanEach(hp_info, predicate, predicate_arg, callback, callback_arg);
+    }
+
+    parallel.workers = threads;
+    parallel.morsels = aligned_alloc(_Alignof(HP_Morsels), sizeof (HP_Morsels) * threads);
+    struct HP_Worker * workers = malloc(sizeof (struct HP_Worker) * threads);
+    if (parallel.morsels == NULL || workers == NULL) {
+        free(parallel.morsels);
+        free(workers);
+        return HP_ERROR;
+    }
+    atomic_init(&parallel.stop, false);
+    atomic_init(&parallel.error, false);
+    atomic_init(&parallel.blocks_read, 0);
+
+    for (int w = 0; w < threads; w++) {
+        uint32_t first = (uint32_t) ((long long) morsels * w / threads);
+        uint32_t end = (uint32_t) ((long long) morsels * (w + 1) / threads);
+        atomic_init(&parallel.morsels[w].range, morselRange(first, end));
+    }
+
+    /* Το νήμα που καλεί την συνάρτηση είναι ο worker 0. */
+    int started = 1;
+    for (int w = 0; w < threads; w++) {
+        workers[w].parallel = &parallel;
+        workers[w].id = w;
+    }
+    for (int w = 1; w < threads; w++, started++) {
+        if (pthread_create(&workers[w].thread, NULL, scanWorker, &workers[w]) != 0) {
+            break;
+        }
+    }
+    scanWorker(&workers[0]);
+    for (int w = 1; w < started; w++) {
+        pthread_join(workers[w].thread, NULL);
+    }
+
+    free(parallel.morsels);
+    free(workers);
+    return atomic_load(&parallel.error) ? HP_ERROR : atomic_load(&parallel.blocks_read);
+}
+
+int HP_GetAllEntries(HP_info* hp_info, int value) {
+    HP_Scan * scan = HP_ScanOpenRange(hp_info, value, value);
+    if (scan == NULL) {
+        return HP_ERROR;
+    }
+
+    const Record * record;
+    while ((record = HP_ScanNext(scan)) != NULL) {
+        printRecord(*record);
+    }
+    return HP_ScanClose(scan);
+}
@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bf.h"
+#include "hp_file.h"
+#include "hp_sort.h"
+#include "record.h"
+
+static int hs_errors = 0;
+
+#define CALL_BF(call, printError, error_code)       \
+{                           \
+  BF_ErrorCode code = call; \
+  if (code != BF_OK) {         \
+    if (printError) {\
+        hs_errors++; \
+        BF_PrintError(code);    \
+        fprintf(stderr, "code: %d \n", code); \
+    }\
+    return error_code;\
+  } \
+}
+
+/*
+ * Εξωτερική ταξινόμηση σε δύο φάσεις. Στην πρώτη οι εγγραφές του σωρού
+ * διαβάζονται με την HP_ScanNext σε έναν πίνακα στο μέγεθος της μνήμης,
+ * που ταξινομείται με την qsort και γράφεται σε ένα αρχείο BF (run). Στην
+ * δεύτερη έως fan_in runs συγχωνεύονται κάθε φορά με ένα δέντρο ηττημένων,
+ * σε νέα runs όσο είναι περισσότερα από fan_in και στο τέλος στο αρχείο
+ * εξόδου με την HP_BulkInsert.
+ *
+ * Ένα run έχει block_size / sizeof(Record) εγγραφές σε κάθε block, χωρίς
+ * επικεφαλίδα· το πλήθος των εγγραφών του το ξέρει μόνο η ταξινόμηση. Τα
+ * runs γράφονται με την BF_AppendBlocks ανά HS_BATCH block και διαβάζονται
+ * με την BF_GetBlocks ανά HS_BATCH block σε δύο buffer ανά run: όσο
+ * καταναλώνεται ο ένας, ο άλλος έχει ήδη το επόμενο τμήμα. Τα block
+ * αντιγράφονται στους buffer και ξεκαρφιτσώνονται αμέσως, ώστε η ενδιάμεση
+ * μνήμη να μην χρειάζεται πλαίσια για όλα τα runs.
+ */
+
+/* Block ανά ανάγνωση ή εγγραφή ενός run. */
+#define HS_BATCH 16
+
+/* Στοίχιση του buffer εγγραφής, για αρχεία με BF_DIRECT_IO. */
+#define HS_ALIGN 4096
+
+static int HS_ERROR = -1;
+
+typedef int (*HS_Compare)(const void *a, const void *b);
+
+typedef struct {
+    char * name;
+    int fd;
+    long long records;
+} HS_Run;
+
+struct HS_Sort {
+    const char * output;
+    HS_Compare compare;
+    int block_size;
+    int per_block;
+    int batch;
+    int fan_in;
+    size_t run_records;
+    int next_run;
+    char * scratch;
+    BF_BlockHandle handles[HS_BATCH];
+    BF_Block * blocks[HS_BATCH];
+    HP_SortStats stats;
+};
+
+/* Ο buffer εξόδου μιας συγχώνευσης: γράφει σε run ή, αν hp δεν είναι
+ * NULL, στο αρχείο εξόδου. */
+typedef struct {
+    HP_info * hp;
+    HS_Run * run;
+    Record * records;
+    int count;
+    int capacity;
+} HS_Writer;
+
+typedef struct {
+    HS_Run * run;
+    Record * buffer[2];
+    int count[2];
+    int current;
+    int slot;
+    int next_block;
+    int blocks;
+    long long unread;
+} HS_Reader;
+
+/* Δέντρο ηττημένων με k φύλλα, ένα για κάθε run: οι εσωτερικοί κόμβοι
+ * 1 έως k - 1 κρατάνε τον ηττημένο της σύγκρισής τους και ο κόμβος 0 τον
+ * νικητή. Τα φύλλα είναι οι θέσεις k έως 2k - 1, οπότε ο πατέρας του run s
+ * είναι ο (s + k) / 2. */
+typedef struct {
+    HS_Reader * readers;
+    HS_Compare compare;
+    int k;
+    int * tree;
+} HS_Tree;
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
+    BF_Block *block = NULL;
+    BF_Block_InitInPlace(handle, &block);
+    return block;
+}
+
+static int compareId(const void * a, const void * b) {
+    int x = ((const Record *) a)->id, y = ((const Record *) b)->id;
+    return (x > y) - (x < y);
+}
+
+static int compareName(const void * a, const void * b) {
+    int c = strncmp(((const Record *) a)->name, ((const Record *) b)->name, sizeof(((Record *) 0)->name));
+    return c != 0 ? c : compareId(a, b);
+}
+
+static int compareSurname(const void * a, const void * b) {
+    int c = strncmp(((const Record *) a)->surname, ((const Record *) b)->surname, sizeof(((Record *) 0)->surname));
+    return c != 0 ? c : compareId(a, b);
+}
+
+static int compareCity(const void * a, const void * b) {
+    int c = strncmp(((const Record *) a)->city, ((const Record *) b)->city, sizeof(((Record *) 0)->city));
+    return c != 0 ? c : compareId(a, b);
+}
+
+static HS_Compare keyCompare(Record_Attribute key) {
+    switch (key) {
+        case ID: return compareId;
+        case NAME: return compareName;
+        case SURNAME: return compareSurname;
+        case CITY: return compareCity;
+    }
+    return NULL;
+}
+
+static int runCreate(struct HS_Sort * sort, HS_Run * run) {
+    size_t length = strlen(sort->output) + 32;
+    run->name = malloc(length);
+    run->records = 0;
+    run->fd = -1;
+    if (run->name == NULL) {
+        return HS_ERROR;
+    }
+    snprintf(run->name, length, "%s.run%d", sort->output, sort->next_run++);
+    unlink(run->name);
+    CALL_BF(BF_CreateFile(run->name), true, HS_ERROR);
+    CALL_BF(BF_OpenFile(run->name, &run->fd), true, HS_ERROR);
+    return BF_OK;
+}
+
+static void runDrop(HS_Run * run) {
+    if (run->fd >= 0) {
+        BF_CloseFile(run->fd);
+        unlink(run->name);
+    }
+    free(run->name);
+    run->name = NULL;
+    run->fd = -1;
+}
+
+static void runsDrop(HS_Run * runs, int count) {
+    for (int r = 0; r < count; r++) {
+        runDrop(&runs[r]);
+    }
+    free(runs);
+}
+
+/* Γράφει n εγγραφές στο τέλος του run, batch block την φορά. */
+static int runAppend(struct HS_Sort * sort, HS_Run * run, const Record * records, int n) {
+    const int chunk = sort->batch * sort->per_block;
+
+    for (int done = 0; done < n; done += chunk) {
+        int count = n - done < chunk ? n - done : chunk;
+        int blocks = (count + sort->per_block - 1) / sort->per_block;
+        memset(sort->scratch, 0, (size_t) blocks * sort->block_size);
+        for (int b = 0; b < blocks; b++) {
+            int in_block = count - b * sort->per_block < sort->per_block ? count - b * sort->per_block : sort->per_block;
+            memcpy(sort->scratch + (size_t) b * sort->block_size, records + done + b * sort->per_block, in_block * sizeof(Record));
+        }
+        int first;
+        CALL_BF(BF_AppendBlocks(run->fd, sort->scratch, blocks, &first), true, HS_ERROR);
+    }
+    run->records += n;
+    return BF_OK;
+}
+
+static int writerFlush(struct HS_Sort * sort, HS_Writer * writer) {
+    if (writer->count == 0) {
+        return BF_OK;
+    }
+    if (writer->hp != NULL) {
+        CALL_BF(HP_BulkInsert(writer->hp, writer->records, writer->count), false, HS_ERROR);
+    } else {
+        CALL_BF(runAppend(sort, writer->run, writer->records, writer->count), false, HS_ERROR);
+    }
+    writer->count = 0;
+    return BF_OK;
+}
+
+/* Διαβάζει στον buffer which τα επόμενα έως batch block του run. */
+static int readerFill(struct HS_Sort * sort, HS_Reader * reader, int which) {
+    int block_nums[HS_BATCH];
+    int n = reader->blocks - reader->next_block < sort->batch ? reader->blocks - reader->next_block : sort->batch;
+
+    reader->count[which] = 0;
+    if (n <= 0) {
+        return BF_OK;
+    }
+    for (int k = 0; k < n; k++) {
+        block_nums[k] = reader->next_block + k;
+    }
+    CALL_BF(BF_GetBlocks(reader->run->fd, block_nums, n, sort->blocks), true, HS_ERROR);
+
+    BF_ErrorCode result = BF_OK;
+    for (int k = 0; k < n; k++) {
+        int in_block = reader->unread < sort->per_block ? (int) reader->unread : sort->per_block;
+        memcpy(reader->buffer[which] + reader->count[which], BF_Block_GetData(sort->blocks[k]), in_block * sizeof(Record));
+        reader->count[which] += in_block;
+        reader->unread -= in_block;
+        if (BF_UnpinBlock(sort->blocks[k]) != BF_OK) {
+            result = BF_ERROR;
+        }
+    }
+    reader->next_block += n;
+    CALL_BF(result, true, HS_ERROR);
+    return BF_OK;
+}
+
+static const Record * readerHead(HS_Reader * reader) {
+    return reader->slot < reader->count[reader->current] ? &reader->buffer[reader->current][reader->slot] : NULL;
+}
+
+/* Προχωράει στην επόμενη εγγραφή. Όταν τελειώνει ο τρέχων buffer, η
+ * ανάγνωση συνεχίζει από τον άλλο, που είναι ήδη γεμάτος, και ο άδειος
+ * γεμίζει με το τμήμα που ακολουθεί. */
+static int readerAdvance(struct HS_Sort * sort, HS_Reader * reader) {
+    if (++reader->slot < reader->count[reader->current]) {
+        return BF_OK;
+    }
+    int used = reader->current;
+    reader->current ^= 1;
+    reader->slot = 0;
+    return readerFill(sort, reader, used);
+}
+
+static bool treeLess(HS_Tree * tree, int a, int b) {
+    const Record * x = readerHead(&tree->readers[a]);
+    const Record * y = readerHead(&tree->readers[b]);
+    if (x == NULL || y == NULL) {
+        return x != NULL || (y == NULL && a < b);
+    }
+    int c = tree->compare(x, y);
+    return c < 0 || (c == 0 && a < b);
+}
+
+static int treeBuild(HS_Tree * tree, int node) {
+    if (node >= tree->k) {
+        return node - tree->k;
+    }
+    int left = treeBuild(tree, 2 * node);
+    int right = treeBuild(tree, 2 * node + 1);
+    if (treeLess(tree, left, right)) {
+        tree->tree[node] = right;
+        return left;
+    }
+    tree->tree[node] = left;
+    return right;
+}
+
+/* Μετά την αλλαγή της εγγραφής του νικητή, ο νέος νικητής βρίσκεται με
+ * συγκρίσεις μόνο στον δρόμο από το φύλλο του έως την ρίζα. */
+static void treeReplay(HS_Tree * tree) {
+    int winner = tree->tree[0];
+    for (int node = (winner + tree->k) / 2; node > 0; node /= 2) {
+        if (treeLess(tree, tree->tree[node], winner)) {
+            int loser = winner;
+            winner = tree->tree[node];
+            tree->tree[node] = loser;
+        }
+    }
+    tree->tree[0] = winner;
+}
+
+/* Συγχωνεύει τα k runs στον writer και τα διαγράφει. */
+static int mergeRuns(struct HS_Sort * sort, HS_Run * runs, int k, HS_Writer * writer) {
+    const size_t records = (size_t) sort->batch * sort->per_block;
+    HS_Reader * readers = calloc(k, sizeof(HS_Reader));
+    Record * buffers = malloc(2 * k * records * sizeof(Record));
+    HS_Tree tree = {readers, sort->compare, k, malloc(sizeof(int) * (k + 1))};
+    int result = (readers == NULL || buffers == NULL || tree.tree == NULL) ? HS_ERROR : BF_OK;
+
+    for (int r = 0; r < k && result == BF_OK; r++) {
+        HS_Reader * reader = &readers[r];
+        reader->run = &runs[r];
+        reader->buffer[0] = buffers + 2 * r * records;
+        reader->buffer[1] = buffers + (2 * r + 1) * records;
+        reader->blocks = (int) ((runs[r].records + sort->per_block - 1) / sort->per_block);
+        reader->unread = runs[r].records;
+        result = readerFill(sort, reader, 0);
+        if (result == BF_OK) {
+            result = readerFill(sort, reader, 1);
+        }
+    }
+
+    if (result == BF_OK && k > 0) {
+        tree.tree[0] = treeBuild(&tree, 1);
+    }
+    while (result == BF_OK && k > 0) {
+        int winner = tree.tree[0];
+        const Record * record = readerHead(&readers[winner]);
+        if (record == NULL) {
+            break;
+        }
+        writer->records[writer->count++] = *record;
+        if (writer->count == writer->capacity) {
+            result = writerFlush(sort, writer);
+        }
+        if (result == BF_OK) {
+            result = readerAdvance(sort, &readers[winner]);
+        }
+        treeReplay(&tree);
+    }
+    if (result == BF_OK) {
+        result = writerFlush(sort, writer);
+    }
+
+    for (int r = 0; r < k; r++) {
+        runDrop(&runs[r]);
+    }
+    free(tree.tree);
+    free(buffers);
+    free(readers);
+    return result;
+}
+
+/* Πρώτη φάση: ταξινομημένα runs των run_records εγγραφών. */
+static int makeRuns(struct HS_Sort * sort, char * input, HS_Run ** runs, int * count) {
+    const size_t capacity = sort->run_records;
+    Record * records = malloc(capacity * sizeof(Record));
+    int allocated = 0;
+    int result = BF_OK;
+
+    *runs = NULL;
+    *count = 0;
+    HP_info * info = records == NULL ? NULL : HP_OpenFile(input);
+    HP_Scan * scan = info == NULL ? NULL : HP_ScanOpen(info, NULL, NULL);
+    if (scan == NULL) {
+        if (info != NULL) {
+            HP_CloseFile(info);
+        }
+        free(records);
+        return HS_ERROR;
+    }
+
+    const Record * record = HP_ScanNext(scan);
+    while (record != NULL && result == BF_OK) {
+        size_t n = 0;
+        for (; n < capacity && record != NULL; record = HP_ScanNext(scan)) {
+            records[n++] = *record;
+        }
+        qsort(records, n, sizeof(Record), sort->compare);
+
+        if (*count == allocated) {
+            allocated = allocated == 0 ? 16 : 2 * allocated;
+            HS_Run * grown = realloc(*runs, allocated * sizeof(HS_Run));
+            if (grown == NULL) {
+                result = HS_ERROR;
+                break;
+            }
+            *runs = grown;
+        }
+        HS_Run * run = &(*runs)[(*count)++];
+        result = runCreate(sort, run);
+        if (result == BF_OK) {
+            result = runAppend(sort, run, records, (int) n);
+        }
+        sort->stats.records += n;
+    }
+
+    if (HP_ScanClose(scan) < 0) {
+        result = HS_ERROR;
+    }
+    HP_CloseFile(info);
+    free(records);
+    sort->stats.runs = *count;
+    return result;
+}
+
+int HP_Sort(char *input, char *output, Record_Attribute key, size_t memory, HP_SortStats *stats) {
+    const int METHOD_ERROR_CODE = HS_ERROR;
+    struct HS_Sort sort = {0};
+    int fd;
+
+    sort.output = output;
+    sort.compare = keyCompare(key);
+    if (sort.compare == NULL) {
+        return METHOD_ERROR_CODE;
+    }
+
+    CALL_BF(BF_OpenFile(input, &fd), true, METHOD_ERROR_CODE);
+    BF_ErrorCode result = BF_GetBlockSize(fd, &sort.block_size);
+    CALL_BF(BF_CloseFile(fd), true, METHOD_ERROR_CODE);
+    CALL_BF(result, true, METHOD_ERROR_CODE);
+
+    /* Στην συγχώνευση κάθε run έχει δύο buffer των batch block και η έξοδος
+     * έναν. Το batch μικραίνει αν η μνήμη δεν φτάνει για δύο runs. */
+    sort.per_block = sort.block_size / sizeof(Record);
+    sort.batch = HS_BATCH;
+    sort.fan_in = (int) (memory / (2 * (size_t) HS_BATCH * sort.block_size)) - 1;
+    while (sort.fan_in < 2 && sort.batch > 1) {
+        sort.batch /= 2;
+        sort.fan_in = (int) (memory / (2 * (size_t) sort.batch * sort.block_size)) - 1;
+    }
+    if (sort.fan_in < 2) {
+        fprintf(stderr, "ERROR: Sort memory %zu bytes is too small \n", memory);
+        return METHOD_ERROR_CODE;
+    }
+    for (int k = 0; k < HS_BATCH; k++) {
+        sort.blocks[k] = allocateMemoryBlock(&sort.handles[k]);
+    }
+    if (posix_memalign((void **) &sort.scratch, HS_ALIGN, (size_t) sort.batch * sort.block_size) != 0) {
+        return METHOD_ERROR_CODE;
+    }
+
+    /* Η πρώτη φάση χρησιμοποιεί την μνήμη που μένει μετά τον buffer
+     * εγγραφής. */
+    sort.run_records = (memory - (size_t) sort.batch * sort.block_size) / sizeof(Record);
+
+    HS_Run * runs;
+    int count;
+    int status = makeRuns(&sort, input, &runs, &count);
+
+    Record * out = malloc((size_t) sort.batch * sort.per_block * sizeof(Record));
+    if (out == NULL) {
+        status = HS_ERROR;
+    }
+
+    /* Ενδιάμεσες φάσεις, όσο τα runs δεν χωράνε σε μία συγχώνευση. */
+    while (status == BF_OK && count > sort.fan_in) {
+        int next = (count + sort.fan_in - 1) / sort.fan_in;
+        HS_Run * merged = calloc(next, sizeof(HS_Run));
+        if (merged == NULL) {
+            status = HS_ERROR;
+            break;
+        }
+        for (int m = 0, first = 0; m < next; m++, first += sort.fan_in) {
+            int k = count - first < sort.fan_in ? count - first : sort.fan_in;
+            HS_Writer writer = {NULL, &merged[m], out, 0, sort.batch * sort.per_block};
+            merged[m].fd = -1;
+            if (status == BF_OK) {
+                status = runCreate(&sort, &merged[m]);
+            }
+            if (status == BF_OK) {
+                status = mergeRuns(&sort, runs + first, k, &writer);
+            } else {
+                for (int r = first; r < first + k; r++) {
+                    runDrop(&runs[r]);
+                }
+            }
+            sort.stats.fan_in = k > sort.stats.fan_in ? k : sort.stats.fan_in;
+        }
+        free(runs);
+        runs = merged;
+        count = next;
+        sort.stats.passes++;
+    }
+
+    /* Τελική συγχώνευση στο αρχείο εξόδου. */
+    if (status == BF_OK) {
+        HP_info * info = HP_CreateFile(output) == 0 ? HP_OpenFile(output) : NULL;
+        HS_Writer writer = {info, NULL, out, 0, sort.batch * sort.per_block};
+        sort.stats.fan_in = count > sort.stats.fan_in ? count : sort.stats.fan_in;
+        sort.stats.passes++;
+        if (info != NULL) {
+            status = mergeRuns(&sort, runs, count, &writer);
+            count = 0;
+            if (HP_CloseFile(info) != 0) {
+                status = HS_ERROR;
+            }
+        } else {
+            status = HS_ERROR;
+        }
+    }
+
+    runsDrop(runs, count);
+    free(out);
+    free(sort.scratch);
+    if (stats != NULL) {
+        *stats = sort.stats;
+    }
+    return status == BF_OK ? 0 : METHOD_ERROR_CODE;
+}
@@ -3,9 +3,13 @@
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <unistd.h>
 
 #include "bf.h"
 #include "ht_table.h"
+#include "bloom_filter.h"
+#include "slotted_page.h"
+#include "dictionary.h"
 #include "record.h"
 
 static int ht_errors = 0;
@@ -23,20 +27,28 @@ static int ht_errors = 0;
   } \
 }
 
-union Header {
-
-    struct {
-        char prefix[3];
-        HT_info info;
-        int head[(BF_BLOCK_SIZE - 2 - sizeof (HT_info)) / 4];
-    };
-    char block[BF_BLOCK_SIZE];
+struct Header {
+    char prefix[3];
+    HT_info info;
+    int head[];
 };
 
+/* Πλήθος block που διαβάζονται μαζί με την BF_GetBlocks στα στατιστικά. */
+#define HT_BATCH 8
+
+/* Τα προαιρετικά φίλτρα Bloom των κάδων, ένα για την αλυσίδα κάθε κάδου,
+ * βρίσκονται σε αρχείο με όνομα το όνομα του αρχείου κατακερματισμού και
+ * την κατάληξη HT_BLOOM_SUFFIX. */
+#define HT_BLOOM_SUFFIX ".bloom"
+
+/* Το λεξικό των αρχείων HT_LAYOUT_DICT βρίσκεται σε αρχείο με όνομα το
+ * όνομα του αρχείου κατακερματισμού και την κατάληξη HT_DICT_SUFFIX. */
+#define HT_DICT_SUFFIX ".dict"
+
 static char HT_PREFIX[3] = "HT";
 static int HT_ERROR = -1;
 
-static void assignMagicWord(union Header * header) {
+static void assignMagicWord(struct Header * header) {
     strncpy(header->prefix, HT_PREFIX, strlen(HT_PREFIX) + 1);
 }
 
@@ -47,75 +59,246 @@ static unsigned int hash(unsigned int x) {
     return x;
 }
 
-static void assignDensity(union Header * header) {
-    header->info.density = (BF_BLOCK_SIZE - sizeof (HT_info)) / sizeof (Record);
+static int maxBuckets(int block_size) {
+    return (block_size - sizeof (struct Header)) / sizeof (int);
+}
+
+static void assignBlockSize(struct Header * header, int block_size) {
+    header->info.block_size = block_size;
+}
+
+static void assignLayout(struct Header * header, int layout) {
+    header->info.layout = layout;
 }
 
-static void assignBuckets(union Header * header, int buckets) {
+static void assignDensity(struct Header * header) {
+    size_t row = (header->info.layout == HT_LAYOUT_SLOTTED) ? SP_MAX_TUPLE
+            : (header->info.layout == HT_LAYOUT_DICT) ? sizeof (DC_tuple) : sizeof (Record);
+    header->info.density = (header->info.block_size - sizeof (HT_block_info)) / row;
+}
+
+static void assignBuckets(struct Header * header, int buckets) {
     header->info.buckets = buckets;
 }
 
-static void assignHeads(union Header * header) {
-    for (int i = 0; i < (BF_BLOCK_SIZE - 2 - sizeof (HT_info)) / 4; i++) {
+static void assignHeads(struct Header * header) {
+    for (int i = 0; i < maxBuckets(header->info.block_size); i++) {
         header->head[i] = -1;
     }
 }
 
-static BF_Block * allocateMemoryBlock() {
+/* Στην μνήμη, μετά το αντίγραφο του block 0, κρατιούνται οι δείκτες στα
+ * φίλτρα Bloom και στο λεξικό (NULL αν το αρχείο δεν έχει). */
+#define HT_RUNTIME_BYTES (sizeof (BL_info *) + sizeof (DC_info *))
+
+static BL_info ** bloomFilters(struct Header * header) {
+    return (BL_info **) ((char *) header + header->info.block_size);
+}
+
+static DC_info ** dictionary(struct Header * header) {
+    return (DC_info **) ((char *) header + header->info.block_size + sizeof (BL_info *));
+}
+
+static char * sideFileName(const char * fileName, const char * suffix) {
+    char * name = malloc(strlen(fileName) + strlen(suffix) + 1);
+    if (name != NULL) {
+        strcpy(name, fileName);
+        strcat(name, suffix);
+    }
+    return name;
+}
+
+static HT_block_info * blockInfo(struct Header * header, char * data) {
+    return (HT_block_info *) (data + header->info.block_size - sizeof (HT_block_info));
+}
+
+/* Στην μορφή HT_LAYOUT_SLOTTED ο χώρος των εγγραφών και του καταλόγου
+ * θέσεων, πριν από το HT_block_info. */
+static int slottedSpace(struct Header * header) {
+    return header->info.block_size - sizeof (HT_block_info);
+}
+
+/* Στην μορφή HT_LAYOUT_DICT κάθε block έχει density εγγραφές DC_tuple, με
+ * κωδικούς του λεξικού στην θέση των name, surname και city. */
+static DC_tuple * dictTuples(char * data) {
+    return (DC_tuple *) data;
+}
+
+/* Γράφει την εγγραφή μετά τις εγγραφές του block, στην μορφή
+ * HT_LAYOUT_DICT την ήδη κωδικοποιημένη tuple. Επιστρέφει false αν δεν
+ * χωράει. */
+static bool putRecord(struct Header * header, char * data, const Record * record, const DC_tuple * tuple) {
+    HT_block_info * info = blockInfo(header, data);
+
+    if (header->info.layout == HT_LAYOUT_DICT) {
+        if (info->records == header->info.density) {
+            return false;
+        }
+        dictTuples(data)[info->records] = *tuple;
+    } else if (header->info.layout == HT_LAYOUT_SLOTTED) {
+        if (SP_Append(data, slottedSpace(header), info->records, record) != 0) {
+            return false;
+        }
+    } else {
+        if (info->records == header->info.density) {
+            return false;
+        }
+        memcpy(data + info->records * sizeof (Record), record, sizeof (Record));
+    }
+    info->records++;
+    return true;
+}
+
+static int recordId(struct Header * header, char * data, int slot) {
+    if (header->info.layout == HT_LAYOUT_DICT) {
+        return dictTuples(data)[slot].id;
+    }
+    if (header->info.layout == HT_LAYOUT_SLOTTED) {
+        return SP_Id(data, slottedSpace(header), slot);
+    }
+    return ((Record *) (data + slot * sizeof (Record)))->id;
+}
+
+static void getRecord(struct Header * header, char * data, int slot, Record * record) {
+    if (header->info.layout == HT_LAYOUT_DICT) {
+        DC_DecodeRecord(*dictionary(header), &dictTuples(data)[slot], record);
+    } else if (header->info.layout == HT_LAYOUT_SLOTTED) {
+        SP_Get(data, slottedSpace(header), slot, record);
+    } else {
+        memcpy(record, data + slot * sizeof (Record), sizeof (Record));
+    }
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
     BF_Block *block = NULL;
-    BF_Block_Init(&block);
+    BF_Block_InitInPlace(handle, &block);
     return block;
 }
 
-static int flushBlock(BF_Block **block) {
-    BF_Block_SetDirty(*block);
-    CALL_BF(BF_UnpinBlock(*block), true, HT_ERROR);
-    BF_Block_Destroy(block);
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, HT_ERROR);
     return BF_OK;
 }
 
-static int dumpBlock(BF_Block **block, bool unpin) {
-    if (unpin) {
-        CALL_BF(BF_UnpinBlock(*block), true, HT_ERROR);
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, HT_ERROR);
+    return BF_OK;
+}
+
+/* Με ενεργό ημερολόγιο η επικεφαλίδα γράφεται στο block 0 μετά από κάθε
+ * εισαγωγή, ώστε η εισαγωγή να καταγράφεται ολόκληρη στο BF_Commit. */
+static int commitInsert(struct Header * header) {
+    if (!BF_LogActive()) {
+        return BF_OK;
     }
-    BF_Block_Destroy(block);
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(header->info.fd, 0, block), true, HT_ERROR);
+    memcpy(BF_Block_GetData(block), (void*) header, header->info.block_size);
+    CALL_BF(flushBlock(block), true, HT_ERROR);
+    CALL_BF(BF_Commit(), true, HT_ERROR);
     return BF_OK;
 }
 
 int HT_CreateFile(char *fileName, int buckets) {
+    return HT_CreateFileEx(fileName, buckets, HT_LAYOUT_ROW);
+}
+
+int HT_CreateFileEx(char *fileName, int buckets, int layout) {
     const int METHOD_ERROR_CODE = HT_ERROR;
-    union Header header = {0};
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
-    assignMagicWord(&header);
-    assignDensity(&header);
-    assignBuckets(&header, buckets);
-    assignHeads(&header);
+    int block_size;
 
     CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
     CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    if (buckets < 1 || buckets > maxBuckets(block_size)) {
+        fprintf(stderr, "ERROR: Invalid number of buckets :%d (max %d) \n", buckets, maxBuckets(block_size));
+        BF_CloseFile(fd1);
+        return METHOD_ERROR_CODE;
+    }
+
+    /* Φίλτρα ή λεξικό που έμειναν από παλαιότερο αρχείο με το ίδιο όνομα
+     * δεν ισχύουν πια. */
+    const char * suffixes[] = {HT_BLOOM_SUFFIX, HT_DICT_SUFFIX};
+    for (int k = 0; k < 2; k++) {
+        char * side_name = sideFileName(fileName, suffixes[k]);
+        if (side_name != NULL) {
+            unlink(side_name);
+            free(side_name);
+        }
+    }
+
+    struct Header * header = calloc(1, block_size);
+    assignMagicWord(header);
+    assignBlockSize(header, block_size);
+    assignLayout(header, layout);
+    assignDensity(header);
+    assignBuckets(header, buckets);
+    assignHeads(header);
+
     CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
 
     char * data = BF_Block_GetData(block);
-    memcpy(data, &header, sizeof (union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, header, block_size);
+    free(header);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
 
+    if (layout == HT_LAYOUT_DICT) {
+        char * name = sideFileName(fileName, HT_DICT_SUFFIX);
+        if (name == NULL) {
+            return METHOD_ERROR_CODE;
+        }
+        int result = DC_CreateFile(name);
+        free(name);
+        return result;
+    }
+
     return 0;
 }
 
+int HT_CreateFileBloom(char *fileName, int buckets, int layout, int expected, double fp_rate) {
+    const int METHOD_ERROR_CODE = HT_ERROR;
+
+    if (HT_CreateFileEx(fileName, buckets, layout) != 0) {
+        return METHOD_ERROR_CODE;
+    }
+
+    char * name = sideFileName(fileName, HT_BLOOM_SUFFIX);
+    if (name == NULL) {
+        return METHOD_ERROR_CODE;
+    }
+    int result = BL_CreateFile(name, buckets, (expected + buckets - 1) / buckets, fp_rate);
+    free(name);
+    return result;
+}
+
 HT_info* HT_OpenFile(char *fileName) {
+    return HT_OpenFileEx(fileName, BF_FILE_POOL);
+}
+
+HT_info* HT_OpenFileEx(char *fileName, int mode) {
     static HT_info * METHOD_ERROR_CODE = NULL;
-    union Header * header = calloc(1, sizeof (union Header));
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
+    int block_size;
 
-    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFileEx(fileName, &fd1, mode), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    struct Header * header = calloc(1, block_size + HT_RUNTIME_BYTES);
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy((void*) header, data, sizeof (union Header));
-    CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+    memcpy((void*) header, data, block_size);
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
 
     header->info.fd = fd1;
 
@@ -126,21 +309,60 @@ HT_info* HT_OpenFile(char *fileName) {
         return NULL;
     }
 
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    char * bloom_name = sideFileName(fileName, HT_BLOOM_SUFFIX);
+    if (bloom_name == NULL) {
+        return NULL;
+    }
+    if (access(bloom_name, F_OK) == 0) {
+        *bloomFilters(header) = BL_OpenFile(bloom_name);
+        if (*bloomFilters(header) == NULL) {
+            fprintf(stderr, "ERROR: Cannot open bloom filter of %s \n", fileName); \
+            free(bloom_name);
+            return NULL;
+        }
+    }
+    free(bloom_name);
+
+    if (header->info.layout == HT_LAYOUT_DICT) {
+        char * dict_name = sideFileName(fileName, HT_DICT_SUFFIX);
+        if (dict_name == NULL) {
+            return NULL;
+        }
+        *dictionary(header) = DC_OpenFile(dict_name);
+        free(dict_name);
+        if (*dictionary(header) == NULL) {
+            fprintf(stderr, "ERROR: Cannot open dictionary of %s \n", fileName); \
+            return NULL;
+        }
+    }
+
     return (HT_info*) header;
 }
 
 int HT_CloseFile(HT_info* HT_info) {
     const int METHOD_ERROR_CODE = HT_ERROR;
-    union Header * header = (union Header *) HT_info;
+    struct Header * header = (struct Header *) HT_info;
     int fd1 = header->info.fd;
 
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
 
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy(data, (void*) header, sizeof (union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, (void*) header, header->info.block_size);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
+    if (*bloomFilters(header) != NULL) {
+        CALL_BF(BL_CloseFile(*bloomFilters(header)), true, METHOD_ERROR_CODE);
+    }
+    if (*dictionary(header) != NULL) {
+        CALL_BF(DC_CloseFile(*dictionary(header)), true, METHOD_ERROR_CODE);
+    }
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
 
     free(header);
@@ -152,81 +374,84 @@ int HT_CloseFile(HT_info* HT_info) {
 
 int HT_InsertEntry(HT_info* ht_info, Record record) {
     const int METHOD_ERROR_CODE = HT_ERROR;
-    union Header * header = (union Header *) ht_info;
+    struct Header * header = (struct Header *) ht_info;
     int fd1 = header->info.fd;
 
     int bucket = hash(record.id) % header->info.buckets;
 
+    if (*bloomFilters(header) != NULL) {
+        CALL_BF(BL_Add(*bloomFilters(header), bucket, record.id), true, METHOD_ERROR_CODE);
+    }
+
+    /* Η εγγραφή κωδικοποιείται μία φορά, πριν βρεθεί το block της. */
+    DC_tuple tuple;
+    if (header->info.layout == HT_LAYOUT_DICT && DC_EncodeRecord(*dictionary(header), &record, &tuple) != 0) {
+        return METHOD_ERROR_CODE;
+    }
+
     if (header->head[bucket] == -1) {
-        int offset = 0;
         int block_num = 0;
 
-        BF_GetBlockCounter(fd1, &block_num);
-
-        BF_Block *block = allocateMemoryBlock();
-        CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
-        CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
+        BF_BlockHandle handle;
+        BF_Block *block = allocateMemoryBlock(&handle);
+        CALL_BF(BF_AllocateBlockEx(fd1, block, &block_num), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        memcpy(data + offset * sizeof (record), &record, sizeof (Record));
 
-        HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
-        info->records = 1;
+        HT_block_info * info = blockInfo(header, data);
+        info->records = 0;
         info->next_block = -1;
+        putRecord(header, data, &record, &tuple);
         header->head[bucket] = block_num;
 
-        CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
         printf("Inserted: ");
         printRecord(record);
         
         header->info.records++;
+        CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
 
         return block_num;
     }
 
     int block_num = header->head[bucket];
 
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
     while (1) {
-        BF_Block *block = allocateMemoryBlock();
         CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
+        HT_block_info * info = blockInfo(header, data);
 
-        if (info->records == header->info.density) {
+        if (!putRecord(header, data, &record, &tuple)) {
             if (info->next_block != -1) {
                 block_num = info->next_block;
-                CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+                CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
                 continue;
             }
 
             int block_num = 0;
 
-            BF_GetBlockCounter(fd1, &block_num);
-
             {
-                int offset = 0;
-                BF_Block *block = allocateMemoryBlock();
-                CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
-                CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
+                BF_BlockHandle handle;
+                BF_Block *block = allocateMemoryBlock(&handle);
+                CALL_BF(BF_AllocateBlockEx(fd1, block, &block_num), true, METHOD_ERROR_CODE);
                 char * data = BF_Block_GetData(block);
-                memcpy(data + offset * sizeof (record), &record, sizeof (Record));
 
-                HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
-                info->records = 1;
+                HT_block_info * info = blockInfo(header, data);
+                info->records = 0;
                 info->next_block = -1;
-                CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+                putRecord(header, data, &record, &tuple);
+                CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
             }
 
             info->next_block = block_num;
-            CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+            CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
             break;
         }
 
-        int offset = info->records;
-        memcpy(data + offset * sizeof (record), &record, sizeof (Record));
-
-        info->records++;
-        CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE)
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE)
         break;
     }
     
@@ -234,33 +459,46 @@ int HT_InsertEntry(HT_info* ht_info, Record record) {
     printRecord(record);
     
     header->info.records++;
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
     
     return block_num;
 }
 
 int HT_GetAllEntries(HT_info* ht_info, int value) {
     const int METHOD_ERROR_CODE = HT_ERROR;
-    union Header * header = (union Header *) ht_info;
+    struct Header * header = (struct Header *) ht_info;
     int fd1 = header->info.fd;
     int blocks = 0;
     bool found = false;
 
     int bucket = hash(value) % header->info.buckets;
 
+    /* Αν το φίλτρο του κάδου απορρίπτει το id, η αλυσίδα δεν διαβάζεται. */
+    if (*bloomFilters(header) != NULL) {
+        int found = BL_MayContain(*bloomFilters(header), bucket, value);
+        if (found <= 0) {
+            return (found == 0) ? 1 : METHOD_ERROR_CODE;
+        }
+        blocks++;
+    }
+
     int block_num = header->head[bucket];
 
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
     while (block_num != -1 && !found) {
         blocks++;
 
-        BF_Block *block = allocateMemoryBlock();
         CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
+        HT_block_info * info = blockInfo(header, data);
 
         for (int j = 0; j < info->records; j++) {
-            Record * record = (Record *) (data + j * sizeof (Record));
-            if (record->id == value) {
-                printRecord(*record);
+            if (recordId(header, data, j) == value) {
+                Record record;
+                getRecord(header, data, j, &record);
+                printRecord(record);
                 found = true;
                 break;
             }
@@ -268,74 +506,113 @@ int HT_GetAllEntries(HT_info* ht_info, int value) {
 
         block_num = info->next_block;
 
-        CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+        CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
     }
 
     return blocks;
 }
 
+DC_info* HT_Dictionary(HT_info* ht_info) {
+    return *dictionary((struct Header *) ht_info);
+}
+
 int HT_HashStatistics(char * filename) {
     const int METHOD_ERROR_CODE = HT_ERROR;
     HT_info* ht_info = HT_OpenFile(filename);
-    union Header * header = (union Header *) ht_info;
+    struct Header * header = (struct Header *) ht_info;
     int fd1 = header->info.fd;
     int blocks = 0;
+    int buckets = header->info.buckets;
 
     BF_GetBlockCounter(fd1, &blocks);
 
-    printf("%5s %12s %12s %12s %12s %12s %12s \n", "Bucket", "Blocks", "Records", "Min/block", "Max/block", "Avg/block", "Overflow");
+    /*
+     * Κάθε block περιέχει εγγραφές ενός μόνο κάδου, οπότε ο κάδος του
+     * βρίσκεται από την πρώτη του εγγραφή. Έτσι το αρχείο διαβάζεται
+     * σειριακά σε ομάδες με την BF_GetBlocks αντί να ακολουθούνται οι
+     * αλυσίδες block προς block.
+     */
+    int * bucket_blocks = calloc(buckets, sizeof (int));
+    int * min = malloc(sizeof (int) * buckets);
+    int * max = calloc(buckets, sizeof (int));
+    int * sum = calloc(buckets, sizeof (int));
+
+    for (int bucket = 0; bucket < buckets; bucket++) {
+        min[bucket] = INT_MAX;
+    }
 
-    int bucket_min = INT_MAX, bucket_max = 0, bucket_sum = 0, bucket_block_sum = 0, overflow_buckets = 0;
+    BF_BlockHandle handles[HT_BATCH];
+    BF_Block *batch[HT_BATCH];
+    int block_nums[HT_BATCH];
 
-    for (int bucket = 0; bucket < header->info.buckets; bucket++) {
-        int block_num = header->head[bucket];
-        int min = INT_MAX, max = 0, sum = 0;
-        int bucket_blocks = 0;
+    for (int k = 0; k < HT_BATCH; k++) {
+        batch[k] = allocateMemoryBlock(&handles[k]);
+    }
 
-        while (block_num != -1) {
-            bucket_blocks++;
+    for (int first = 1; first < blocks; first += HT_BATCH) {
+        int n = (blocks - first < HT_BATCH) ? blocks - first : HT_BATCH;
 
-            BF_Block *block = allocateMemoryBlock();
-            CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
-            char * data = BF_Block_GetData(block);
-            HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
+        for (int k = 0; k < n; k++) {
+            block_nums[k] = first + k;
+        }
 
-            if (info->records < min) {
-                min = info->records;
-            }
+        CALL_BF(BF_GetBlocks(fd1, block_nums, n, batch), true, METHOD_ERROR_CODE);
 
-            if (info->records > max) {
-                max = info->records;
-            }
+        for (int k = 0; k < n; k++) {
+            char * data = BF_Block_GetData(batch[k]);
+            HT_block_info * info = blockInfo(header, data);
+
+            if (info->records > 0) {
+                int bucket = hash(recordId(header, data, 0)) % buckets;
 
-            sum = sum + info->records;
+                bucket_blocks[bucket]++;
 
-            block_num = info->next_block;
+                if (info->records < min[bucket]) {
+                    min[bucket] = info->records;
+                }
 
-            CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+                if (info->records > max[bucket]) {
+                    max[bucket] = info->records;
+                }
+
+                sum[bucket] = sum[bucket] + info->records;
+            }
+
+            CALL_BF(dumpBlock(batch[k]), true, METHOD_ERROR_CODE);
         }
+    }
+
+    printf("%5s %12s %12s %12s %12s %12s %12s \n", "Bucket", "Blocks", "Records", "Min/block", "Max/block", "Avg/block", "Overflow");
+
+    int bucket_min = INT_MAX, bucket_max = 0, bucket_sum = 0, bucket_block_sum = 0, overflow_buckets = 0;
 
-        float avg = (float) sum / bucket_blocks;
+    for (int bucket = 0; bucket < buckets; bucket++) {
+        float avg = (float) sum[bucket] / bucket_blocks[bucket];
 
-        printf("%5d %12d %12d %12d %12d %12.2f %12s \n", bucket, bucket_blocks, sum, min, max, avg, (bucket_blocks > 1) ? "true" : "false");
+        printf("%5d %12d %12d %12d %12d %12.2f %12s \n", bucket, bucket_blocks[bucket], sum[bucket], min[bucket], max[bucket], avg, (bucket_blocks[bucket] > 1) ? "true" : "false");
 
-        if (sum < bucket_min) {
-            bucket_min = sum;
+        if (sum[bucket] < bucket_min) {
+            bucket_min = sum[bucket];
         }
 
-        if (sum > bucket_max) {
-            bucket_max = sum;
+        if (sum[bucket] > bucket_max) {
+            bucket_max = sum[bucket];
         }
 
-        bucket_sum = bucket_sum + sum;
+        bucket_sum = bucket_sum + sum[bucket];
 
-        bucket_block_sum = bucket_block_sum + bucket_blocks;
+        bucket_block_sum = bucket_block_sum + bucket_blocks[bucket];
 
-        if ((bucket_blocks > 1)) {
+        if ((bucket_blocks[bucket] > 1)) {
             overflow_buckets++;
         }
     }
 
+    free(bucket_blocks);
+    free(min);
+    free(max);
+    free(sum);
+
     printf("Total file blocks          : %d \n", blocks);
     printf("Min records per bucket     : %d \n", bucket_min);
     printf("Max records per bucket     : %d \n", bucket_max);
@@ -343,6 +620,16 @@ int HT_HashStatistics(char * filename) {
     printf("Avg blocks  per bucket     : %.2f \n", bucket_block_sum / (float) header->info.buckets);
     printf("Total buckets with overflow: %d \n", overflow_buckets);
 
+    BF_Stats stats;
+
+    CALL_BF(BF_GetStats(fd1, &stats), true, METHOD_ERROR_CODE);
+    printf("Buffer pool, statistics scan: \n");
+    BF_PrintStats(&stats);
+
+    CALL_BF(BF_GetGlobalStats(&stats), true, METHOD_ERROR_CODE);
+    printf("Buffer pool, all files since BF_Init: \n");
+    BF_PrintStats(&stats);
+
     HT_CloseFile(ht_info);
 
     return 0;
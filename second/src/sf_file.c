@@ -0,0 +1,572 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include "bf.h"
+#include "sf_file.h"
+#include "record.h"
+
+static int sf_errors = 0;
+
+#define CALL_BF(call, printError, error_code)       \
+{                           \
+  BF_ErrorCode code = call; \
+  if (code != BF_OK) {         \
+    if (printError) {\
+        sf_errors++; \
+        BF_PrintError(code);    \
+        fprintf(stderr, "code: %d \n", code); \
+    }\
+    return error_code;\
+  } \
+}
+
+/* Στο block 0 αποθηκεύονται τα πρώτα SF_HEADER_BYTES: η SF_info και το
+ * μεγαλύτερο ταξινομημένο id. Όσο το αρχείο είναι ανοιχτό, το cache
+ * κρατάει ταξινομημένο αντίγραφο της περιοχής αλλαγών, ώστε οι αναζητήσεις
+ * και η συγχώνευση να μην διαβάζουν τα block της. */
+struct Header {
+    char prefix[3];
+    SF_info info;
+    int last_id;
+    Record * cache;
+};
+
+#define SF_HEADER_BYTES offsetof(struct Header, cache)
+
+typedef struct {
+    int records;
+    int next_block;
+} SF_block_info;
+
+/*
+ * Η εγγραφή με θέση pos (0, 1, ...) βρίσκεται στο block 1 + pos / density,
+ * στην υποδοχή pos % density. Οι ταξινομημένες εγγραφές έχουν θέσεις
+ * 0 έως sorted - 1 και η περιοχή αλλαγών ξεκινάει στο επόμενο ολόκληρο
+ * block. Μετά από μια συγχώνευση τα block που περισσεύουν μένουν στο
+ * αρχείο και ξαναχρησιμοποιούνται.
+ */
+
+static char SF_PREFIX[3] = "SF";
+static int SF_ERROR = -1;
+
+static void assignMagicWord(struct Header * header) {
+    strncpy(header->prefix, SF_PREFIX, strlen(SF_PREFIX) + 1);
+}
+
+static void assignBlockSize(struct Header * header, int block_size) {
+    header->info.block_size = block_size;
+}
+
+static void assignDensity(struct Header * header) {
+    header->info.density = (header->info.block_size - sizeof(SF_block_info))/sizeof(Record);
+}
+
+static void assignDeltaBlocks(struct Header * header, int delta_blocks) {
+    header->info.delta_blocks = delta_blocks;
+}
+
+static SF_block_info * blockInfo(struct Header * header, char * data) {
+    return (SF_block_info *)(data + header->info.block_size - sizeof(SF_block_info));
+}
+
+static Record * recordAt(char * data, int slot) {
+    return (Record *) (data + slot*sizeof(Record));
+}
+
+static int sortedBlocks(struct Header * header) {
+    return (header->info.sorted + header->info.density - 1) / header->info.density;
+}
+
+static int deltaPosition(struct Header * header) {
+    return sortedBlocks(header) * header->info.density;
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
+    BF_Block *block = NULL;
+    BF_Block_InitInPlace(handle, &block);
+    return block;
+}
+
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, SF_ERROR);
+    return BF_OK;
+}
+
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, SF_ERROR);
+    return BF_OK;
+}
+
+/* Φέρνει το block block_num, ή το δεσμεύει αν είναι το επόμενο μετά το
+ * τέλος του αρχείου. */
+static int getOrAllocate(int fd, int block_num, BF_Block * block) {
+    int blocks;
+    CALL_BF(BF_GetBlockCounter(fd, &blocks), true, SF_ERROR);
+    if (block_num < blocks) {
+        CALL_BF(BF_GetBlock(fd, block_num, block), true, SF_ERROR);
+    } else {
+        CALL_BF(BF_AllocateBlock(fd, block), true, SF_ERROR);
+    }
+    return BF_OK;
+}
+
+/* Γράφει την επικεφαλίδα στο block 0 και, με ενεργό ημερολόγιο, κάνει
+ * BF_Commit, ώστε κάθε εισαγωγή και συγχώνευση να καταγράφεται ολόκληρη. */
+static int commitHeader(struct Header * header) {
+    if (!BF_LogActive()) {
+        return BF_OK;
+    }
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(header->info.fd, 0, block), true, SF_ERROR);
+    memcpy(BF_Block_GetData(block), (void*) header, SF_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, SF_ERROR);
+    CALL_BF(BF_Commit(), true, SF_ERROR);
+    return BF_OK;
+}
+
+static int compareIds(const void * a, const void * b) {
+    int x = ((const Record *) a)->id, y = ((const Record *) b)->id;
+    return (x > y) - (x < y);
+}
+
+/* Διαβάζει στο header->cache τις εγγραφές της περιοχής αλλαγών,
+ * ταξινομημένες κατά id. */
+static int loadDelta(struct Header * header) {
+    const int d = header->info.density;
+    const int first = deltaPosition(header);
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    header->cache = malloc(sizeof(Record) * header->info.delta_blocks * d);
+    if (header->cache == NULL) {
+        return SF_ERROR;
+    }
+
+    for (int k = 0; k < header->info.delta; k += d) {
+        CALL_BF(BF_GetBlock(header->info.fd, 1 + (first + k) / d, block), true, SF_ERROR);
+        char * data = BF_Block_GetData(block);
+        for (int slot = 0; slot < d && k + slot < header->info.delta; slot++) {
+            header->cache[k + slot] = *recordAt(data, slot);
+        }
+        CALL_BF(dumpBlock(block), true, SF_ERROR);
+    }
+
+    qsort(header->cache, header->info.delta, sizeof(Record), compareIds);
+    return BF_OK;
+}
+
+/* Η πρώτη θέση του cache με id >= value. */
+static int cacheBound(struct Header * header, int value) {
+    int left = 0, right = header->info.delta;
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (header->cache[mid].id < value) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+int SF_CreateFile(char *fileName, int delta_blocks) {
+    const int METHOD_ERROR_CODE = SF_ERROR;
+    struct Header header = {0};
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    if (delta_blocks < 1) {
+        fprintf(stderr, "ERROR: Invalid number of delta blocks :%d \n", delta_blocks);
+        return METHOD_ERROR_CODE;
+    }
+
+    CALL_BF(BF_CreateFile(fileName), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    assignMagicWord(&header);
+    assignBlockSize(&header, block_size);
+    assignDensity(&header);
+    assignDeltaBlocks(&header, delta_blocks);
+
+    CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
+
+    char * data = BF_Block_GetData(block);
+    memcpy(data, &header, SF_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    return 0;
+}
+
+SF_info* SF_OpenFile(char *fileName) {
+    static SF_info * METHOD_ERROR_CODE = NULL;
+    struct Header * header = calloc(1, sizeof (struct Header));
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+    int fd1;
+    int block_size;
+
+    CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy((void*) header, data, SF_HEADER_BYTES);
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
+
+    header->info.fd = fd1;
+
+    fprintf(stderr, "SF File opened: fd:%d, density: %d \n", header->info.fd, header->info.density); \
+
+    if (strncmp(header->prefix, "SF", 2 ) != 0) {
+        fprintf(stderr, "ERROR: Invalid MAGIC word :%s \n", header->prefix); \
+        return NULL;
+    }
+
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
+    if (loadDelta(header) != BF_OK) {
+        fprintf(stderr, "ERROR: Cannot read delta area of %s \n", fileName); \
+        return NULL;
+    }
+
+    return (SF_info*) header;
+}
+
+int SF_CloseFile(SF_info* sf_info) {
+    const int METHOD_ERROR_CODE = SF_ERROR;
+    struct Header * header = (struct Header *) sf_info;
+    int fd1 = header->info.fd;
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    memcpy(data, (void*) header, SF_HEADER_BYTES);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
+
+    free (header->cache);
+    free (header);
+
+    printf("\nSF File closed, SF_ERRORS: %d \n", sf_errors); \
+
+    return 0;
+}
+
+int SF_InsertEntry(SF_info* sf_info, Record record) {
+    const int METHOD_ERROR_CODE = SF_ERROR;
+    struct Header * header = (struct Header *) sf_info;
+    const int d = header->info.density;
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    /* Μια εγγραφή με αύξουσα σειρά id μπαίνει στο τέλος των ταξινομημένων,
+     * εκτός αν θα χρειαζόταν νέο block ενώ η περιοχή αλλαγών δεν είναι άδεια. */
+    bool in_order = header->info.sorted == 0 || record.id >= header->last_id;
+    bool sorted = in_order && (header->info.delta == 0 || header->info.sorted % d != 0);
+
+    /* Αν η περιοχή αλλαγών είναι γεμάτη, συγχωνεύεται πριν γραφτεί η
+     * εγγραφή, ώστε το block που επιστρέφεται να είναι η θέση της. Αν
+     * αποτύχει η συγχώνευση, η εισαγωγή αποτυγχάνει χωρίς καμία αλλαγή. */
+    if (!sorted && header->info.delta >= header->info.delta_blocks * d) {
+        CALL_BF(SF_Merge(sf_info), false, METHOD_ERROR_CODE);
+        in_order = header->info.sorted == 0 || record.id >= header->last_id;
+        sorted = in_order;
+    }
+    const int pos = sorted ? header->info.sorted : deltaPosition(header) + header->info.delta;
+    const int block_num = 1 + pos / d;
+
+    CALL_BF(getOrAllocate(header->info.fd, block_num, block), true, METHOD_ERROR_CODE);
+    char * data = BF_Block_GetData(block);
+    *recordAt(data, pos % d) = record;
+    blockInfo(header, data)->records = pos % d + 1;
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
+
+    if (sorted) {
+        header->info.sorted++;
+        header->last_id = record.id;
+    } else {
+        const int at = record.id < INT_MAX ? cacheBound(header, record.id + 1) : header->info.delta;
+        memmove(header->cache + at + 1, header->cache + at, (header->info.delta - at) * sizeof(Record));
+        header->cache[at] = record;
+        header->info.delta++;
+    }
+    header->info.records++;
+
+    printf("Inserted: ");
+    printRecord(record);
+
+    CALL_BF(commitHeader(header), false, METHOD_ERROR_CODE);
+
+    return block_num;
+}
+
+/* Καρφιτσώνει στο block το block της θέσης pos, αφού ξεκαρφιτσώσει αυτό
+ * που κρατούσε (ως dirty αν dirty). Το *pinned είναι ο αριθμός του
+ * καρφιτσωμένου block ή -1. */
+static int pinPosition(struct Header * header, BF_Block * block, int * pinned, int pos, bool dirty) {
+    const int block_num = 1 + pos / header->info.density;
+    if (*pinned == block_num) {
+        return BF_OK;
+    }
+    if (*pinned >= 0) {
+        CALL_BF(dirty ? flushBlock(block) : dumpBlock(block), true, SF_ERROR);
+        *pinned = -1;
+    }
+    CALL_BF(BF_GetBlock(header->info.fd, block_num, block), true, SF_ERROR);
+    *pinned = block_num;
+    return BF_OK;
+}
+
+int SF_Merge(SF_info* sf_info) {
+    const int METHOD_ERROR_CODE = SF_ERROR;
+    struct Header * header = (struct Header *) sf_info;
+    const int d = header->info.density;
+    const int n = header->info.delta;
+    const int total = header->info.sorted + n;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    const Record * delta = header->cache;
+
+    /* Συγχώνευση από το τέλος: η θέση εγγραφής p είναι πάντα μετά την θέση
+     * ανάγνωσης i, οπότε κάθε ταξινομημένη εγγραφή διαβάζεται πριν
+     * γραφτεί κάτι στην θέση της. Όταν τελειώσουν οι εγγραφές της περιοχής
+     * αλλαγών, οι υπόλοιπες ταξινομημένες είναι ήδη στην θέση τους. */
+    BF_BlockHandle src_handle, dst_handle;
+    BF_Block *src = allocateMemoryBlock(&src_handle);
+    BF_Block *dst = allocateMemoryBlock(&dst_handle);
+    int src_block = -1, dst_block = -1;
+    int i = header->info.sorted - 1, j = n - 1;
+    int result = BF_OK;
+
+    for (int p = total - 1; j >= 0 && result == BF_OK; p--) {
+        Record record = delta[j];
+        if (i >= 0) {
+            result = pinPosition(header, src, &src_block, i, false);
+            if (result != BF_OK) {
+                break;
+            }
+            const Record * sorted = recordAt(BF_Block_GetData(src), i % d);
+            if (sorted->id > record.id) {
+                record = *sorted;
+                i--;
+            } else {
+                j--;
+            }
+        } else {
+            j--;
+        }
+
+        const int previous = dst_block;
+        result = pinPosition(header, dst, &dst_block, p, true);
+        if (result == BF_OK && previous != dst_block) {
+            const int first = (dst_block - 1) * d;
+            blockInfo(header, BF_Block_GetData(dst))->records = total - first < d ? total - first : d;
+        }
+        if (result == BF_OK) {
+            *recordAt(BF_Block_GetData(dst), p % d) = record;
+        }
+    }
+
+    if (src_block >= 0 && dumpBlock(src) != BF_OK) {
+        result = SF_ERROR;
+    }
+    if (dst_block >= 0 && flushBlock(dst) != BF_OK) {
+        result = SF_ERROR;
+    }
+    if (result != BF_OK) {
+        return METHOD_ERROR_CODE;
+    }
+
+    if (header->info.sorted == 0 || delta[n - 1].id > header->last_id) {
+        header->last_id = delta[n - 1].id;
+    }
+    header->info.sorted = total;
+    header->info.delta = 0;
+
+    CALL_BF(commitHeader(header), false, METHOD_ERROR_CODE);
+    return 0;
+}
+
+/*
+ * Η σάρωση βρίσκει με δυαδική αναζήτηση την πρώτη ταξινομημένη εγγραφή με
+ * id >= low και προχωράει μέχρι να βρει id > high. Οι εγγραφές της περιοχής
+ * αλλαγών που ταιριάζουν είναι οι θέσεις delta_next έως delta_end - 1 του
+ * cache και συγχωνεύονται με τις ταξινομημένες, ώστε όλες να επιστρέφονται
+ * με αύξουσα σειρά id.
+ */
+struct SF_Scan {
+    struct Header * header;
+    int low;
+    int high;
+    int pos;
+    int end;
+    int block_num;
+    int blocks_read;
+    bool error;
+    BF_BlockHandle handle;
+    BF_Block *block;
+    int delta_next;
+    int delta_end;
+};
+
+static int scanPin(SF_Scan * scan, int block_num) {
+    if (scan->block_num == block_num) {
+        return BF_OK;
+    }
+    if (scan->block_num >= 0) {
+        CALL_BF(dumpBlock(scan->block), true, SF_ERROR);
+        scan->block_num = -1;
+    }
+    CALL_BF(BF_GetBlock(scan->header->info.fd, block_num, scan->block), true, SF_ERROR);
+    scan->block_num = block_num;
+    scan->blocks_read++;
+    return BF_OK;
+}
+
+/* Το μεγαλύτερο id του ταξινομημένου block block_num. */
+static int lastId(SF_Scan * scan, int block_num) {
+    const int d = scan->header->info.density;
+    const int count = scan->header->info.sorted - (block_num - 1) * d;
+    return recordAt(BF_Block_GetData(scan->block), (count < d ? count : d) - 1)->id;
+}
+
+/* Θέτει στο scan->pos την θέση της πρώτης ταξινομημένης εγγραφής με
+ * id >= low, ή sorted αν δεν υπάρχει. */
+static int lowerBound(SF_Scan * scan) {
+    struct Header * header = scan->header;
+    const int d = header->info.density;
+    int lo = 1, hi = sortedBlocks(header);
+
+    scan->pos = header->info.sorted;
+    if (header->info.sorted == 0 || header->last_id < scan->low) {
+        return BF_OK;
+    }
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        CALL_BF(scanPin(scan, mid), false, SF_ERROR);
+        if (lastId(scan, mid) < scan->low) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    CALL_BF(scanPin(scan, lo), false, SF_ERROR);
+
+    const int first = (lo - 1) * d;
+    int left = 0, right = header->info.sorted - first < d ? header->info.sorted - first : d;
+    char * data = BF_Block_GetData(scan->block);
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (recordAt(data, mid)->id < scan->low) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    scan->pos = first + left;
+    return BF_OK;
+}
+
+SF_Scan* SF_ScanOpenRange(SF_info* sf_info, int low, int high) {
+    SF_Scan * scan = calloc(1, sizeof (SF_Scan));
+    if (scan == NULL) {
+        return NULL;
+    }
+
+    struct Header * header = (struct Header *) sf_info;
+    scan->header = header;
+    scan->low = low;
+    scan->high = high;
+    scan->end = header->info.sorted;
+    scan->block_num = -1;
+    scan->block = allocateMemoryBlock(&scan->handle);
+
+    if (low > high) {
+        scan->pos = scan->end;
+        return scan;
+    }
+
+    scan->delta_next = cacheBound(header, low);
+    scan->delta_end = high < INT_MAX ? cacheBound(header, high + 1) : header->info.delta;
+    if (lowerBound(scan) != BF_OK) {
+        SF_ScanClose(scan);
+        return NULL;
+    }
+    return scan;
+}
+
+const Record* SF_ScanNext(SF_Scan* scan) {
+    const Record * sorted = NULL;
+    const int d = scan->header->info.density;
+
+    if (scan->error) {
+        return NULL;
+    }
+    if (scan->pos < scan->end) {
+        if (scanPin(scan, 1 + scan->pos / d) != BF_OK) {
+            scan->error = true;
+            return NULL;
+        }
+        sorted = recordAt(BF_Block_GetData(scan->block), scan->pos % d);
+        if (sorted->id > scan->high) {
+            scan->end = scan->pos;
+            sorted = NULL;
+        }
+    }
+
+    const Record * delta = scan->delta_next < scan->delta_end ? &scan->header->cache[scan->delta_next] : NULL;
+    if (delta != NULL && (sorted == NULL || delta->id < sorted->id)) {
+        scan->delta_next++;
+        return delta;
+    }
+    if (sorted != NULL) {
+        scan->pos++;
+    }
+    return sorted;
+}
+
+int SF_ScanClose(SF_Scan* scan) {
+    if (scan->block_num >= 0 && dumpBlock(scan->block) != BF_OK) {
+        scan->error = true;
+    }
+
+    int blocks = scan->error ? SF_ERROR : scan->blocks_read;
+    free(scan);
+    return blocks;
+}
+
+int SF_GetAllEntries(SF_info* sf_info, int value) {
+    SF_Scan * scan = SF_ScanOpenRange(sf_info, value, value);
+    if (scan == NULL) {
+        return SF_ERROR;
+    }
+
+    const Record * record;
+    while ((record = SF_ScanNext(scan)) != NULL) {
+        printRecord(*record);
+    }
+    return SF_ScanClose(scan);
+}
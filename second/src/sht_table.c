@@ -7,6 +7,8 @@
 #include "bf.h"
 #include "sht_table.h"
 #include "ht_table.h"
+#include "slotted_page.h"
+#include "dictionary.h"
 #include "record.h"
 
 static int sht_errors = 0;
@@ -29,30 +31,52 @@ typedef struct SecondaryRecord {
     int block_id;
 } SecondaryRecord;
 
-union HtHeader {
+struct HtHeader {
+    char prefix[3];
+    HT_info info;
+    int head[];
+};
 
-    struct {
-        char prefix[3];
-        HT_info info;
-        int head[(BF_BLOCK_SIZE - 2 - sizeof (HT_info)) / 4];
-    };
-    char block[BF_BLOCK_SIZE];
+struct Header {
+    char prefix[4];
+    SHT_info info;
+    int head[];
 };
 
-union Header {
+/* Πλήθος block του πρωτεύοντος ευρετηρίου που διαβάζονται μαζί. */
+#define SHT_BATCH 8
 
-    struct {
-        char prefix[4];
-        SHT_info info;
-        int head[(BF_BLOCK_SIZE - 4 - sizeof (SHT_info)) / 4];
-    };
-    char block[BF_BLOCK_SIZE];
-};
+/* Η εγγραφή slot ενός block του πρωτεύοντος ευρετηρίου. Στις μορφές
+ * HT_LAYOUT_SLOTTED και HT_LAYOUT_DICT ανασυντίθεται στο copy. */
+static Record * primaryRecord(struct HtHeader * htheader, char * data, int slot, Record * copy) {
+    if (htheader->info.layout == HT_LAYOUT_DICT) {
+        DC_DecodeRecord(HT_Dictionary((HT_info *) htheader), (const DC_tuple *) data + slot, copy);
+        return copy;
+    }
+    if (htheader->info.layout == HT_LAYOUT_SLOTTED) {
+        SP_Get(data, htheader->info.block_size - sizeof (HT_block_info), slot, copy);
+        return copy;
+    }
+    return (Record *) (data + slot * sizeof (Record));
+}
+
+/* Το πεδίο του λεξικού για το όνομα πεδίου attribute, ή ID για πεδία
+ * που δεν κωδικοποιούνται. */
+static Record_Attribute codedAttribute(const char * attribute) {
+    if (strcmp(attribute, "name") == 0) {
+        return NAME;
+    } else if (strcmp(attribute, "surname") == 0) {
+        return SURNAME;
+    } else if (strcmp(attribute, "city") == 0) {
+        return CITY;
+    }
+    return ID;
+}
 
 static char SHT_PREFIX[4] = "SHT";
 static int SHT_ERROR = -1;
 
-static void assignMagicWord(union Header * header) {
+static void assignMagicWord(struct Header * header) {
     strncpy(header->prefix, SHT_PREFIX, strlen(SHT_PREFIX) + 1);
 }
 
@@ -67,72 +91,151 @@ unsigned int hash(char *str) {
     return hash;
 }
 
-static void assignDensity(union Header * header) {
-    header->info.density = (BF_BLOCK_SIZE - sizeof (HT_info)) / sizeof (Record);
+static int maxBuckets(int block_size) {
+    return (block_size - sizeof (struct Header)) / sizeof (int);
+}
+
+static void assignBlockSize(struct Header * header, int block_size) {
+    header->info.block_size = block_size;
+}
+
+static void assignDensity(struct Header * header) {
+    header->info.density = (header->info.block_size - sizeof (SHT_block_info)) / sizeof (SecondaryRecord);
 }
 
-static void assignBuckets(union Header * header, int buckets) {
+static void assignBuckets(struct Header * header, int buckets) {
     header->info.buckets = buckets;
 }
 
-static void assignAttribute(union Header * header, char * record_attribute) {
+static void assignAttribute(struct Header * header, char * record_attribute) {
     strcpy(header->info.record_attribute, record_attribute);
 }
 
-static void assignDatafile(union Header * header, char * fileName) {
+static void assignDatafile(struct Header * header, char * fileName) {
     strcpy(header->info.primary_data_file, fileName);
 }
 
-static void assignHeads(union Header * header) {
-    for (int i = 0; i < (BF_BLOCK_SIZE - 4 - sizeof (SHT_info)) / 4; i++) {
+static void assignHeads(struct Header * header) {
+    for (int i = 0; i < maxBuckets(header->info.block_size); i++) {
         header->head[i] = -1;
     }
 }
 
-static BF_Block * allocateMemoryBlock() {
+static SHT_block_info * blockInfo(struct Header * header, char * data) {
+    return (SHT_block_info *) (data + header->info.block_size - sizeof (SHT_block_info));
+}
+
+static BF_Block * allocateMemoryBlock(BF_BlockHandle * handle) {
     BF_Block *block = NULL;
-    BF_Block_Init(&block);
+    BF_Block_InitInPlace(handle, &block);
     return block;
 }
 
-static int flushBlock(BF_Block **block) {
-    BF_Block_SetDirty(*block);
-    CALL_BF(BF_UnpinBlock(*block), true, SHT_ERROR);
-    BF_Block_Destroy(block);
+static int flushBlock(BF_Block *block) {
+    BF_Block_SetDirty(block);
+    CALL_BF(BF_UnpinBlock(block), true, SHT_ERROR);
     return BF_OK;
 }
 
-static int dumpBlock(BF_Block **block, bool unpin) {
-    if (unpin) {
-        CALL_BF(BF_UnpinBlock(*block), true, SHT_ERROR);
+static int dumpBlock(BF_Block *block) {
+    CALL_BF(BF_UnpinBlock(block), true, SHT_ERROR);
+    return BF_OK;
+}
+
+/* Με ενεργό ημερολόγιο η επικεφαλίδα γράφεται στο block 0 μετά από κάθε
+ * εισαγωγή, ώστε η εισαγωγή να καταγράφεται ολόκληρη στο BF_Commit. */
+static int commitInsert(struct Header * header) {
+    if (!BF_LogActive()) {
+        return BF_OK;
     }
-    BF_Block_Destroy(block);
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    CALL_BF(BF_GetBlock(header->info.fd, 0, block), true, SHT_ERROR);
+    memcpy(BF_Block_GetData(block), (void*) header, header->info.block_size);
+    CALL_BF(flushBlock(block), true, SHT_ERROR);
+    CALL_BF(BF_Commit(), true, SHT_ERROR);
     return BF_OK;
 }
 
+/*
+ * Πίνακας που σημειώνει ποιες εγγραφές έχουν ήδη τυπωθεί σε μια αναζήτηση.
+ * Διατηρείται ανάμεσα στις κλήσεις και μια εγγραφή θεωρείται τυπωμένη μόνο
+ * αν έχει την τρέχουσα εποχή, οπότε δεν χρειάζεται ούτε δέσμευση ούτε
+ * μηδενισμός σε κάθε αναζήτηση. Ανήκει στο ανοιχτό ευρετήριο: κρατιέται
+ * στην μνήμη μετά το αντίγραφο του block 0 και ελευθερώνεται στο κλείσιμο.
+ */
+typedef struct SeenRecords {
+    unsigned int * seen;
+    int capacity;
+    unsigned int epoch;
+} SeenRecords;
+
+#define SHT_RUNTIME_BYTES (sizeof (SeenRecords))
+
+static SeenRecords * seenCache(struct Header * header) {
+    return (SeenRecords *) ((char *) header + header->info.block_size);
+}
+
+static SeenRecords * seenRecords(struct Header * header, int records) {
+    SeenRecords * cache = seenCache(header);
+
+    if (records > cache->capacity) {
+        unsigned int * seen = realloc(cache->seen, sizeof (unsigned int) * records);
+        if (seen == NULL) {
+            return NULL;
+        }
+        memset(seen + cache->capacity, 0, sizeof (unsigned int) * (records - cache->capacity));
+        cache->seen = seen;
+        cache->capacity = records;
+    }
+
+    cache->epoch++;
+    if (cache->epoch == 0) {
+        memset(cache->seen, 0, sizeof (unsigned int) * cache->capacity);
+        cache->epoch = 1;
+    }
+
+    return cache;
+}
+
 int SHT_CreateSecondaryIndex(char *sfileName, char * record_attribute, int buckets, char* fileName) {
     if (strlen(record_attribute) >= 15) {
         return SHT_ERROR;
     }
 
     const int METHOD_ERROR_CODE = SHT_ERROR;
-    union Header header = {0};
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
-    assignMagicWord(&header);
-    assignDensity(&header);
-    assignBuckets(&header, buckets);
-    assignAttribute(&header, record_attribute);
-    assignDatafile(&header, fileName);
-    assignHeads(&header);
+    int block_size;
 
     CALL_BF(BF_CreateFile(sfileName), true, METHOD_ERROR_CODE);
     CALL_BF(BF_OpenFile(sfileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+
+    if (buckets < 1 || buckets > maxBuckets(block_size)) {
+        fprintf(stderr, "ERROR: Invalid number of buckets :%d (max %d) \n", buckets, maxBuckets(block_size));
+        BF_CloseFile(fd1);
+        return METHOD_ERROR_CODE;
+    }
+
+    struct Header * header = calloc(1, block_size);
+    assignMagicWord(header);
+    assignBlockSize(header, block_size);
+    assignDensity(header);
+    assignBuckets(header, buckets);
+    assignAttribute(header, record_attribute);
+    assignDatafile(header, fileName);
+    assignHeads(header);
+
     CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
 
     char * data = BF_Block_GetData(block);
-    memcpy(data, &header, sizeof (union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, header, block_size);
+    free(header);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
 
@@ -142,15 +245,18 @@ int SHT_CreateSecondaryIndex(char *sfileName, char * record_attribute, int bucke
 
 SHT_info* SHT_OpenSecondaryIndex(char *fileName) {
     static SHT_info * METHOD_ERROR_CODE = NULL;
-    union Header * header = calloc(1, sizeof (union Header));
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
     int fd1;
+    int block_size;
 
     CALL_BF(BF_OpenFile(fileName, &fd1), true, METHOD_ERROR_CODE);
+    CALL_BF(BF_GetBlockSize(fd1, &block_size), true, METHOD_ERROR_CODE);
+    struct Header * header = calloc(1, block_size + SHT_RUNTIME_BYTES);
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy((void*) header, data, sizeof (union Header));
-    CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+    memcpy((void*) header, data, block_size);
+    CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
 
     header->info.fd = fd1;
 
@@ -161,23 +267,30 @@ SHT_info* SHT_OpenSecondaryIndex(char *fileName) {
         return NULL;
     }
 
+    if (header->info.block_size != block_size) {
+        fprintf(stderr, "ERROR: File block size %d, BF block size %d \n", header->info.block_size, block_size); \
+        return NULL;
+    }
+
     return (SHT_info*) header;
 }
 
 int SHT_CloseSecondaryIndex(SHT_info* SHT_info) {
     const int METHOD_ERROR_CODE = SHT_ERROR;
-    union Header * header = (union Header *) SHT_info;
+    struct Header * header = (struct Header *) SHT_info;
     int fd1 = header->info.fd;
 
-    BF_Block *block = allocateMemoryBlock();
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
 
     CALL_BF(BF_GetBlock(fd1, 0, block), true, METHOD_ERROR_CODE);
     char * data = BF_Block_GetData(block);
-    memcpy(data, (void*) header, sizeof (union Header));
-    CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+    memcpy(data, (void*) header, header->info.block_size);
+    CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
     CALL_BF(BF_CloseFile(fd1), true, METHOD_ERROR_CODE);
 
+    free(seenCache(header)->seen);
     free(header);
 
     printf("\nSHT File closed, SHT_ERRORS: %d \n", sht_errors); \
@@ -187,7 +300,7 @@ int SHT_CloseSecondaryIndex(SHT_info* SHT_info) {
 
 int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record original_record, int block_id) {
     const int METHOD_ERROR_CODE = SHT_ERROR;
-    union Header * header = (union Header *) sht_info;
+    struct Header * header = (struct Header *) sht_info;
     int fd1 = header->info.fd;
 
     SecondaryRecord record = {0};
@@ -211,63 +324,62 @@ int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record original_record, int blo
         int offset = 0;
         int block_num = 0;
 
-        BF_GetBlockCounter(fd1, &block_num);
-
-        BF_Block *block = allocateMemoryBlock();
-        CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
-        CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
+        BF_BlockHandle handle;
+        BF_Block *block = allocateMemoryBlock(&handle);
+        CALL_BF(BF_AllocateBlockEx(fd1, block, &block_num), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
         memcpy(data + offset * sizeof (record), &record, sizeof (SecondaryRecord));
 
-        SHT_block_info * info = (SHT_block_info *) (data + BF_BLOCK_SIZE - sizeof (SHT_block_info));
+        SHT_block_info * info = blockInfo(header, data);
         info->records = 1;
         info->next_block = -1;
         header->head[bucket] = block_num;
 
-        CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
 
         printf("Inserted (secondary index): (%s,%d) \n", record.key, record.block_id);
 
         header->info.records++;
+        CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
         
         return 0;
     }
 
     int block_num = header->head[bucket];
 
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
     while (1) {
-        BF_Block *block = allocateMemoryBlock();
         CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        SHT_block_info * info = (SHT_block_info *) (data + BF_BLOCK_SIZE - sizeof (SHT_block_info));
+        SHT_block_info * info = blockInfo(header, data);
 
         if (info->records == header->info.density) {
             if (info->next_block != -1) {
                 block_num = info->next_block;
-                CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+                CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
                 continue;
             }
 
             int block_num = 0;
 
-            BF_GetBlockCounter(fd1, &block_num);
-
             {
                 int offset = 0;
-                BF_Block *block = allocateMemoryBlock();
-                CALL_BF(BF_AllocateBlock(fd1, block), true, METHOD_ERROR_CODE);
-                CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
+                BF_BlockHandle handle;
+                BF_Block *block = allocateMemoryBlock(&handle);
+                CALL_BF(BF_AllocateBlockEx(fd1, block, &block_num), true, METHOD_ERROR_CODE);
                 char * data = BF_Block_GetData(block);
                 memcpy(data + offset * sizeof (record), &record, sizeof (SecondaryRecord));
 
-                SHT_block_info * info = (SHT_block_info *) (data + BF_BLOCK_SIZE - sizeof (SHT_block_info));
+                SHT_block_info * info = blockInfo(header, data);
                 info->records = 1;
                 info->next_block = -1;
-                CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+                CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
             }
 
             info->next_block = block_num;
-            CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE);
+            CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE);
             break;
         }
 
@@ -275,21 +387,22 @@ int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record original_record, int blo
         memcpy(data + offset * sizeof (record), &record, sizeof (SecondaryRecord));
 
         info->records++;
-        CALL_BF(flushBlock(&block), true, METHOD_ERROR_CODE)
+        CALL_BF(flushBlock(block), true, METHOD_ERROR_CODE)
         break;
     }
 
     printf("Inserted (secondary index): (%s,%d) \n", record.key, record.block_id);
     
     header->info.records++;
+    CALL_BF(commitInsert(header), false, METHOD_ERROR_CODE);
     
     return 0;
 }
 
 int SHT_SecondaryGetAllEntries(HT_info* ht_info, SHT_info* sht_info, char* value) {
     const int METHOD_ERROR_CODE = SHT_ERROR;
-    union Header * header = (union Header *) sht_info;
-    union HtHeader * htheader = (union HtHeader *) ht_info;
+    struct Header * header = (struct Header *) sht_info;
+    struct HtHeader * htheader = (struct HtHeader *) ht_info;
     int fd1 = header->info.fd;
     int fd2 = htheader->info.fd;
     int rows2 = htheader->info.records;
@@ -299,94 +412,149 @@ int SHT_SecondaryGetAllEntries(HT_info* ht_info, SHT_info* sht_info, char* value
 
     int block_num = header->head[bucket];
 
-    int * cache = (int *) malloc(sizeof (int)*(rows2+1));
+    SeenRecords * cache = seenRecords(header, rows2 + 1);
+    if (cache == NULL) {
+        sht_errors++;
+        return METHOD_ERROR_CODE;
+    }
+
+    /* Σε πρωτεύον αρχείο HT_LAYOUT_DICT η value μετατρέπεται μία φορά στον
+     * κωδικό της. Μια τιμή που δεν υπάρχει στο λεξικό έχει κωδικό -1, που
+     * δεν ταιριάζει με καμία εγγραφή. */
+    DC_info * dictionary = HT_Dictionary(ht_info);
+    Record_Attribute attribute = codedAttribute(header->info.record_attribute);
+    bool by_code = dictionary != NULL && attribute != ID;
+    int code = by_code ? DC_Lookup(dictionary, attribute, value) : -1;
+
+    BF_BlockHandle handle;
+    BF_Block *block = allocateMemoryBlock(&handle);
+
+    BF_BlockHandle primary_handles[SHT_BATCH];
+    BF_Block *primary_batch[SHT_BATCH];
+    SecondaryRecord *matched_records[SHT_BATCH];
+    int primary_nums[SHT_BATCH];
 
-    for (int i = 0; i < rows2 + 1; i++) {
-        cache[i] = 0;
+    for (int k = 0; k < SHT_BATCH; k++) {
+        primary_batch[k] = allocateMemoryBlock(&primary_handles[k]);
     }
 
     while (block_num != -1) {
         blocks++;
 
-        BF_Block *block = allocateMemoryBlock();
         CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
         char * data = BF_Block_GetData(block);
-        SHT_block_info * info = (SHT_block_info *) (data + BF_BLOCK_SIZE - sizeof (SHT_block_info));
+        SHT_block_info * info = blockInfo(header, data);
 
-        for (int j = 0; j < info->records; j++) {
-            SecondaryRecord * record = (SecondaryRecord *) (data + j * sizeof (SecondaryRecord));
+        /*
+         * Οι εγγραφές που ταιριάζουν μαζεύονται σε ομάδες, ώστε τα block του
+         * πρωτεύοντος ευρετηρίου που δείχνουν να φέρονται μαζί με την
+         * BF_GetBlocks.
+         */
+        for (int first = 0; first < info->records; first += SHT_BATCH) {
+            int last = (info->records - first < SHT_BATCH) ? info->records : first + SHT_BATCH;
+            int matched = 0;
 
-            bool matches = false;
+            for (int j = first; j < last; j++) {
+                SecondaryRecord * record = (SecondaryRecord *) (data + j * sizeof (SecondaryRecord));
 
-            if (strcmp(header->info.record_attribute, "record") == 0) {
-                if (strcmp(record->key, value) == 0) {
-                    matches = true;
-                }
-            } else if (strcmp(header->info.record_attribute, "name") == 0) {
-                if (strcmp(record->key, value) == 0) {
-                    matches = true;
-                }
-            } else if (strcmp(header->info.record_attribute, "surname") == 0) {
-                if (strcmp(record->key, value) == 0) {
-                    matches = true;
+                bool matches = false;
+
+                if (strcmp(header->info.record_attribute, "record") == 0) {
+                    if (strcmp(record->key, value) == 0) {
+                        matches = true;
+                    }
+                } else if (strcmp(header->info.record_attribute, "name") == 0) {
+                    if (strcmp(record->key, value) == 0) {
+                        matches = true;
+                    }
+                } else if (strcmp(header->info.record_attribute, "surname") == 0) {
+                    if (strcmp(record->key, value) == 0) {
+                        matches = true;
+                    }
+                } else if (strcmp(header->info.record_attribute, "city") == 0) {
+                    if (strcmp(record->key, value) == 0) {
+                        matches = true;
+                    }
+                } else {
+                    continue;
                 }
-            } else if (strcmp(header->info.record_attribute, "city") == 0) {
-                if (strcmp(record->key, value) == 0) {
-                    matches = true;
+
+                if (matches) {
+                    matched_records[matched] = record;
+                    primary_nums[matched] = record->block_id;
+                    matched++;
                 }
-            } else {
+            }
+
+            if (matched == 0) {
                 continue;
             }
 
-            if (matches) {
-                BF_Block *block = allocateMemoryBlock();
-                int blocknum = record->block_id;
+            CALL_BF(BF_GetBlocks(fd2, primary_nums, matched, primary_batch), true, METHOD_ERROR_CODE);
+
+            for (int m = 0; m < matched; m++) {
+                SecondaryRecord * record = matched_records[m];
                 printf("Match: (%s,%d) : ", record->key, record->block_id);
 
-                CALL_BF(BF_GetBlock(fd2, blocknum, block), true, METHOD_ERROR_CODE);
-                char * data = BF_Block_GetData(block);
-                HT_block_info * info = (HT_block_info *) (data + BF_BLOCK_SIZE - sizeof (HT_block_info));
+                char * data = BF_Block_GetData(primary_batch[m]);
+                HT_block_info * info = (HT_block_info *) (data + htheader->info.block_size - sizeof (HT_block_info));
 
                 bool matches = false;
                 
                 for (int j = 0; j < info->records; j++) {
-                    Record * record = (Record *) (data + j * sizeof (Record));
+                    Record copy;
+                    Record * record = NULL;
+                    int id;
 
-                    if (strcmp(header->info.record_attribute, "record") == 0) {
-                        if (strcmp(record->record, value) == 0) {
+                    if (by_code) {
+                        const DC_tuple * tuple = (const DC_tuple *) data + j;
+                        if (DC_Code(tuple, attribute) == code) {
                             matches = true;
                         }
-                    } else if (strcmp(header->info.record_attribute, "name") == 0) {
-                        if (strcmp(record->name, value) == 0) {
-                            matches = true;
-                        }
-                    } else if (strcmp(header->info.record_attribute, "surname") == 0) {
-                        if (strcmp(record->surname, value) == 0) {
-                            matches = true;
-                        }
-                    } else if (strcmp(header->info.record_attribute, "city") == 0) {
-                        if (strcmp(record->city, value) == 0) {
-                            matches = true;
+                        id = tuple->id;
+                    } else {
+                        record = primaryRecord(htheader, data, j, &copy);
+                        id = record->id;
+
+                        if (strcmp(header->info.record_attribute, "record") == 0) {
+                            if (strcmp(record->record, value) == 0) {
+                                matches = true;
+                            }
+                        } else if (strcmp(header->info.record_attribute, "name") == 0) {
+                            if (strcmp(record->name, value) == 0) {
+                                matches = true;
+                            }
+                        } else if (strcmp(header->info.record_attribute, "surname") == 0) {
+                            if (strcmp(record->surname, value) == 0) {
+                                matches = true;
+                            }
+                        } else if (strcmp(header->info.record_attribute, "city") == 0) {
+                            if (strcmp(record->city, value) == 0) {
+                                matches = true;
+                            }
                         }
                     }
                     
-                    if (matches && cache[record->id] == 0) {
-                        cache[record->id] = 1;
+                    /* Η εγγραφή ανασυντίθεται μόνο για να τυπωθεί. */
+                    if (matches && cache->seen[id] != cache->epoch) {
+                        cache->seen[id] = cache->epoch;
+                        if (record == NULL) {
+                            record = primaryRecord(htheader, data, j, &copy);
+                        }
                         printRecord(*record);
                         break;
                     }                    
                 }
                 
-                CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+                CALL_BF(dumpBlock(primary_batch[m]), true, METHOD_ERROR_CODE);
             }
         }
 
         block_num = info->next_block;
 
-        CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+        CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
     }
 
-    free(cache);
     return blocks;
 }
 
@@ -394,7 +562,7 @@ int SHT_SecondaryGetAllEntries(HT_info* ht_info, SHT_info* sht_info, char* value
 int SHT_HashStatistics(char * filename) {
     const int METHOD_ERROR_CODE = SHT_ERROR;
     SHT_info* sht_info = SHT_OpenSecondaryIndex(filename);
-    union Header * header = (union Header *) sht_info;
+    struct Header * header = (struct Header *) sht_info;
     int fd1 = header->info.fd;
     int blocks = 0;
 
@@ -409,13 +577,15 @@ int SHT_HashStatistics(char * filename) {
         int min = INT_MAX, max = 0, sum = 0;
         int bucket_blocks = 0;
 
+        BF_BlockHandle handle;
+        BF_Block *block = allocateMemoryBlock(&handle);
+
         while (block_num != -1) {
             bucket_blocks++;
 
-            BF_Block *block = allocateMemoryBlock();
             CALL_BF(BF_GetBlock(fd1, block_num, block), true, METHOD_ERROR_CODE);
             char * data = BF_Block_GetData(block);
-            SHT_block_info * info = (SHT_block_info *) (data + BF_BLOCK_SIZE - sizeof (SHT_block_info));
+            SHT_block_info * info = blockInfo(header, data);
 
             if (info->records < min) {
                 min = info->records;
@@ -429,7 +599,7 @@ int SHT_HashStatistics(char * filename) {
 
             block_num = info->next_block;
 
-            CALL_BF(dumpBlock(&block, true), true, METHOD_ERROR_CODE);
+            CALL_BF(dumpBlock(block), true, METHOD_ERROR_CODE);
         }
 
         float avg = (float) sum / bucket_blocks;
@@ -460,6 +630,16 @@ int SHT_HashStatistics(char * filename) {
     printf("Avg blocks  per bucket     : %.2f \n", bucket_block_sum / (float) header->info.buckets);
     printf("Total buckets with overflow: %d \n", overflow_buckets);
 
+    BF_Stats stats;
+
+    CALL_BF(BF_GetStats(fd1, &stats), true, METHOD_ERROR_CODE);
+    printf("Buffer pool, statistics scan: \n");
+    BF_PrintStats(&stats);
+
+    CALL_BF(BF_GetGlobalStats(&stats), true, METHOD_ERROR_CODE);
+    printf("Buffer pool, all files since BF_Init: \n");
+    BF_PrintStats(&stats);
+
     SHT_CloseSecondaryIndex(sht_info);
 
     return 0;
@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include "slotted_page.h"
+#include "record.h"
+
+static SP_slot * slotAt(char * data, int space, int slot) {
+    return (SP_slot *) (data + space) - (slot + 1);
+}
+
+static const SP_slot * constSlotAt(const char * data, int space, int slot) {
+    return (const SP_slot *) (data + space) - (slot + 1);
+}
+
+/* Γράφει το πεδίο field μεγέθους size ως μήκος και χαρακτήρες. */
+static char * putField(char * out, const char * field, size_t size) {
+    size_t length = strnlen(field, size);
+    *out++ = (char) length;
+    memcpy(out, field, length);
+    return out + length;
+}
+
+static const char * getField(const char * in, char * field) {
+    size_t length = (unsigned char) *in++;
+    memcpy(field, in, length);
+    return in + length;
+}
+
+int SP_Append(char *data, int space, int count, const Record *record) {
+    int start = 0;
+    if (count > 0) {
+        const SP_slot * last = constSlotAt(data, space, count - 1);
+        start = last->offset + last->length;
+    }
+
+    int length = sizeof(int) + 4
+            + strnlen(record->record, sizeof(record->record))
+            + strnlen(record->name, sizeof(record->name))
+            + strnlen(record->surname, sizeof(record->surname))
+            + strnlen(record->city, sizeof(record->city));
+    int directory = (count + 1) * sizeof(SP_slot);
+    if (start + length > space - directory) {
+        return -1;
+    }
+
+    char * out = data + start;
+    memcpy(out, &record->id, sizeof(int));
+    out += sizeof(int);
+    out = putField(out, record->record, sizeof(record->record));
+    out = putField(out, record->name, sizeof(record->name));
+    out = putField(out, record->surname, sizeof(record->surname));
+    putField(out, record->city, sizeof(record->city));
+
+    SP_slot * slot = slotAt(data, space, count);
+    slot->offset = (unsigned short) start;
+    slot->length = (unsigned short) length;
+    return 0;
+}
+
+void SP_Get(const char *data, int space, int slot, Record *record) {
+    const char * in = data + constSlotAt(data, space, slot)->offset;
+
+    memset(record, 0, sizeof(Record));
+    memcpy(&record->id, in, sizeof(int));
+    in += sizeof(int);
+    in = getField(in, record->record);
+    in = getField(in, record->name);
+    in = getField(in, record->surname);
+    getField(in, record->city);
+}
+
+int SP_Id(const char *data, int space, int slot) {
+    int id;
+    memcpy(&id, data + constSlotAt(data, space, slot)->offset, sizeof(int));
+    return id;
+}